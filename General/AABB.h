@@ -74,40 +74,16 @@ public:
 		return *this;
 	}
 
+	// Arvo's method (center by matrix, extents by abs(matrix)) instead of xforming 8 corners, matrix assumed to be affine
 	AABB &xform(const mat4 &matrix) throw()
 	{
-		// create box vertices
-		vec3 box[8] =
-		{
-			vec3(_min.x, _min.y, _min.z),
-			vec3(_min.x, _min.y, _max.z),
-			vec3(_min.x, _max.y, _min.z),
-			vec3(_min.x, _max.y, _max.z),
-			vec3(_max.x, _min.y, _min.z),
-			vec3(_max.x, _min.y, _max.z),
-			vec3(_max.x, _max.y, _min.z),
-			vec3(_max.x, _max.y, _max.z)
-		};
-
-		// xform
-		class CXformer
-		{
-		public:
-			CXformer(const mat4 &matrix) : _matrix(matrix) {}
-			void operator ()(vec3 &vertex)
-			{
-				vec3 xformed_vertex;
-				mult_pos(xformed_vertex, _matrix, vertex);
-				vertex = xformed_vertex;
-			}
-		private:
-			const mat4 &_matrix;
-		};
-		std::for_each(box, box + _countof(box), CXformer(matrix));
-
-		// build aabb for xformed box
-		this->~AABB(); // currently nop
-		new(this) AABB(box, box + _countof(box));
+		const vec3 center = this->center(), extents = this->extents();
+		vec3 xformed_center, xformed_extents;
+		mult_pos(xformed_center, matrix, center);
+		for (int i = 0; i < 3; i++)
+			xformed_extents[i] = fabs(matrix(i, 0)) * extents.x + fabs(matrix(i, 1)) * extents.y + fabs(matrix(i, 2)) * extents.z;
+		_min = xformed_center - xformed_extents;
+		_max = xformed_center + xformed_extents;
 
 		return *this;
 	}
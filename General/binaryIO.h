@@ -2,6 +2,30 @@
 
 #include <ostream>
 #include <type_traits>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+
+/*
+	versioned header: magic (e.g. 4CC) followed by format version
+	readers accept version range so that format can evolve while old caches/assets still loadable (or rejected early)
+*/
+struct CBinaryHeader
+{
+	uint32_t magic, version;
+};
+
+namespace BinaryIOImpl
+{
+	template<typename T>
+	constexpr bool isSpan = false;
+
+	template<typename T, std::size_t Extent>
+	constexpr bool isSpan<std::span<T, Extent>> = true;
+}
 
 class CBinaryOstream
 {
@@ -14,11 +38,112 @@ public:
 		return _out;
 	}
 public:
-	template<typename T>
+	// spans excluded - writing them as is would store pointer and size instead of elements
+	template<typename T> requires (!BinaryIOImpl::isSpan<T>)
 	CBinaryOstream &operator <<(const T &data)
 	{
 		static_assert(std::is_standard_layout_v<T>, "try to write non-standard layout data");
 		_out.write((const char *)&data, sizeof data);
 		return *this;
 	}
+	template<typename T, std::size_t Extent>
+	CBinaryOstream &operator <<(std::span<T, Extent> data)
+	{
+		static_assert(std::is_standard_layout_v<T>, "try to write non-standard layout data");
+		_out.write((const char *)data.data(), data.size_bytes());
+		return *this;
+	}
+	CBinaryOstream &WriteHeader(uint32_t magic, uint32_t version)
+	{
+		return *this << CBinaryHeader{ magic, version };
+	}
+	// zero padding up to 'alignment' relative to stream beginning, use before arrays to be viewed by 'CBinaryIstream::View()'
+	CBinaryOstream &Align(std::size_t alignment)
+	{
+		static constexpr char zeros[64]{};
+		const auto pos = _out.tellp();
+		if (pos == std::ostream::pos_type(-1))
+			throw std::runtime_error("Binary stream position unavailable for alignment.");
+		for (auto padding = (alignment - std::size_t(pos) % alignment) % alignment; padding; padding -= std::min(padding, sizeof zeros))
+			_out.write(zeros, std::min(padding, sizeof zeros));
+		return *this;
+	}
+};
+
+/*
+	reads from memory (buffer or memory mapped file), all reads are bounds checked and throw on overrun
+	'View()' provides zero-copy access to arrays of trivially copyable types, data should be aligned (see 'Align()') - buffer beginning is assumed to be aligned enough (true for mapped files)
+*/
+class CBinaryIstream
+{
+	const std::byte *const _begin, *const _end, *_cur;
+public:
+	CBinaryIstream(const void *data, std::size_t size) noexcept : _begin(static_cast<const std::byte *>(data)), _end(_begin + size), _cur(_begin) {}
+	explicit CBinaryIstream(std::span<const std::byte> data) noexcept : CBinaryIstream(data.data(), data.size()) {}
+public:
+	std::size_t Tell() const noexcept { return _cur - _begin; }
+	std::size_t Remaining() const noexcept { return _end - _cur; }
+	bool Eof() const noexcept { return _cur == _end; }
+	CBinaryIstream &Seek(std::size_t offset)
+	{
+		if (offset > std::size_t(_end - _begin))
+			throw std::out_of_range("Binary stream seek past end.");
+		_cur = _begin + offset;
+		return *this;
+	}
+	CBinaryIstream &Skip(std::size_t size)
+	{
+		Consume(size);
+		return *this;
+	}
+	// skips padding written by 'CBinaryOstream::Align()'
+	CBinaryIstream &Align(std::size_t alignment)
+	{
+		return Skip((alignment - Tell() % alignment) % alignment);
+	}
+public:
+	template<typename T>
+	CBinaryIstream &operator >>(T &data)
+	{
+		static_assert(std::is_trivially_copyable_v<T>, "try to read non-trivially copyable data");
+		std::memcpy(&data, Consume(sizeof data), sizeof data);	// no alignment requirement
+		return *this;
+	}
+	template<typename T>
+	T Read()
+	{
+		T data;
+		*this >> data;
+		return data;
+	}
+	template<typename T>
+	std::span<const T> View(std::size_t count)
+	{
+		static_assert(std::is_trivially_copyable_v<T>, "try to view non-trivially copyable data");
+		if (count > Remaining() / sizeof(T))
+			throw std::out_of_range("Binary stream read past end.");
+		if (reinterpret_cast<std::uintptr_t>(_cur) % alignof(T))
+			throw std::runtime_error("Misaligned binary stream view.");
+		return { reinterpret_cast<const T *>(Consume(count * sizeof(T))), count };
+	}
+	// returns version, throws if magic mismatches or version is out of supported range
+	uint32_t ReadHeader(uint32_t magic, uint32_t minVersion, uint32_t maxVersion)
+	{
+		const auto header = Read<CBinaryHeader>();
+		if (header.magic != magic)
+			throw std::runtime_error("Binary stream header magic mismatch.");
+		if (header.version < minVersion || header.version > maxVersion)
+			throw std::runtime_error("Unsupported binary stream version.");
+		return header.version;
+	}
+private:
+	// returns position before advancing
+	const std::byte *Consume(std::size_t size)
+	{
+		if (size > Remaining())
+			throw std::out_of_range("Binary stream read past end.");
+		const auto result = _cur;
+		_cur += size;
+		return result;
+	}
 };
\ No newline at end of file
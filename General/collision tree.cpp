@@ -0,0 +1,218 @@
+#include "collision tree.h"
+#include "AABB.h"
+#include <algorithm>
+#include <iterator>
+#include <unordered_map>
+#include <cassert>
+
+using namespace std;
+namespace Collision = Math::Collision;
+
+template<unsigned int packetWidth>
+template<typename IB_format>
+class Collision::CCollisionTree<packetWidth>::CBuilder
+{
+	struct TTriRef
+	{
+		AABB aabb;
+		vec3 centroid;
+		uint32_t idx;
+	};
+	typedef typename vector<TTriRef>::iterator TTriRefIterator;
+
+	CCollisionTree &_tree;
+	const vec3 *const __restrict _VB;
+	const IB_format (*const _tris)[3];
+	const unsigned int _maxLeafTris;
+	vector<TTriRef> _refs;
+	unordered_map<uint64_t, bool> _edges;	// sorted vertex pair -> claimed
+	vector<bool> _vertsClaimed;
+
+public:
+	CBuilder(CCollisionTree &tree, const vec3 *__restrict VB, const IB_format (*tris)[3], size_t triCount, const CCollisionEdges<IB_format> &edges, unsigned int maxLeafTris);
+
+public:
+	void Build() { Build(_refs.begin(), _refs.end()); }
+
+private:
+	static uint64_t EdgeKey(IB_format v0, IB_format v1) noexcept { return uint64_t(min(v0, v1)) << 32 | max(v0, v1); }
+	uint32_t Build(TTriRefIterator begin, TTriRefIterator end);
+	uint32_t EmitLeaf(TTriRefIterator begin, TTriRefIterator end);
+};
+
+template<unsigned int packetWidth>
+template<typename IB_format>
+Collision::CCollisionTree<packetWidth>::CBuilder<IB_format>::CBuilder(CCollisionTree &tree, const vec3 *__restrict VB, const IB_format (*tris)[3], size_t triCount, const CCollisionEdges<IB_format> &edges, unsigned int maxLeafTris) :
+	_tree(tree), _VB(VB), _tris(tris), _maxLeafTris(max(maxLeafTris, 1u))
+{
+	IB_format maxIdx = 0;
+	_refs.reserve(triCount);
+	for (uint32_t idx = 0; idx < triCount; idx++)
+	{
+		const IB_format (&tri)[3] = tris[idx];
+		const vec3 verts[] = { VB[tri[0]], VB[tri[1]], VB[tri[2]] };
+		_refs.push_back({ AABB(begin(verts), end(verts)), nv_one / nv_scalar(3) * (verts[0] + verts[1] + verts[2]), idx });
+		maxIdx = max({ maxIdx, tri[0], tri[1], tri[2] });
+	}
+	_vertsClaimed.resize(size_t(maxIdx) + 1);
+
+	for_each(edges.Begin(), edges.End(), [this](const typename CCollisionEdges<IB_format>::TEdge &edge)
+	{
+		_edges.emplace(EdgeKey(edge.v0, edge.v1), false);
+	});
+}
+
+// median split along largest centroid spread, returns node idx
+template<unsigned int packetWidth>
+template<typename IB_format>
+uint32_t Collision::CCollisionTree<packetWidth>::CBuilder<IB_format>::Build(TTriRefIterator begin, TTriRefIterator end)
+{
+	AABB bounds, centroidBounds;
+	for_each(begin, end, [&](const TTriRef &ref)
+	{
+		bounds.Refit(ref.aabb);
+		centroidBounds.Refit(AABB(ref.centroid, ref.centroid));
+	});
+
+	const uint32_t nodeIdx = _tree._nodes.size();
+	_tree._nodes.push_back({ bounds.center(), bounds.extents() });
+
+	const vec3 spread = centroidBounds.size();
+	const unsigned int splitAxis = spread.x >= spread.y ? spread.x >= spread.z ? 0 : 2 : spread.y >= spread.z ? 1 : 2;
+	if (unsigned(end - begin) <= _maxLeafTris || spread[splitAxis] == nv_zero)
+	{
+		const uint32_t leafIdx = EmitLeaf(begin, end);
+		auto &node = _tree._nodes[nodeIdx];
+		node.leaf = true;
+		node.payload = leafIdx;
+	}
+	else
+	{
+		const auto middle = begin + (end - begin) / 2;
+		nth_element(begin, middle, end, [splitAxis](const TTriRef &left, const TTriRef &right)
+		{
+			return left.centroid[splitAxis] < right.centroid[splitAxis];
+		});
+		Build(begin, middle);
+		const uint32_t rightIdx = Build(middle, end);
+		auto &node = _tree._nodes[nodeIdx];
+		node.splitAxis = splitAxis;
+		node.payload = rightIdx;
+	}
+
+	return nodeIdx;
+}
+
+// packs tris and claims their not yet claimed convex edges and vertices, returns leaf idx
+template<unsigned int packetWidth>
+template<typename IB_format>
+uint32_t Collision::CCollisionTree<packetWidth>::CBuilder<IB_format>::EmitLeaf(TTriRefIterator begin, TTriRefIterator end)
+{
+	TLeaf leaf;
+	leaf.packetsBegin = _tree._packets.size();
+	leaf.edgesBegin = _tree._edges.size();
+	leaf.vertsBegin = _tree._verts.size();
+
+	unsigned int lane = packetWidth;
+	for_each(begin, end, [&](const TTriRef &ref)
+	{
+		const IB_format (&tri)[3] = _tris[ref.idx];
+
+		if (lane == packetWidth)
+		{
+			_tree._packets.emplace_back();	// zero-filled
+			lane = 0;
+		}
+		// degenerate tri does not occupy lane but its edges and vertices still get collided
+		if (_tree._packets.back().Set(lane, _VB[tri[0]], _VB[tri[1]], _VB[tri[2]]))
+			lane++;
+
+		for (unsigned int v0 = 2, v1 = 0; v1 < 3; v0 = v1++)
+		{
+			const auto edge = _edges.find(EdgeKey(tri[v0], tri[v1]));
+			if (edge != _edges.end() && !edge->second)
+			{
+				edge->second = true;
+				_tree._edges.push_back({ _VB[tri[v0]], _VB[tri[v1]] });
+			}
+
+			if (!_vertsClaimed[tri[v1]])
+			{
+				_vertsClaimed[tri[v1]] = true;
+				_tree._verts.push_back(_VB[tri[v1]]);
+			}
+		}
+	});
+
+	// drop trailing empty packet
+	if (lane == 0)
+		_tree._packets.pop_back();
+
+	leaf.packetsEnd = _tree._packets.size();
+	leaf.edgesEnd = _tree._edges.size();
+	leaf.vertsEnd = _tree._verts.size();
+	_tree._leafs.push_back(leaf);
+	return _tree._leafs.size() - 1;
+}
+
+template<unsigned int packetWidth>
+template<typename IB_format>
+Collision::CCollisionTree<packetWidth>::CCollisionTree(const vec3 *__restrict VB, const IB_format (*tris)[3], size_t triCount, const CCollisionEdges<IB_format> &edges, unsigned int maxLeafTris)
+{
+	if (!triCount)
+		return;
+
+	CBuilder<IB_format>(*this, VB, tris, triCount, edges, maxLeafTris).Build();
+
+	_nodes.shrink_to_fit();
+	_leafs.shrink_to_fit();
+	_packets.shrink_to_fit();
+	_edges.shrink_to_fit();
+	_verts.shrink_to_fit();
+}
+
+template<unsigned int packetWidth>
+void Collision::CCollisionTree<packetWidth>::operator ()(CTriCollider &triHandler, CEdgeCollider &edgeHandler, CVertexCollider &vertexHandler, const CCuller &culler, CSphereXformHandler &xformHandler) const
+{
+	if (_nodes.empty())
+		return;
+
+	const CSphereXformHandler::TMovingSphere &xformed_sphere = xformHandler;
+
+	// median split tree depth is bounded by log2 of tri count
+	uint32_t stack[64], stackSize = 0;
+	stack[stackSize++] = 0;
+	do
+	{
+		const TNode &node = _nodes[stack[--stackSize]];
+
+		// culler tracks closest collision found so far
+		if (culler(xformHandler, node.center, node.extents))
+			continue;
+
+		if (node.leaf)
+		{
+			const TLeaf &leaf = _leafs[node.payload];
+			for_each(_packets.data() + leaf.packetsBegin, _packets.data() + leaf.packetsEnd, [&](const TTriPacket<packetWidth> &tris) { triHandler(xformHandler, tris); });
+			for_each(_edges.data() + leaf.edgesBegin, _edges.data() + leaf.edgesEnd, [&](const TEdge &edge) { edgeHandler(xformHandler, edge.v0, edge.v1); });
+			for_each(_verts.data() + leaf.vertsBegin, _verts.data() + leaf.vertsEnd, [&](const vec3 &vert) { vertexHandler(xformHandler, vert); });
+		}
+		else
+		{
+			assert(stackSize + 2 <= size(stack));
+
+			// visit near child first so that collision found there tightens culling of far one
+			const uint32_t left = &node - _nodes.data() + 1, right = node.payload;
+			const bool leftNear = xformed_sphere.dir[node.splitAxis] >= nv_zero;
+			stack[stackSize++] = leftNear ? right : left;
+			stack[stackSize++] = leftNear ? left : right;
+		}
+	} while (stackSize);
+}
+
+template Collision::CCollisionTree<4>;
+template Collision::CCollisionTree<8>;
+template Collision::CCollisionTree<4>::CCollisionTree(const vec3 *__restrict VB, const uint16_t (*tris)[3], size_t triCount, const CCollisionEdges<uint16_t> &edges, unsigned int maxLeafTris);
+template Collision::CCollisionTree<4>::CCollisionTree(const vec3 *__restrict VB, const uint32_t (*tris)[3], size_t triCount, const CCollisionEdges<uint32_t> &edges, unsigned int maxLeafTris);
+template Collision::CCollisionTree<8>::CCollisionTree(const vec3 *__restrict VB, const uint16_t (*tris)[3], size_t triCount, const CCollisionEdges<uint16_t> &edges, unsigned int maxLeafTris);
+template Collision::CCollisionTree<8>::CCollisionTree(const vec3 *__restrict VB, const uint32_t (*tris)[3], size_t triCount, const CCollisionEdges<uint32_t> &edges, unsigned int maxLeafTris);
\ No newline at end of file
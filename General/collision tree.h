@@ -0,0 +1,51 @@
+#pragma once
+
+#include "CompilerCheck.h"
+#include "collision.h"
+#include <vector>
+#include <cstdint>
+
+namespace Math::Collision
+{
+	// AABB tree over static tris
+	// feeds colliders only with geometry from nodes surviving swept sphere culling, tris are collided in SIMD packets
+	template<unsigned int packetWidth = 8>
+	class CCollisionTree final : public IGeometryProvider
+	{
+		struct TNode
+		{
+			vec3 center, extents;
+			uint32_t leaf : 1, splitAxis : 2, payload : 29;	// leaf idx for leaf node, right child idx for inner node (left child follows it immediately)
+		};
+
+		struct TLeaf
+		{
+			uint32_t packetsBegin, packetsEnd, edgesBegin, edgesEnd, vertsBegin, vertsEnd;
+		};
+
+		struct TEdge
+		{
+			vec3 v0, v1;
+		};
+
+	private:
+		std::vector<TNode> _nodes;
+		std::vector<TLeaf> _leafs;
+		std::vector<TTriPacket<packetWidth>> _packets;
+		std::vector<TEdge> _edges;
+		std::vector<vec3> _verts;
+
+	public:
+		CCollisionTree() noexcept = default;
+		// 'edges' should be built for the same tris, each edge and vertex gets attached to 1st leaf referencing it
+		template<typename IB_format>
+		CCollisionTree(const vec3 *__restrict VB, const IB_format (*tris)[3], size_t triCount, const CCollisionEdges<IB_format> &edges, unsigned int maxLeafTris = packetWidth * 2);
+
+	public:
+		void operator ()(CTriCollider &triHandler, CEdgeCollider &edgeHandler, CVertexCollider &vertexHandler, const CCuller &culler, CSphereXformHandler &xformHandler) const override;
+
+	private:
+		template<typename IB_format>
+		class CBuilder;
+	};
+}
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include "collision.h"
+#include "SIMD.h"
 #include <algorithm>
 #include <iterator>
 #include <set>
@@ -8,6 +9,7 @@
 #include <cfenv>
 #include <cstring>	// for memcpy
 #include <cassert>
+#include <immintrin.h>
 
 using namespace std;
 #if INCLUDE_DGLE_EXTENSIONS
@@ -329,6 +331,556 @@ extern nv_scalar Collision::RayCilinderIntersect(vec3 R0, const vec3 &R0R1, cons
 	return dist;
 }
 
+#pragma region SIMD
+template<unsigned int width>
+bool Collision::TTriPacket<width>::Set(unsigned int lane, const vec3 &v0, const vec3 &v1, const vec3 &v2) noexcept
+{
+	assert(lane < width);
+
+	// compute tri edges
+	const vec3
+		e1 = v1 - v0,
+		e2 = v2 - v0;
+
+	// compute tri normal
+	vec3 n;
+	if (cross(n, e1, e2).sq_norm() == nv_zero)
+		return false;
+	n.normalize();
+
+	// bake PointInsideTri() math
+	nv_scalar e1_dot_e1, e1_dot_e2, e2_dot_e2;
+	dot(e1_dot_e1, e1, e1);
+	dot(e1_dot_e2, e1, e2);
+	dot(e2_dot_e2, e2, e2);
+	const nv_scalar D_inv = nv_one / (e1_dot_e1 * e2_dot_e2 - e1_dot_e2 * e1_dot_e2);
+	const vec3
+		bary1 = D_inv * (e2_dot_e2 * e1 - e1_dot_e2 * e2),
+		bary2 = D_inv * (e1_dot_e1 * e2 - e1_dot_e2 * e1);
+
+	for (unsigned i = 0; i < 3; i++)
+	{
+		TTriPacket::v0[i][lane] = v0[i];
+		TTriPacket::n[i][lane] = n[i];
+		TTriPacket::bary1[i][lane] = bary1[i];
+		TTriPacket::bary2[i][lane] = bary2[i];
+	}
+
+	return true;
+}
+
+template Collision::TTriPacket<4>;
+template Collision::TTriPacket<8>;
+
+namespace
+{
+	template<unsigned int width>
+	struct SIMDLanes;
+
+	template<>
+	struct SIMDLanes<4>
+	{
+		typedef Math::SIMD::XMM Reg;
+
+		static inline Reg Load(const nv_scalar src[4]) noexcept { return _mm_load_ps(src); }
+		static inline void __vectorcall Store(nv_scalar dst[4], Reg src) noexcept { _mm_storeu_ps(dst, src); }
+		static inline Reg __vectorcall EQ(Reg left, Reg right) noexcept { return _mm_cmpeq_ps(left, right); }
+		static inline Reg __vectorcall NE(Reg left, Reg right) noexcept { return _mm_cmpneq_ps(left, right); }
+		static inline Reg __vectorcall GE(Reg left, Reg right) noexcept { return _mm_cmpge_ps(left, right); }
+		static inline Reg __vectorcall GT(Reg left, Reg right) noexcept { return _mm_cmpgt_ps(left, right); }
+		static inline Reg __vectorcall LE(Reg left, Reg right) noexcept { return _mm_cmple_ps(left, right); }
+		static inline Reg __vectorcall LT(Reg left, Reg right) noexcept { return _mm_cmplt_ps(left, right); }
+		static inline Reg __vectorcall And(Reg left, Reg right) noexcept { return _mm_and_ps(left, right); }
+		static inline Reg __vectorcall Or(Reg left, Reg right) noexcept { return _mm_or_ps(left, right); }
+		static inline Reg __vectorcall Select(Reg mask, Reg left, Reg right) noexcept { return _mm_or_ps(_mm_and_ps(mask, left), _mm_andnot_ps(mask, right)); }
+		static inline Reg __vectorcall Min(Reg left, Reg right) noexcept { return _mm_min_ps(left, right); }
+		static inline Reg __vectorcall Max(Reg left, Reg right) noexcept { return _mm_max_ps(left, right); }
+		static inline Reg __vectorcall Sqrt(Reg src) noexcept { return _mm_sqrt_ps(src); }
+		static inline unsigned int __vectorcall Mask(Reg src) noexcept { return _mm_movemask_ps(src); }
+
+		// returns first lane holding minimum
+		static inline unsigned int __vectorcall FirstMin(Reg src, nv_scalar &min) noexcept
+		{
+			__m128 reduced = _mm_min_ps(src, _mm_shuffle_ps(src, src, _MM_SHUFFLE(1, 0, 3, 2)));
+			reduced = _mm_min_ps(reduced, _mm_shuffle_ps(reduced, reduced, _MM_SHUFFLE(2, 3, 0, 1)));
+			min = _mm_cvtss_f32(reduced);
+			unsigned long lane;
+			_BitScanForward(&lane, _mm_movemask_ps(_mm_cmpeq_ps(src, reduced)) | 1 << 4);
+			return lane;
+		}
+	};
+
+	template<>
+	struct SIMDLanes<8>
+	{
+		typedef Math::SIMD::YMM Reg;
+
+		static inline Reg Load(const nv_scalar src[8]) noexcept { return _mm256_load_ps(src); }
+		static inline void __vectorcall Store(nv_scalar dst[8], Reg src) noexcept { _mm256_storeu_ps(dst, src); }
+		static inline Reg __vectorcall EQ(Reg left, Reg right) noexcept { return _mm256_cmp_ps(left, right, _CMP_EQ_OQ); }
+		static inline Reg __vectorcall NE(Reg left, Reg right) noexcept { return _mm256_cmp_ps(left, right, _CMP_NEQ_OQ); }
+		static inline Reg __vectorcall GE(Reg left, Reg right) noexcept { return _mm256_cmp_ps(left, right, _CMP_GE_OQ); }
+		static inline Reg __vectorcall GT(Reg left, Reg right) noexcept { return _mm256_cmp_ps(left, right, _CMP_GT_OQ); }
+		static inline Reg __vectorcall LE(Reg left, Reg right) noexcept { return _mm256_cmp_ps(left, right, _CMP_LE_OQ); }
+		static inline Reg __vectorcall LT(Reg left, Reg right) noexcept { return _mm256_cmp_ps(left, right, _CMP_LT_OQ); }
+		static inline Reg __vectorcall And(Reg left, Reg right) noexcept { return _mm256_and_ps(left, right); }
+		static inline Reg __vectorcall Or(Reg left, Reg right) noexcept { return _mm256_or_ps(left, right); }
+		static inline Reg __vectorcall Select(Reg mask, Reg left, Reg right) noexcept { return _mm256_blendv_ps(right, left, mask); }
+		static inline Reg __vectorcall Min(Reg left, Reg right) noexcept { return _mm256_min_ps(left, right); }
+		static inline Reg __vectorcall Max(Reg left, Reg right) noexcept { return _mm256_max_ps(left, right); }
+		static inline Reg __vectorcall Sqrt(Reg src) noexcept { return _mm256_sqrt_ps(src); }
+		static inline unsigned int __vectorcall Mask(Reg src) noexcept { return _mm256_movemask_ps(src); }
+
+		// returns first lane holding minimum
+		static inline unsigned int __vectorcall FirstMin(Reg src, nv_scalar &min) noexcept
+		{
+			__m256 reduced = _mm256_min_ps(src, _mm256_permute2f128_ps(src, src, 0x01));
+			reduced = _mm256_min_ps(reduced, _mm256_shuffle_ps(reduced, reduced, _MM_SHUFFLE(1, 0, 3, 2)));
+			reduced = _mm256_min_ps(reduced, _mm256_shuffle_ps(reduced, reduced, _MM_SHUFFLE(2, 3, 0, 1)));
+			min = _mm_cvtss_f32(_mm256_castps256_ps128(reduced));
+			unsigned long lane;
+			_BitScanForward(&lane, _mm256_movemask_ps(_mm256_cmp_ps(src, reduced, _CMP_EQ_OQ)) | 1 << 8);
+			return lane;
+		}
+	};
+
+	template<unsigned int width>
+	class SIMDRays
+	{
+		typedef SIMDLanes<width> Lanes;
+		typedef typename Lanes::Reg Reg;
+
+	public:
+		Reg orig[3], dir[3];
+
+	public:
+		explicit SIMDRays(const Collision::TRayPacket<width> &rays) noexcept :
+			orig{ Lanes::Load(rays.orig[0]), Lanes::Load(rays.orig[1]), Lanes::Load(rays.orig[2]) },
+			dir{ Lanes::Load(rays.dir[0]), Lanes::Load(rays.dir[1]), Lanes::Load(rays.dir[2]) }
+		{}
+
+		// broadcast single ray
+		SIMDRays(const vec3 &rayOrig, const vec3 &rayDir) noexcept :
+			orig{ rayOrig.x, rayOrig.y, rayOrig.z },
+			dir{ rayDir.x, rayDir.y, rayDir.z }
+		{}
+	};
+
+	template<unsigned int width>
+	inline auto __vectorcall Dot(const typename SIMDLanes<width>::Reg (&left)[3], const typename SIMDLanes<width>::Reg (&right)[3]) noexcept
+	{
+		return left[0] * right[0] + left[1] * right[1] + left[2] * right[2];
+	}
+
+	template<unsigned int width>
+	inline auto __vectorcall Dot(const typename SIMDLanes<width>::Reg (&left)[3], const vec3 &right) noexcept
+	{
+		return left[0] * right.x + left[1] * right.y + left[2] * right.z;
+	}
+
+	template<unsigned int width>
+	inline unsigned int LaneMask(unsigned int activeMask) noexcept
+	{
+		return activeMask & (1u << width) - 1u;
+	}
+
+	// writes NaN for missed lanes
+	template<unsigned int width>
+	unsigned int __vectorcall StoreHits(nv_scalar (&dst)[width], typename SIMDLanes<width>::Reg dist, typename SIMDLanes<width>::Reg hit, unsigned int activeMask) noexcept
+	{
+		typedef SIMDLanes<width> Lanes;
+		const unsigned int hitMask = Lanes::Mask(hit) & activeMask;
+		Lanes::Store(dst, dist);
+		for (unsigned lane = 0; lane < width; lane++)
+			if (!(hitMask & 1u << lane))
+				dst[lane] = numeric_limits<nv_scalar>::quiet_NaN();
+		return hitMask;
+	}
+
+	template<unsigned int width>
+	unsigned int StoreMiss(nv_scalar (&dst)[width]) noexcept
+	{
+		fill_n(dst, width, numeric_limits<nv_scalar>::quiet_NaN());
+		return 0;
+	}
+
+	// SIMD counterpart of TestPlane() for plane pair
+	// accumulates [fMax, bMin] range, returns mask of lanes still intersecting
+	template<unsigned int width>
+	auto __vectorcall TestSlab(typename SIMDLanes<width>::Reg dir_dot_n, typename SIMDLanes<width>::Reg orig_dot_n, typename SIMDLanes<width>::Reg planeDistPos, typename SIMDLanes<width>::Reg planeDistNeg,
+		typename SIMDLanes<width>::Reg &fMax, typename SIMDLanes<width>::Reg &bMin) noexcept
+	{
+		typedef SIMDLanes<width> Lanes;
+		typedef typename Lanes::Reg Reg;
+
+		const Reg
+			zero, inf = numeric_limits<nv_scalar>::infinity(),
+			parallel = Lanes::EQ(dir_dot_n, zero),
+			inside = Lanes::And(Lanes::LE(orig_dot_n, planeDistPos), Lanes::GE(orig_dot_n, -planeDistNeg)),
+			distPos = (planeDistPos - orig_dot_n) / dir_dot_n,
+			distNeg = (-planeDistNeg - orig_dot_n) / dir_dot_n;
+
+		// || plane either contains whole ray or rejects it
+		fMax = Lanes::Max(fMax, Lanes::Select(parallel, -inf, Lanes::Min(distPos, distNeg)));
+		bMin = Lanes::Min(bMin, Lanes::Select(parallel, inf, Lanes::Max(distPos, distNeg)));
+
+		return Lanes::And(Lanes::Or(inside, Lanes::NE(dir_dot_n, zero)), Lanes::And(Lanes::LE(fMax, bMin), Lanes::GE(bMin, zero)));
+	}
+
+	// returns dist, hit lanes in 'hit'
+	template<unsigned int width>
+	auto RayAABB(const SIMDRays<width> &rays, const typename SIMDLanes<width>::Reg (&center)[3], const typename SIMDLanes<width>::Reg (&extents)[3], unsigned int activeMask, typename SIMDLanes<width>::Reg &hit) noexcept
+	{
+		typedef SIMDLanes<width> Lanes;
+		typedef typename Lanes::Reg Reg;
+
+		const Reg inf = numeric_limits<nv_scalar>::infinity();
+		Reg fMax = -inf, bMin = inf;
+		hit = Lanes::EQ(fMax, fMax);
+		for (unsigned i = 0; i < 3; i++)
+		{
+			hit = Lanes::And(hit, TestSlab<width>(rays.dir[i], rays.orig[i], extents[i] + center[i], extents[i] - center[i], fMax, bMin));
+
+			// early out
+			if (!(Lanes::Mask(hit) & activeMask))
+				break;
+		}
+
+		return Lanes::Select(Lanes::GT(fMax, Reg()), fMax, bMin);
+	}
+
+	template<unsigned int width>
+	auto RayTri(const SIMDRays<width> &rays, const typename SIMDLanes<width>::Reg (&v0)[3], const typename SIMDLanes<width>::Reg (&n)[3],
+		const typename SIMDLanes<width>::Reg (&bary1)[3], const typename SIMDLanes<width>::Reg (&bary2)[3], typename SIMDLanes<width>::Reg &hit) noexcept
+	{
+		typedef SIMDLanes<width> Lanes;
+		typedef typename Lanes::Reg Reg;
+
+		const Reg
+			zero, one = nv_one,
+			orig_v0[3] = { rays.orig[0] - v0[0], rays.orig[1] - v0[1], rays.orig[2] - v0[2] },
+			dir_dot_n = Dot<width>(rays.dir, n),
+			dist = -Dot<width>(orig_v0, n) / dir_dot_n,
+			f[3] = { orig_v0[0] + dist * rays.dir[0], orig_v0[1] + dist * rays.dir[1], orig_v0[2] + dist * rays.dir[2] },
+			b1 = Dot<width>(bary1, f),
+			b2 = Dot<width>(bary2, f);
+
+		// zero normal (degenerate tri or zero-filled lane) rejected here too
+		hit = Lanes::And(Lanes::NE(dir_dot_n, zero), Lanes::And(Lanes::And(Lanes::GE(b1, zero), Lanes::GE(b2, zero)), Lanes::LE(b1 + b2, one)));
+		return dist;
+	}
+
+	template<unsigned int width>
+	auto RaySphere(const SIMDRays<width> &rays, const typename SIMDLanes<width>::Reg (&center)[3], typename SIMDLanes<width>::Reg r2, typename SIMDLanes<width>::Reg &hit) noexcept
+	{
+		typedef SIMDLanes<width> Lanes;
+		typedef typename Lanes::Reg Reg;
+
+		// move coord origin to sphere center
+		const Reg
+			zero,
+			S[3] = { rays.orig[0] - center[0], rays.orig[1] - center[1], rays.orig[2] - center[2] },
+			V_sq_norm = Dot<width>(rays.dir, rays.dir),
+			S_dot_V = Dot<width>(S, rays.dir),
+			D_div_4 = S_dot_V * S_dot_V - V_sq_norm * (Dot<width>(S, S) - r2);
+
+		hit = Lanes::And(Lanes::NE(V_sq_norm, zero), Lanes::GE(D_div_4, zero));
+		return (-S_dot_V - Lanes::Sqrt(D_div_4)) / V_sq_norm;
+	}
+
+	// builds tri in SIMD registers, returns false for degenerate tri
+	template<unsigned int width>
+	bool BroadcastTri(const vec3 &v0, const vec3 &v1, const vec3 &v2, typename SIMDLanes<width>::Reg (&v0_)[3], typename SIMDLanes<width>::Reg (&n)[3],
+		typename SIMDLanes<width>::Reg (&bary1)[3], typename SIMDLanes<width>::Reg (&bary2)[3]) noexcept
+	{
+		Collision::TTriPacket<width> tri;
+		if (!tri.Set(0, v0, v1, v2))
+			return false;
+		for (unsigned i = 0; i < 3; i++)
+		{
+			v0_[i] = tri.v0[i][0];
+			n[i] = tri.n[i][0];
+			bary1[i] = tri.bary1[i][0];
+			bary2[i] = tri.bary2[i][0];
+		}
+		return true;
+	}
+
+	// shared part of nearest queries
+	template<unsigned int width>
+	class NearestHits
+	{
+		typedef SIMDLanes<width> Lanes;
+		typedef typename Lanes::Reg Reg;
+
+		Collision::THitPacket<width> &hits;
+		const unsigned int activeMask;
+		Reg nearest = numeric_limits<nv_scalar>::infinity();
+
+	public:
+		NearestHits(Collision::THitPacket<width> &hits, unsigned int activeMask) noexcept : hits(hits), activeMask(LaneMask<width>(activeMask)) {}
+		NearestHits(NearestHits &) = delete;
+		void operator =(NearestHits &) = delete;
+
+		~NearestHits()
+		{
+			hits.mask = StoreHits(hits.dist, nearest, Lanes::LT(nearest, numeric_limits<nv_scalar>::infinity()), activeMask);
+		}
+
+	public:
+		unsigned int Active() const noexcept { return activeMask; }
+
+		void __vectorcall operator ()(Reg dist, Reg hit, uint32_t prim) noexcept
+		{
+			const Reg closer = Lanes::And(hit, Lanes::And(Lanes::GE(dist, Reg()), Lanes::LT(dist, nearest)));
+			nearest = Lanes::Select(closer, dist, nearest);
+			for (unsigned int closerMask = Lanes::Mask(closer) & activeMask; closerMask; closerMask &= closerMask - 1)
+			{
+				unsigned long lane;
+				_BitScanForward(&lane, closerMask);
+				hits.prim[lane] = prim;
+			}
+		}
+	};
+}
+
+template<unsigned int width>
+void Collision::TAABBPacket<width>::Set(unsigned int lane, const vec3 &center, const vec3 &extents) noexcept
+{
+	assert(lane < width);
+	for (unsigned i = 0; i < 3; i++)
+	{
+		TAABBPacket::center[i][lane] = center[i];
+		TAABBPacket::extents[i][lane] = extents[i];
+	}
+}
+
+template<unsigned int width>
+void Collision::TSpherePacket<width>::Set(unsigned int lane, const vec3 &center, nv_scalar radius2) noexcept
+{
+	assert(lane < width);
+	for (unsigned i = 0; i < 3; i++)
+		TSpherePacket::center[i][lane] = center[i];
+	TSpherePacket::radius2[lane] = radius2;
+}
+
+template<unsigned int width>
+void Collision::TRayPacket<width>::Set(unsigned int lane, const vec3 &orig, const vec3 &dir) noexcept
+{
+	assert(lane < width);
+	for (unsigned i = 0; i < 3; i++)
+	{
+		TRayPacket::orig[i][lane] = orig[i];
+		TRayPacket::dir[i][lane] = dir[i];
+	}
+}
+
+template Collision::TAABBPacket<4>;
+template Collision::TAABBPacket<8>;
+template Collision::TSpherePacket<4>;
+template Collision::TSpherePacket<8>;
+template Collision::TRayPacket<4>;
+template Collision::TRayPacket<8>;
+
+template<unsigned int width>
+extern unsigned int Collision::RayAABBIntersect(const TRayPacket<width> &rays, const vec3 &AABBCenter, const vec3 &AABBExtents, nv_scalar (&dist)[width], unsigned int activeMask) noexcept
+{
+	typedef typename SIMDLanes<width>::Reg Reg;
+	activeMask = LaneMask<width>(activeMask);
+	const Reg
+		center[3] = { AABBCenter.x, AABBCenter.y, AABBCenter.z },
+		extents[3] = { AABBExtents.x, AABBExtents.y, AABBExtents.z };
+	Reg hit;
+	const Reg result = RayAABB(SIMDRays<width>(rays), center, extents, activeMask, hit);
+	return StoreHits(dist, result, hit, activeMask);
+}
+
+template<unsigned int width, unsigned int k>
+extern unsigned int Collision::RayKDOPIntersect(const TRayPacket<width> &rays, const PlanePair(&planes)[k], nv_scalar (&dist)[2][width], unsigned int activeMask) noexcept
+{
+	typedef SIMDLanes<width> Lanes;
+	typedef typename Lanes::Reg Reg;
+
+	activeMask = LaneMask<width>(activeMask);
+	const SIMDRays<width> simdRays(rays);
+	const Reg inf = numeric_limits<nv_scalar>::infinity();
+	Reg fMax = -inf, bMin = inf, hit = Lanes::EQ(fMax, fMax);
+	for (unsigned i = 0; i < k; i++)
+	{
+		hit = Lanes::And(hit, TestSlab<width>(Dot<width>(simdRays.dir, planes[i].n), Dot<width>(simdRays.orig, planes[i].n), planes[i].dist[0], planes[i].dist[1], fMax, bMin));
+
+		// early out
+		if (!(Lanes::Mask(hit) & activeMask))
+		{
+			StoreMiss(dist[0]);
+			return StoreMiss(dist[1]);
+		}
+	}
+
+	StoreHits(dist[0], fMax, hit, activeMask);
+	return StoreHits(dist[1], bMin, hit, activeMask);
+}
+
+template<unsigned int width>
+extern unsigned int Collision::RayTriIntersect(const TRayPacket<width> &rays, const vec3 &v0, const vec3 &v1, const vec3 &v2, nv_scalar (&dist)[width], unsigned int activeMask) noexcept
+{
+	typedef typename SIMDLanes<width>::Reg Reg;
+	Reg v0_[3], n[3], bary1[3], bary2[3];
+	if (!BroadcastTri<width>(v0, v1, v2, v0_, n, bary1, bary2))
+		return StoreMiss(dist);
+	Reg hit;
+	const Reg result = RayTri(SIMDRays<width>(rays), v0_, n, bary1, bary2, hit);
+	return StoreHits(dist, result, hit, LaneMask<width>(activeMask));
+}
+
+template<unsigned int width>
+extern unsigned int Collision::RaySphereIntersect(const TRayPacket<width> &rays, const vec3 &sphereCenter, nv_scalar sphereRadius2, nv_scalar (&dist)[width], unsigned int activeMask) noexcept
+{
+	typedef typename SIMDLanes<width>::Reg Reg;
+	const Reg center[3] = { sphereCenter.x, sphereCenter.y, sphereCenter.z };
+	Reg hit;
+	const Reg result = RaySphere(SIMDRays<width>(rays), center, sphereRadius2, hit);
+	return StoreHits(dist, result, hit, LaneMask<width>(activeMask));
+}
+
+template<unsigned int width>
+extern unsigned int Collision::RayCilinderIntersect(const TRayPacket<width> &rays, const vec3 &C0, const vec3 &C0C1, nv_scalar r2, nv_scalar (&dist)[width], unsigned int activeMask) noexcept
+{
+	typedef SIMDLanes<width> Lanes;
+	typedef typename Lanes::Reg Reg;
+
+	if (C0C1.sq_norm() == nv_zero)
+		return StoreMiss(dist);
+
+	const SIMDRays<width> simdRays(rays);
+	const auto &R0R1 = simdRays.dir;
+	const Reg
+		zero,
+		R0[3] = { simdRays.orig[0] - C0.x, simdRays.orig[1] - C0.y, simdRays.orig[2] - C0.z },
+		R0R1_dot_C0C1 = Dot<width>(R0R1, C0C1),
+		R0_dot_C0C1 = Dot<width>(R0, C0C1),
+		R0_dot_R0R1 = Dot<width>(R0, R0R1),
+		rcpsqCOC1 = nv_one / C0C1.sq_norm(),
+		a = Dot<width>(R0R1, R0R1) - R0R1_dot_C0C1 * R0R1_dot_C0C1 * rcpsqCOC1,
+		b_div_2 = R0_dot_R0R1 - R0_dot_C0C1 * R0R1_dot_C0C1 * rcpsqCOC1,
+		c = Dot<width>(R0, R0) - r2 - R0_dot_C0C1 * R0_dot_C0C1 * rcpsqCOC1,
+		D_div_4 = b_div_2 * b_div_2 - a * c,
+		result = (-b_div_2 - Lanes::Sqrt(D_div_4)) / a,
+		P[3] = { R0[0] + result * R0R1[0], R0[1] + result * R0R1[1], R0[2] + result * R0R1[2] },
+		P_dot_C0C1 = Dot<width>(P, C0C1);
+
+	const Reg hit = Lanes::And(Lanes::And(Lanes::NE(a, zero), Lanes::GE(D_div_4, zero)), Lanes::And(Lanes::GE(P_dot_C0C1, zero), Lanes::LE(P_dot_C0C1, C0C1.sq_norm())));
+	return StoreHits(dist, result, hit, LaneMask<width>(activeMask));
+}
+
+template<unsigned int width>
+extern unsigned int Collision::RayAABBIntersect(const vec3 &rayOrig, const vec3 &rayDir, const TAABBPacket<width> &boxes, nv_scalar (&dist)[width], unsigned int activeMask) noexcept
+{
+	typedef SIMDLanes<width> Lanes;
+	typedef typename Lanes::Reg Reg;
+	activeMask = LaneMask<width>(activeMask);
+	const Reg
+		center[3] = { Lanes::Load(boxes.center[0]), Lanes::Load(boxes.center[1]), Lanes::Load(boxes.center[2]) },
+		extents[3] = { Lanes::Load(boxes.extents[0]), Lanes::Load(boxes.extents[1]), Lanes::Load(boxes.extents[2]) };
+	Reg hit;
+	const Reg result = RayAABB(SIMDRays<width>(rayOrig, rayDir), center, extents, activeMask, hit);
+	return StoreHits(dist, result, hit, activeMask);
+}
+
+template<unsigned int width>
+extern unsigned int Collision::RayTriIntersect(const vec3 &rayOrig, const vec3 &rayDir, const TTriPacket<width> &tris, nv_scalar (&dist)[width], unsigned int activeMask) noexcept
+{
+	typedef SIMDLanes<width> Lanes;
+	typedef typename Lanes::Reg Reg;
+	const Reg
+		v0[3] = { Lanes::Load(tris.v0[0]), Lanes::Load(tris.v0[1]), Lanes::Load(tris.v0[2]) },
+		n[3] = { Lanes::Load(tris.n[0]), Lanes::Load(tris.n[1]), Lanes::Load(tris.n[2]) },
+		bary1[3] = { Lanes::Load(tris.bary1[0]), Lanes::Load(tris.bary1[1]), Lanes::Load(tris.bary1[2]) },
+		bary2[3] = { Lanes::Load(tris.bary2[0]), Lanes::Load(tris.bary2[1]), Lanes::Load(tris.bary2[2]) };
+	Reg hit;
+	const Reg result = RayTri(SIMDRays<width>(rayOrig, rayDir), v0, n, bary1, bary2, hit);
+	return StoreHits(dist, result, hit, LaneMask<width>(activeMask));
+}
+
+template<unsigned int width>
+extern unsigned int Collision::RaySphereIntersect(const vec3 &rayOrig, const vec3 &rayDir, const TSpherePacket<width> &spheres, nv_scalar (&dist)[width], unsigned int activeMask) noexcept
+{
+	typedef SIMDLanes<width> Lanes;
+	typedef typename Lanes::Reg Reg;
+	const Reg center[3] = { Lanes::Load(spheres.center[0]), Lanes::Load(spheres.center[1]), Lanes::Load(spheres.center[2]) };
+	Reg hit;
+	const Reg result = RaySphere(SIMDRays<width>(rayOrig, rayDir), center, Lanes::Load(spheres.radius2), hit);
+	return StoreHits(dist, result, hit, LaneMask<width>(activeMask));
+}
+
+template<unsigned int width>
+extern void Collision::RayAABBNearest(const TRayPacket<width> &rays, const vec3 *AABBCenters, const vec3 *AABBExtents, size_t count, THitPacket<width> &hits, unsigned int activeMask) noexcept
+{
+	typedef typename SIMDLanes<width>::Reg Reg;
+	NearestHits<width> nearest(hits, activeMask);
+	const SIMDRays<width> simdRays(rays);
+	for (uint32_t prim = 0; prim < count; prim++)
+	{
+		const Reg
+			center[3] = { AABBCenters[prim].x, AABBCenters[prim].y, AABBCenters[prim].z },
+			extents[3] = { AABBExtents[prim].x, AABBExtents[prim].y, AABBExtents[prim].z };
+		Reg hit;
+		const Reg dist = RayAABB(simdRays, center, extents, nearest.Active(), hit);
+		nearest(dist, hit, prim);
+	}
+}
+
+template<unsigned int width>
+extern void Collision::RayTriNearest(const TRayPacket<width> &rays, const vec3 (*tris)[3], size_t count, THitPacket<width> &hits, unsigned int activeMask) noexcept
+{
+	typedef typename SIMDLanes<width>::Reg Reg;
+	NearestHits<width> nearest(hits, activeMask);
+	const SIMDRays<width> simdRays(rays);
+	for (uint32_t prim = 0; prim < count; prim++)
+	{
+		Reg v0[3], n[3], bary1[3], bary2[3];
+		if (BroadcastTri<width>(tris[prim][0], tris[prim][1], tris[prim][2], v0, n, bary1, bary2))
+		{
+			Reg hit;
+			const Reg dist = RayTri(simdRays, v0, n, bary1, bary2, hit);
+			nearest(dist, hit, prim);
+		}
+	}
+}
+
+template<unsigned int width>
+extern void Collision::RaySphereNearest(const TRayPacket<width> &rays, const vec3 *sphereCenters, const nv_scalar *sphereRadii2, size_t count, THitPacket<width> &hits, unsigned int activeMask) noexcept
+{
+	typedef typename SIMDLanes<width>::Reg Reg;
+	NearestHits<width> nearest(hits, activeMask);
+	const SIMDRays<width> simdRays(rays);
+	for (uint32_t prim = 0; prim < count; prim++)
+	{
+		const Reg center[3] = { sphereCenters[prim].x, sphereCenters[prim].y, sphereCenters[prim].z };
+		Reg hit;
+		const Reg dist = RaySphere(simdRays, center, sphereRadii2[prim], hit);
+		nearest(dist, hit, prim);
+	}
+}
+
+#define INSTANTIATE_RAY_PACKET_QUERIES(width)																																					\
+	template unsigned int Collision::RayAABBIntersect(const TRayPacket<width> &rays, const vec3 &AABBCenter, const vec3 &AABBExtents, nv_scalar (&dist)[width], unsigned int activeMask) noexcept;	\
+	template unsigned int Collision::RayKDOPIntersect(const TRayPacket<width> &rays, const PlanePair(&planes)[3], nv_scalar (&dist)[2][width], unsigned int activeMask) noexcept;						\
+	template unsigned int Collision::RayTriIntersect(const TRayPacket<width> &rays, const vec3 &v0, const vec3 &v1, const vec3 &v2, nv_scalar (&dist)[width], unsigned int activeMask) noexcept;		\
+	template unsigned int Collision::RaySphereIntersect(const TRayPacket<width> &rays, const vec3 &sphereCenter, nv_scalar sphereRadius2, nv_scalar (&dist)[width], unsigned int activeMask) noexcept;	\
+	template unsigned int Collision::RayCilinderIntersect(const TRayPacket<width> &rays, const vec3 &C0, const vec3 &C0C1, nv_scalar r2, nv_scalar (&dist)[width], unsigned int activeMask) noexcept;	\
+	template unsigned int Collision::RayAABBIntersect(const vec3 &rayOrig, const vec3 &rayDir, const TAABBPacket<width> &boxes, nv_scalar (&dist)[width], unsigned int activeMask) noexcept;			\
+	template unsigned int Collision::RayTriIntersect(const vec3 &rayOrig, const vec3 &rayDir, const TTriPacket<width> &tris, nv_scalar (&dist)[width], unsigned int activeMask) noexcept;				\
+	template unsigned int Collision::RaySphereIntersect(const vec3 &rayOrig, const vec3 &rayDir, const TSpherePacket<width> &spheres, nv_scalar (&dist)[width], unsigned int activeMask) noexcept;		\
+	template void Collision::RayAABBNearest(const TRayPacket<width> &rays, const vec3 *AABBCenters, const vec3 *AABBExtents, size_t count, THitPacket<width> &hits, unsigned int activeMask) noexcept;	\
+	template void Collision::RayTriNearest(const TRayPacket<width> &rays, const vec3 (*tris)[3], size_t count, THitPacket<width> &hits, unsigned int activeMask) noexcept;								\
+	template void Collision::RaySphereNearest(const TRayPacket<width> &rays, const vec3 *sphereCenters, const nv_scalar *sphereRadii2, size_t count, THitPacket<width> &hits, unsigned int activeMask) noexcept;
+
+INSTANTIATE_RAY_PACKET_QUERIES(4)
+INSTANTIATE_RAY_PACKET_QUERIES(8)
+#undef INSTANTIATE_RAY_PACKET_QUERIES
+#pragma endregion
+
 #if INCLUDE_DGLE_EXTENSIONS
 static unsigned int
 	collideAndSlideInvokeCount,
@@ -458,6 +1010,80 @@ void Collision::CTriCollider::operator ()(const CSphereXformHandler &sphereXform
 		CollideFace(v0, v1, v2, -offset, -n);
 }
 
+// vectorized counterpart of scalar version above, SIMD lanes correspond to tris
+template<unsigned int width>
+void Collision::CTriCollider::operator ()(const CSphereXformHandler &sphereXformHandler, const TTriPacket<width> &tris)
+{
+#if INCLUDE_DGLE_EXTENSIONS
+	triColliderInvokeCount += width;
+#endif
+
+	typedef SIMDLanes<width> Lanes;
+	typedef typename Lanes::Reg Reg;
+
+	const CSphereXformHandler::TMovingSphere &xformed_sphere = sphereXformHandler;
+
+	const Reg
+		n[3] = { Lanes::Load(tris.n[0]), Lanes::Load(tris.n[1]), Lanes::Load(tris.n[2]) },
+		dir[3] = { xformed_sphere.dir.x, xformed_sphere.dir.y, xformed_sphere.dir.z },
+		c_v0[3] = { xformed_sphere.c.x - Lanes::Load(tris.v0[0]), xformed_sphere.c.y - Lanes::Load(tris.v0[1]), xformed_sphere.c.z - Lanes::Load(tris.v0[2]) },
+		bary1[3] = { Lanes::Load(tris.bary1[0]), Lanes::Load(tris.bary1[1]), Lanes::Load(tris.bary1[2]) },
+		bary2[3] = { Lanes::Load(tris.bary2[0]), Lanes::Load(tris.bary2[1]), Lanes::Load(tris.bary2[2]) };
+
+	const Reg
+		dir_dot_n = dir[0] * n[0] + dir[1] * n[1] + dir[2] * n[2],
+		v0_c_dot_n = -(c_v0[0] * n[0] + c_v0[1] * n[1] + c_v0[2] * n[2]),
+		zero, one = nv_one, inf = numeric_limits<nv_scalar>::infinity();
+
+	// reject || planes, zero-filled lanes get rejected here too
+	const Reg plane_hit = Lanes::NE(dir_dot_n, zero);
+
+	// returns dist for lanes hitting inside tri and <dist>, +inf otherwise
+	const auto CollideFace = [&, limit = Reg(_result.dist)](Reg dist)
+	{
+		// get vector from v0 to intersection point
+		// offset along normal omitted - it does not contribute to barycentrics
+		const Reg f[3] = { c_v0[0] + dist * dir[0], c_v0[1] + dist * dir[1], c_v0[2] + dist * dir[2] };
+
+		// determine if intersection inside tri
+		const Reg
+			b1 = bary1[0] * f[0] + bary1[1] * f[1] + bary1[2] * f[2],
+			b2 = bary2[0] * f[0] + bary2[1] * f[1] + bary2[2] * f[2];
+		Reg hit = Lanes::And(plane_hit, Lanes::And(Lanes::And(Lanes::GE(b1, zero), Lanes::GE(b2, zero)), Lanes::LE(b1 + b2, one)));
+		hit = Lanes::And(hit, Lanes::LT(dist, limit));
+		if (Finite())
+			hit = Lanes::And(hit, Lanes::GE(dist, zero));
+
+		return Lanes::Select(hit, dist, inf);
+	};
+
+	// offset tris along normal by sphere radius
+	const Reg r = xformed_sphere.r;
+	nv_scalar dist;
+	unsigned int lane = Lanes::FirstMin(CollideFace((v0_c_dot_n + r) / dir_dot_n), dist);
+	bool backFace = false;
+	if (_doubleSide)
+	{
+		nv_scalar backDist;
+		const unsigned int backLane = Lanes::FirstMin(CollideFace((v0_c_dot_n - r) / dir_dot_n), backDist);
+		if (backDist < dist)
+		{
+			dist = backDist;
+			lane = backLane;
+			backFace = true;
+		}
+	}
+
+	if (CBasePrimitiveCollider::operator ()(dist))
+	{
+		const vec3 n(tris.n[0][lane], tris.n[1][lane], tris.n[2][lane]);
+		SetNormal(backFace ? -n : n, sphereXformHandler);
+	}
+}
+
+template void Collision::CTriCollider::operator ()(const CSphereXformHandler &sphereXformHandler, const TTriPacket<4> &tris);
+template void Collision::CTriCollider::operator ()(const CSphereXformHandler &sphereXformHandler, const TTriPacket<8> &tris);
+
 void Collision::CEdgeCollider::operator ()(const CSphereXformHandler &sphereXformHandler, const vec3 &v0, const vec3 &v1)
 {
 #if INCLUDE_DGLE_EXTENSIONS
@@ -8,6 +8,7 @@
 #endif
 #include "nv_algebra.h"
 #include <vector>
+#include <cstdint>
 
 namespace Math::Collision
 {
@@ -52,6 +53,90 @@ namespace Math::Collision
 	extern nv_scalar RaySphereIntersect(vec3 rayOrig, const vec3 &rayDir, const vec3 &sphereCenter, nv_scalar sphereRadius2) noexcept;
 	extern nv_scalar RayCilinderIntersect(vec3 rayOrig, const vec3 &rayDir, const vec3 &cilinderOrig, const vec3 &cilinderDir, nv_scalar cilinderRadius2) noexcept;
 
+#pragma region SIMD
+	// SoA tris prepared for SIMD ray queries and swept sphere collision
+	// unused lanes should stay zero-filled (zero normal never collides)
+	template<unsigned int width>
+	struct alignas(width * sizeof(nv_scalar)) TTriPacket
+	{
+		static_assert(width == 4 || width == 8, "tri packet width should be 4 (SSE) or 8 (AVX)");
+		nv_scalar
+			v0[3][width],		// 1st vertex
+			n[3][width],		// unit normal
+			bary1[3][width],	// dot with (P - v0) gives 2nd barycentric coordinate
+			bary2[3][width];	// dot with (P - v0) gives 3rd barycentric coordinate
+
+		// returns false for degenerate tri, lane remains untouched then
+		bool Set(unsigned int lane, const vec3 &v0, const vec3 &v1, const vec3 &v2) noexcept;
+	};
+
+	template<unsigned int width>
+	struct alignas(width * sizeof(nv_scalar)) TAABBPacket
+	{
+		static_assert(width == 4 || width == 8, "AABB packet width should be 4 (SSE) or 8 (AVX)");
+		nv_scalar center[3][width], extents[3][width];
+
+		void Set(unsigned int lane, const vec3 &center, const vec3 &extents) noexcept;
+	};
+
+	template<unsigned int width>
+	struct alignas(width * sizeof(nv_scalar)) TSpherePacket
+	{
+		static_assert(width == 4 || width == 8, "sphere packet width should be 4 (SSE) or 8 (AVX)");
+		nv_scalar center[3][width], radius2[width];
+
+		void Set(unsigned int lane, const vec3 &center, nv_scalar radius2) noexcept;
+	};
+
+	template<unsigned int width>
+	struct alignas(width * sizeof(nv_scalar)) TRayPacket
+	{
+		static_assert(width == 4 || width == 8, "ray packet width should be 4 (SSE) or 8 (AVX)");
+		nv_scalar orig[3][width], dir[3][width];
+
+		void Set(unsigned int lane, const vec3 &orig, const vec3 &dir) noexcept;
+	};
+
+	template<unsigned int width>
+	struct THitPacket
+	{
+		nv_scalar dist[width];	// NaN for missed rays
+		uint32_t prim[width];	// primitive idx, valid for hit rays only
+		unsigned int mask;		// rays hit something
+	};
+
+	// SIMD variants follow scalar versions above but are reentrant
+	// they return mask of lanes hit, 'dist' is NaN for missed lanes, lanes excluded from 'activeMask' never reported as hit
+
+	// ray packet vs single primitive, returns early once all active rays are rejected
+	template<unsigned int width>
+	extern unsigned int RayAABBIntersect(const TRayPacket<width> &rays, const vec3 &AABBCenter, const vec3 &AABBExtents, nv_scalar (&dist)[width], unsigned int activeMask = ~0u) noexcept;
+	template<unsigned int width, unsigned int k>
+	extern unsigned int RayKDOPIntersect(const TRayPacket<width> &rays, const PlanePair(&planes)[k], nv_scalar (&dist)[2][width], unsigned int activeMask = ~0u) noexcept;
+	template<unsigned int width>
+	extern unsigned int RayTriIntersect(const TRayPacket<width> &rays, const vec3 &v0, const vec3 &v1, const vec3 &v2, nv_scalar (&dist)[width], unsigned int activeMask = ~0u) noexcept;
+	template<unsigned int width>
+	extern unsigned int RaySphereIntersect(const TRayPacket<width> &rays, const vec3 &sphereCenter, nv_scalar sphereRadius2, nv_scalar (&dist)[width], unsigned int activeMask = ~0u) noexcept;
+	template<unsigned int width>
+	extern unsigned int RayCilinderIntersect(const TRayPacket<width> &rays, const vec3 &cilinderOrig, const vec3 &cilinderDir, nv_scalar cilinderRadius2, nv_scalar (&dist)[width], unsigned int activeMask = ~0u) noexcept;
+
+	// single ray vs primitive batch, 'activeMask' selects primitive lanes
+	template<unsigned int width>
+	extern unsigned int RayAABBIntersect(const vec3 &rayOrig, const vec3 &rayDir, const TAABBPacket<width> &boxes, nv_scalar (&dist)[width], unsigned int activeMask = ~0u) noexcept;
+	template<unsigned int width>
+	extern unsigned int RayTriIntersect(const vec3 &rayOrig, const vec3 &rayDir, const TTriPacket<width> &tris, nv_scalar (&dist)[width], unsigned int activeMask = ~0u) noexcept;
+	template<unsigned int width>
+	extern unsigned int RaySphereIntersect(const vec3 &rayOrig, const vec3 &rayDir, const TSpherePacket<width> &spheres, nv_scalar (&dist)[width], unsigned int activeMask = ~0u) noexcept;
+
+	// nearest hit with non-negative dist per ray in packet
+	template<unsigned int width>
+	extern void RayAABBNearest(const TRayPacket<width> &rays, const vec3 *AABBCenters, const vec3 *AABBExtents, size_t count, THitPacket<width> &hits, unsigned int activeMask = ~0u) noexcept;
+	template<unsigned int width>
+	extern void RayTriNearest(const TRayPacket<width> &rays, const vec3 (*tris)[3], size_t count, THitPacket<width> &hits, unsigned int activeMask = ~0u) noexcept;
+	template<unsigned int width>
+	extern void RaySphereNearest(const TRayPacket<width> &rays, const vec3 *sphereCenters, const nv_scalar *sphereRadii2, size_t count, THitPacket<width> &hits, unsigned int activeMask = ~0u) noexcept;
+#pragma endregion
+
 #if INCLUDE_DGLE_EXTENSIONS
 	namespace CollisionStat
 	{
@@ -129,6 +214,10 @@ namespace Math::Collision
 		{
 			normalize(_result.n = sphereXformHandler.GetNormalXform() * n);
 		}
+		bool Finite() const noexcept
+		{
+			return _finite;
+		}
 		TCollideResult &_result;
 	private:
 		const bool _finite;
@@ -144,6 +233,9 @@ namespace Math::Collision
 		{
 		}
 		void operator ()(const CSphereXformHandler &sphereXformHandler, const vec3 &v0, const vec3 &v1, const vec3 &v2);
+		// collides 4 (SSE) or 8 (AVX) tris at once
+		template<unsigned int width>
+		void operator ()(const CSphereXformHandler &sphereXformHandler, const TTriPacket<width> &tris);
 	};
 
 	// collide with edge's cylinders
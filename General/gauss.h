@@ -1,7 +1,10 @@
 #pragma once
 
 #include "CompilerCheck.h"
+#include <cstddef>
 #include <iterator>
+#include <memory>
+#include <span>
 #define _USE_MATH_DEFINES
 #include <cmath>
 
@@ -51,6 +54,48 @@ namespace Math::Gauss
 		const T _sigma;
 		int _x;
 	};
+
+	/*
+		normalized symmetric kernel with taps [0, radius] (center first), weights of mirrored taps sum to 1
+		arrays are aligned and zero padded up to 'alignment' so that SIMD loops need no tail handling
+		linear sampling pairs merge adjacent taps into single bilinear fetch for separable blurs: fetch at +-offset with weight, [0] is center
+	*/
+	template<typename T>
+	class CGaussKernel
+	{
+	public:
+		static constexpr std::size_t alignment = 32;	// AVX
+
+	private:
+		struct alignas(alignment) CBlock
+		{
+			T lanes[alignment / sizeof(T)];
+		};
+		std::unique_ptr<CBlock[]> _weights, _linearOffsets, _linearWeights;
+		unsigned _radius, _linearTaps;
+
+	public:
+		CGaussKernel(T sigma, unsigned radius);
+		CGaussKernel(CGaussKernel &) = delete;
+		void operator =(CGaussKernel &) = delete;
+
+	public:
+		unsigned Radius() const noexcept { return _radius; }
+		std::span<const T> Weights() const noexcept { return { _weights[0].lanes, _radius + 1 }; }
+		std::span<const T> PaddedWeights() const noexcept { return { _weights[0].lanes, _PaddedSize(_radius + 1) }; }
+		std::span<const T> LinearOffsets() const noexcept { return { _linearOffsets[0].lanes, _linearTaps }; }
+		std::span<const T> LinearWeights() const noexcept { return { _linearWeights[0].lanes, _linearTaps }; }
+
+	private:
+		static std::size_t _BlockCount(std::size_t size) noexcept { return (size + std::size(CBlock{}.lanes) - 1) / std::size(CBlock{}.lanes); }
+		static std::size_t _PaddedSize(std::size_t size) noexcept { return _BlockCount(size) * std::size(CBlock{}.lanes); }
+	};
+
+	// computed once per (sigma, radius), thread-safe, default radius covers 3 sigma (as 'CGaussRange')
+	template<typename T>
+	std::shared_ptr<const CGaussKernel<T>> GetGaussKernel(T sigma, unsigned radius);
+	template<typename T>
+	std::shared_ptr<const CGaussKernel<T>> GetGaussKernel(T sigma);
 }
 
 #include "gauss.inl"
\ No newline at end of file
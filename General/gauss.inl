@@ -2,6 +2,10 @@
 
 #include "gauss.h"
 #include <cassert>
+#include <utility>
+#include <map>
+#include <mutex>
+#include <shared_mutex>
 
 template<typename T>
 inline void Math::Gauss::CGaussRange<T>::CIterator::_Check(CIterator iter1, CIterator iter2)
@@ -106,4 +110,55 @@ template<typename T>
 inline typename Math::Gauss::CGaussRange<T>::CIterator CGaussRange<T>::end() const
 {
 	return CIterator(_sigma, 1);
+}
+
+template<typename T>
+Math::Gauss::CGaussKernel<T>::CGaussKernel(T sigma, unsigned radius) :
+	_weights(new CBlock[_BlockCount(radius + 1)]{}),
+	_linearOffsets(new CBlock[_BlockCount(radius / 2 + 2)]{}),
+	_linearWeights(new CBlock[_BlockCount(radius / 2 + 2)]{}),
+	_radius(radius), _linearTaps(1)
+{
+	T *const weights = _weights[0].lanes, *const linearOffsets = _linearOffsets[0].lanes, *const linearWeights = _linearWeights[0].lanes;
+
+	// normalize
+	T sum = weights[0] = Gauss(T(0), sigma);
+	for (unsigned x = 1; x <= radius; x++)
+		sum += 2 * (weights[x] = Gauss(T(x), sigma));
+	for (unsigned x = 0; x <= radius; x++)
+		weights[x] /= sum;
+
+	// merge adjacent taps (x, x + 1) into single fetch between them, odd radius leaves last tap unpaired
+	linearWeights[0] = weights[0];
+	for (unsigned x = 1; x <= radius; x += 2, _linearTaps++)
+	{
+		const T pairWeight = x < radius ? weights[x] + weights[x + 1] : weights[x];
+		linearWeights[_linearTaps] = pairWeight;
+		linearOffsets[_linearTaps] = x < radius ? (x * weights[x] + (x + 1) * weights[x + 1]) / pairWeight : T(x);
+	}
+}
+
+template<typename T>
+std::shared_ptr<const Math::Gauss::CGaussKernel<T>> Math::Gauss::GetGaussKernel(T sigma, unsigned radius)
+{
+	static std::map<std::pair<T, unsigned>, std::shared_ptr<const CGaussKernel<T>>> cache;
+	static std::shared_mutex mtx;
+
+	const auto key = std::make_pair(sigma, radius);
+	{
+		std::shared_lock lck(mtx);
+		if (const auto cached = cache.find(key); cached != cache.end())
+			return cached->second;
+	}
+
+	// construct before inserting so that throw does not leave null entry, keep kernel built concurrently by other thread if any
+	auto kernel = std::make_shared<const CGaussKernel<T>>(sigma, radius);
+	std::lock_guard lck(mtx);
+	return cache.try_emplace(key, std::move(kernel)).first->second;
+}
+
+template<typename T>
+inline std::shared_ptr<const Math::Gauss::CGaussKernel<T>> Math::Gauss::GetGaussKernel(T sigma)
+{
+	return GetGaussKernel(sigma, unsigned(ceil(3 * sigma)));
 }
\ No newline at end of file
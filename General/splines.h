@@ -7,6 +7,7 @@
 #include <utility>
 #include <type_traits>
 #include <tuple>
+#include "SIMD.h"
 #define DISABLE_MATRIX_SWIZZLES
 #include "vector math.h"
 
@@ -28,6 +29,12 @@ namespace Math::Splines
 		sufficiently close to being a straight line test then midpoint test available at both methods.
 	*/
 
+	/*
+		Batched evaluation computes Bernstein weights once per batch:
+		many params against single curve are evaluated 8 at a time in SoA layout with YMM (for float points without attribs),
+		many curves at single param share scalar weights.
+	*/
+
 #pragma region CompositePoint
 	template<class Pos, class ...Attribs>
 	struct CompositePoint
@@ -193,10 +200,26 @@ namespace Math::Splines
 	public:
 		typename ControlPoints::value_type operator ()(ScalarType u) const;
 
+		// evaluates curve at each param in [uBegin, uEnd)
+		template<typename InputIterator, typename OutputIterator>
+		OutputIterator operator ()(InputIterator uBegin, InputIterator uEnd, OutputIterator output) const;
+
+		// evaluates each curve in [curvesBegin, curvesEnd) at the same param
+		template<typename InputIterator, typename OutputIterator>
+		static OutputIterator Evaluate(InputIterator curvesBegin, InputIterator curvesEnd, ScalarType u, OutputIterator output);
+
 		template<typename Iterator>
 		void Tessellate(Iterator output, ScalarType delta, bool emitFirstPoint = true) const;
 
 	private:
+		static constexpr bool SIMDBatch = std::is_same_v<ScalarType, float> && sizeof...(Attribs) == 0;
+
+		// Bernstein basis, 'Scalar' is either ScalarType or SIMD type
+		template<typename Scalar>
+		static void Weights(const Scalar &u, Scalar (&weights)[degree + 1]);
+
+		typename ControlPoints::value_type Blend(const ScalarType (&weights)[degree + 1]) const;
+
 #ifndef MSVC_LIMITATIONS
 		template<size_t ...idx>
 		typename ControlPoints::value_type operator ()(ScalarType u, std::index_sequence<idx...>) const;
@@ -226,9 +249,10 @@ namespace Math::Splines
 		template<template<typename ScalarType, unsigned int dimension, class ...Attribs> class CBezierInterpolationImpl, typename ScalarType, unsigned int dimension, class ...Attribs>
 		class CBezierInterpolationCommon : public CBezierInterpolationImpl<ScalarType, dimension, Attribs...>
 		{
-#ifdef MSVC_LIMITATIONS
 			typedef CBezierInterpolationImpl<ScalarType, dimension, Attribs...> Base;
+			typedef typename CBezierInterpolationBase<ScalarType, dimension, Attribs...>::Bezier Bezier;
 
+#ifdef MSVC_LIMITATIONS
 		protected:
 			using Base::Base;
 #else
@@ -236,6 +260,16 @@ namespace Math::Splines
 #endif
 
 		public:
+			using Base::operator ();
+
+			// evaluates spline at each param in [uBegin, uEnd), consecutive params falling into the same segment are batched
+			template<typename InputIterator, typename OutputIterator>
+			OutputIterator operator ()(InputIterator uBegin, InputIterator uEnd, OutputIterator output) const;
+
+			// evaluates each spline in [splinesBegin, splinesEnd) at the same param
+			template<typename InputIterator, typename OutputIterator>
+			static OutputIterator Evaluate(InputIterator splinesBegin, InputIterator splinesEnd, ScalarType u, OutputIterator output);
+
 			template<typename Iterator>
 			void Tessellate(Iterator output, ScalarType delta) const;
 		};
@@ -264,6 +298,8 @@ namespace Math::Splines
 			typedef std::vector<Point> Points;
 
 		protected:
+			// global param -> (segment idx, local param)
+			std::pair<typename Points::size_type, ScalarType> Locate(ScalarType u) const;
 			Bezier Segment(typename Points::size_type i) const;
 
 		protected:
@@ -310,6 +346,8 @@ namespace Math::Splines
 			typedef std::vector<std::pair<ScalarType, Point>> Points;
 
 		protected:
+			// global param -> (segment idx, local param)
+			std::pair<typename Points::size_type, ScalarType> Locate(ScalarType u) const;
 			Bezier Segment(typename Points::size_type i) const;
 
 		protected:
@@ -328,6 +366,28 @@ namespace Math::Splines
 	public:
 		using Base::Base;
 	};
+
+	// cumulative arc length sampled at uniform params, intended to be built once per spline and reused
+	// inverse mapping allows to move along spline with constant speed: spline(table.Param(s))
+	template<typename ScalarType>
+	class CArcLengthTable
+	{
+	public:
+		template<class Spline>
+		explicit CArcLengthTable(const Spline &spline, unsigned int segmentCount = 256);
+
+	public:
+		ScalarType Length() const noexcept { return lengths.back(); }
+
+		// param -> arc length
+		ScalarType Length(ScalarType u) const;
+
+		// arc length -> param
+		ScalarType Param(ScalarType s) const;
+
+	private:
+		std::vector<ScalarType> lengths;
+	};
 }
 
 #include "splines.inl"
\ No newline at end of file
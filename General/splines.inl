@@ -305,6 +305,85 @@ auto Math::Splines::CBezier<ScalarType, dimension, degree, Attribs...>::operator
 #endif
 }
 
+template<typename ScalarType, unsigned int dimension, unsigned int degree, class ...Attribs>
+template<typename Scalar>
+inline void Math::Splines::CBezier<ScalarType, dimension, degree, Attribs...>::Weights(const Scalar &u, Scalar (&weights)[degree + 1])
+{
+	// C(degree, i) * u^i * (1 - u)^(degree - i)
+	const Scalar v = ScalarType(1) - u;
+	Scalar factor = ScalarType(1);
+	for (unsigned i = 0; i <= degree; i++, factor *= u)
+		weights[i] = factor;
+	factor = ScalarType(1);
+	uintmax_t binomial = 1;
+	for (unsigned i = degree + 1; i-- > 0; factor *= v)
+	{
+		weights[i] *= ScalarType(binomial) * factor;
+		// C(n, k - 1) = C(n, k) * k / (n - k + 1)
+		binomial = binomial * i / (degree + 1 - i);
+	}
+}
+
+template<typename ScalarType, unsigned int dimension, unsigned int degree, class ...Attribs>
+inline auto Math::Splines::CBezier<ScalarType, dimension, degree, Attribs...>::Blend(const ScalarType (&weights)[degree + 1]) const -> typename ControlPoints::value_type
+{
+	typename ControlPoints::value_type result = weights[0] * controlPoints[0];
+	for (unsigned i = 1; i <= degree; i++)
+		result += weights[i] * controlPoints[i];
+	return result;
+}
+
+template<typename ScalarType, unsigned int dimension, unsigned int degree, class ...Attribs>
+template<typename InputIterator, typename OutputIterator>
+OutputIterator Math::Splines::CBezier<ScalarType, dimension, degree, Attribs...>::operator ()(InputIterator uBegin, InputIterator uEnd, OutputIterator output) const
+{
+	if constexpr (SIMDBatch)
+	{
+		float u[8];
+		while (uBegin != uEnd)
+		{
+			unsigned count = 0;
+			do
+				u[count++] = *uBegin++;
+			while (count < std::size(u) && uBegin != uEnd);
+			std::fill(u + count, std::end(u), 0.f);
+
+			SIMD::YMM weights[degree + 1];
+			Weights(SIMD::YMM(u), weights);
+
+			// SoA: each component of 8 points at once
+			float components[dimension][std::size(u)];
+			for (unsigned c = 0; c < dimension; c++)
+			{
+				SIMD::YMM component = weights[0] * controlPoints[0][c];
+				for (unsigned i = 1; i <= degree; i++)
+					component += weights[i] * controlPoints[i][c];
+				component.Extract(components[c]);
+			}
+
+			for (unsigned lane = 0; lane < count; lane++)
+			{
+				typename ControlPoints::value_type point;
+				for (unsigned c = 0; c < dimension; c++)
+					point[c] = components[c][lane];
+				*output++ = point;
+			}
+		}
+		return output;
+	}
+	else
+		return std::transform(uBegin, uEnd, output, [this](ScalarType u) { return (*this)(u); });
+}
+
+template<typename ScalarType, unsigned int dimension, unsigned int degree, class ...Attribs>
+template<typename InputIterator, typename OutputIterator>
+OutputIterator Math::Splines::CBezier<ScalarType, dimension, degree, Attribs...>::Evaluate(InputIterator curvesBegin, InputIterator curvesEnd, ScalarType u, OutputIterator output)
+{
+	ScalarType weights[degree + 1];
+	Weights(u, weights);
+	return std::transform(curvesBegin, curvesEnd, output, [&weights](const CBezier &curve) { return curve.Blend(weights); });
+}
+
 template<typename ScalarType, unsigned int dimension, unsigned int degree, class ...Attribs>
 template<typename Iterator>
 void Math::Splines::CBezier<ScalarType, dimension, degree, Attribs...>::Tessellate(Iterator output, ScalarType delta, bool emitFirstPoint) const
@@ -358,6 +437,60 @@ void Math::Splines::CBezier<ScalarType, dimension, degree, Attribs...>::Subdiv(I
 	}
 }
 
+template<template<typename ScalarType, unsigned int dimension, class ...Attribs> class CBezierInterpolationImpl, typename ScalarType, unsigned int dimension, class ...Attribs>
+template<typename InputIterator, typename OutputIterator>
+OutputIterator Math::Splines::Impl::CBezierInterpolationCommon<CBezierInterpolationImpl, ScalarType, dimension, Attribs...>::operator ()(InputIterator uBegin, InputIterator uEnd, OutputIterator output) const
+{
+	ScalarType locals[64];
+	typename Base::Points::size_type segmentIdx = 0;	// valid segments starts from 1
+	unsigned count = 0;
+	const auto flush = [&]
+	{
+		if (count)
+			output = this->Segment(segmentIdx)(locals, locals + count, output);
+		count = 0;
+	};
+	for (; uBegin != uEnd; ++uBegin)
+	{
+		const auto [i, u] = this->Locate(*uBegin);
+		if (i != segmentIdx || count == std::size(locals))
+		{
+			flush();
+			segmentIdx = i;
+		}
+		locals[count++] = u;
+	}
+	flush();
+	return output;
+}
+
+// splines sharing local param (e.g. Catmull-Rom splines with equal point count) get blended with the same bezier weights
+template<template<typename ScalarType, unsigned int dimension, class ...Attribs> class CBezierInterpolationImpl, typename ScalarType, unsigned int dimension, class ...Attribs>
+template<typename InputIterator, typename OutputIterator>
+OutputIterator Math::Splines::Impl::CBezierInterpolationCommon<CBezierInterpolationImpl, ScalarType, dimension, Attribs...>::Evaluate(InputIterator splinesBegin, InputIterator splinesEnd, ScalarType u, OutputIterator output)
+{
+	std::vector<Bezier> segments;
+	ScalarType local{};
+	const auto flush = [&]
+	{
+		output = Bezier::Evaluate(segments.cbegin(), segments.cend(), local, output);
+		segments.clear();
+	};
+	for (; splinesBegin != splinesEnd; ++splinesBegin)
+	{
+		const CBezierInterpolationCommon &spline = *splinesBegin;
+		const auto [i, t] = spline.Locate(u);
+		if (t != local)
+		{
+			flush();
+			local = t;
+		}
+		segments.push_back(spline.Segment(i));
+	}
+	flush();
+	return output;
+}
+
 template<template<typename ScalarType, unsigned int dimension, class ...Attribs> class CBezierInterpolationImpl, typename ScalarType, unsigned int dimension, class ...Attribs>
 template<typename Iterator>
 void Math::Splines::Impl::CBezierInterpolationCommon<CBezierInterpolationImpl, ScalarType, dimension, Attribs...>::Tessellate(Iterator output, ScalarType delta) const
@@ -383,6 +516,13 @@ points(points)
 
 template<typename ScalarType, unsigned int dimension, class ...Attribs>
 auto Math::Splines::Impl::CCatmullRom<ScalarType, dimension, Attribs...>::operator ()(ScalarType u) const -> Point
+{
+	const auto [i, t] = Locate(u);
+	return Segment(i)(t);
+}
+
+template<typename ScalarType, unsigned int dimension, class ...Attribs>
+auto Math::Splines::Impl::CCatmullRom<ScalarType, dimension, Attribs...>::Locate(ScalarType u) const -> std::pair<typename Points::size_type, ScalarType>
 {
 	//assert(u >= 0 && u <= 1);
 	// [0..1]->[0..m-2]->[1..m-1]
@@ -390,7 +530,7 @@ auto Math::Splines::Impl::CCatmullRom<ScalarType, dimension, Attribs...>::operat
 	// ensure 1 <= i < m
 	//const Points::size_type i = std::min<Points::size_type>(floor(u), points.size() - 3);
 	const ScalarType i = fmin(fmax(floor(u), 1), points.size() - 3);
-	return Segment(i)(u - i);
+	return { typename Points::size_type(i), u - i };
 }
 
 template<typename ScalarType, unsigned int dimension, class ...Attribs>
@@ -434,6 +574,13 @@ void Math::Splines::Impl::CBesselOverhauser<ScalarType, dimension, Attribs...>::
 
 template<typename ScalarType, unsigned int dimension, class ...Attribs>
 auto Math::Splines::Impl::CBesselOverhauser<ScalarType, dimension, Attribs...>::operator ()(ScalarType u) const -> Point
+{
+	const auto [i, t] = Locate(u);
+	return Segment(i)(t);
+}
+
+template<typename ScalarType, unsigned int dimension, class ...Attribs>
+auto Math::Splines::Impl::CBesselOverhauser<ScalarType, dimension, Attribs...>::Locate(ScalarType u) const -> std::pair<typename Points::size_type, ScalarType>
 {
 	//assert(u >= 0 && u <= 1);
 	// [0..1]->[u_begin..u_end]
@@ -458,7 +605,7 @@ auto Math::Splines::Impl::CBesselOverhauser<ScalarType, dimension, Attribs...>::
 	else if (std::distance(p1, points.end()) < 2)
 		p1 = std::prev(points.end(), 2);
 	const auto p0 = std::prev(p1);
-	return Segment(std::distance(points.begin(), p0))((u - p0->first) / (p1->first - p0->first));
+	return { typename Points::size_type(std::distance(points.begin(), p0)), (u - p0->first) / (p1->first - p0->first) };
 }
 
 template<typename ScalarType, unsigned int dimension, class ...Attribs>
@@ -481,4 +628,46 @@ auto Math::Splines::Impl::CBesselOverhauser<ScalarType, dimension, Attribs...>::
 			(points[i + 1].first - points[i].first);
 	};
 	return { points[i].second, points[i].second + offset(0), points[i + 1].second - offset(1), points[i + 1].second };
+}
+
+template<typename ScalarType>
+template<class Spline>
+Math::Splines::CArcLengthTable<ScalarType>::CArcLengthTable(const Spline &spline, unsigned int segmentCount)
+{
+	assert(segmentCount > 0);
+	std::vector<ScalarType> params(segmentCount + 1);
+	for (unsigned i = 0; i <= segmentCount; i++)
+		params[i] = ScalarType(i) / segmentCount;
+
+	std::vector<std::decay_t<decltype(spline(params.front()))>> points;
+	points.reserve(params.size());
+	spline(params.cbegin(), params.cend(), std::back_inserter(points));
+
+	lengths.reserve(points.size());
+	lengths.push_back(0);
+	transform(std::next(points.cbegin()), points.cend(), points.cbegin(), std::back_inserter(lengths), [this](const auto &curPoint, const auto &prevPoint)
+	{
+		return lengths.back() + VectorMath::distance(GetPos(prevPoint), GetPos(curPoint));
+	});
+}
+
+template<typename ScalarType>
+ScalarType Math::Splines::CArcLengthTable<ScalarType>::Length(ScalarType u) const
+{
+	// [0..1]->[0..segmentCount]
+	u = fmin(fmax(u, ScalarType(0)), ScalarType(1)) * ScalarType(lengths.size() - 1);
+	const ScalarType i = fmin(floor(u), ScalarType(lengths.size() - 2));
+	const auto idx = typename std::vector<ScalarType>::size_type(i);
+	return lerp(lengths[idx], lengths[idx + 1], u - i);
+}
+
+template<typename ScalarType>
+ScalarType Math::Splines::CArcLengthTable<ScalarType>::Param(ScalarType s) const
+{
+	s = fmin(fmax(s, ScalarType(0)), Length());
+	// 1st sample farther than 's' (or the last one)
+	const auto next = std::upper_bound(std::next(lengths.cbegin()), std::prev(lengths.cend()), s), prev = std::prev(next);
+	const ScalarType segmentLength = *next - *prev;
+	const ScalarType t = segmentLength > 0 ? (s - *prev) / segmentLength : ScalarType(0);
+	return (ScalarType(std::distance(lengths.cbegin(), prev)) + t) / ScalarType(lengths.size() - 1);
 }
\ No newline at end of file
@@ -44,6 +44,38 @@ void __fastcall System::ValidateHandle(HANDLE handle)
 		throw _com_error(HRESULT_FROM_WIN32(GetLastError()));
 }
 
+static constexpr const char mappedFileHandleName[] = "mapped file", fileMappingHandleName[] = "file mapping";
+
+System::MappedFile::MappedFile(const filesystem::path &location)
+{
+	const Handle<mappedFileHandleName> file(CreateFileW(location.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL));
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize))
+		throw _com_error(HRESULT_FROM_WIN32(GetLastError()));
+
+	// mapping of empty file fails
+	if (fileSize.QuadPart)
+	{
+		// mapping and view keep file open so handles can be closed right away
+		const HANDLE mapping = CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (!mapping)
+			throw _com_error(HRESULT_FROM_WIN32(GetLastError()));
+		const Handle<fileMappingHandleName> mappingGuard(mapping);
+		if (!(data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0)))
+			throw _com_error(HRESULT_FROM_WIN32(GetLastError()));
+		size = fileSize.QuadPart;
+	}
+}
+
+System::MappedFile::~MappedFile()
+{
+	if (data && !UnmapViewOfFile(data))
+	{
+		WideIOGuard IOGuard(stderr);
+		wcerr << "Fail to unmap file view: " << _com_error(HRESULT_FROM_WIN32(GetLastError())).ErrorMessage() << endl;
+	}
+}
+
 const char driveDetectionFailMsgPrefix[] = "Fail to detect drive type: ";
 
 static void PrintError(const char *msg)
@@ -49,6 +49,26 @@ namespace System
 #pragma endregion
 
 
+#pragma region memory mapped file
+	// read-only, whole file view, intended for 'CBinaryIstream'
+	class MappedFile
+	{
+		const void *data = nullptr;
+		size_t size = 0;
+
+	public:
+		explicit MappedFile(const std::filesystem::path &location);
+		~MappedFile();
+		MappedFile(MappedFile &) = delete;
+		void operator =(MappedFile &) = delete;
+
+	public:
+		const void *Data() const noexcept { return data; }
+		size_t Size() const noexcept { return size; }
+	};
+#pragma endregion
+
+
 	extern bool __fastcall DetectSSD(const std::filesystem::path &location, bool optimizeForSMT = false) noexcept;
 }
 
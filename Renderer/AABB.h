@@ -3,6 +3,7 @@
 // TODO: move to include or General
 
 #include <cmath>
+#include <cstddef>
 #include <type_traits>
 #define DISABLE_MATRIX_SWIZZLES
 #if !__INTELLISENSE__ 
@@ -65,6 +66,21 @@ namespace Renderer
 		aabb3D.Transform(xform);
 		return aabb3D;
 	}
+
+#pragma region batch kernels
+	// SIMD kernels for arrays of AABBs, 'stride' in bytes allows AABBs to be embedded into bigger structs
+
+	template<unsigned dimension>
+	AABB<dimension> RefitAABBs(const AABB<dimension> *src, size_t count, size_t stride = sizeof(AABB<dimension>));
+
+	// Arvo's method: center gets transformed by xform, extents - by abs(xform), 'src' and 'dst' can alias
+	template<unsigned dimension>
+	void TransformAABBs(const AABB<dimension> *src, AABB<dimension> *dst, size_t count, const Math::VectorMath::matrix<float, dimension + 1, dimension> &xform, size_t srcStride = sizeof(AABB<dimension>));
+
+	// bounds of transformed AABBs without storing them
+	template<unsigned dimension>
+	AABB<dimension> TransformRefitAABBs(const AABB<dimension> *src, size_t count, const Math::VectorMath::matrix<float, dimension + 1, dimension> &xform, size_t stride = sizeof(AABB<dimension>));
+#pragma endregion
 }
 
 #include "../AABB.inl"
\ No newline at end of file
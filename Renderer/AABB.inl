@@ -3,6 +3,8 @@
 #include "AABB.h"
 #include <algorithm>
 #include <numeric>
+#include <utility>
+#include <immintrin.h>
 
 template<unsigned dimension>
 inline void Renderer::AABB<dimension>::Refit(const Math::VectorMath::vector<float, dimension> &min, const Math::VectorMath::vector<float, dimension> &max)
@@ -45,6 +47,152 @@ void Renderer::AABB<dimension>::Transform(const Math::VectorMath::matrix<float,
 	}
 }
 
+#pragma region batch kernels
+namespace Renderer::Impl::AABBKernels
+{
+	static_assert(sizeof(AABB<2>) == sizeof(float[4]) && sizeof(AABB<3>) == sizeof(float[6]), "AABB expected to be tightly packed min/max");
+
+	template<unsigned dimension>
+	inline const AABB<dimension> &Fetch(const AABB<dimension> *base, size_t idx, size_t stride) noexcept
+	{
+		return *reinterpret_cast<const AABB<dimension> *>(reinterpret_cast<const std::byte *>(base) + idx * stride);
+	}
+
+	// min and max in xyz lanes, 2 overlapping loads to not read past AABB
+	inline std::pair<__m128, __m128> Load(const AABB<3> &aabb) noexcept
+	{
+		const float *const data = reinterpret_cast<const float *>(&aabb);
+		const __m128 hi = _mm_loadu_ps(data + 2);
+		return { _mm_loadu_ps(data), _mm_shuffle_ps(hi, hi, _MM_SHUFFLE(3, 3, 2, 1)) };
+	}
+
+	inline void Store(AABB<3> &aabb, __m128 min, __m128 max) noexcept
+	{
+		float *const data = reinterpret_cast<float *>(&aabb);
+		const __m128 seam = _mm_shuffle_ps(min, max, _MM_SHUFFLE(0, 0, 2, 2));	// [min.z, min.z, max.x, max.x]
+		_mm_storeu_ps(data, min);
+		_mm_storeu_ps(data + 2, _mm_shuffle_ps(seam, max, _MM_SHUFFLE(2, 1, 2, 0)));
+	}
+
+	class AffineXform
+	{
+		__m128 rows[3], absRows[3], translation;
+
+	public:
+		explicit AffineXform(const HLSL::float4x3 &xform) noexcept
+		{
+			const __m128 signMask = _mm_set1_ps(-0.f);
+			for (unsigned r = 0; r < 3; r++)
+			{
+				rows[r] = _mm_setr_ps(xform[r][0], xform[r][1], xform[r][2], 0.f);
+				absRows[r] = _mm_andnot_ps(signMask, rows[r]);
+			}
+			translation = _mm_setr_ps(xform[3][0], xform[3][1], xform[3][2], 0.f);
+		}
+
+	public:
+		std::pair<__m128, __m128> operator ()(__m128 min, __m128 max) const noexcept
+		{
+			const __m128 half = _mm_set1_ps(.5f);
+			const __m128 center = _mm_mul_ps(_mm_add_ps(min, max), half), extents = _mm_mul_ps(_mm_sub_ps(max, min), half);
+			__m128 xformedCenter = translation, xformedExtents = _mm_setzero_ps();
+			const auto xformAxis = [&]<unsigned int axis>() noexcept
+			{
+				constexpr int splat = _MM_SHUFFLE(axis, axis, axis, axis);
+				xformedCenter = _mm_add_ps(xformedCenter, _mm_mul_ps(_mm_shuffle_ps(center, center, splat), rows[axis]));
+				xformedExtents = _mm_add_ps(xformedExtents, _mm_mul_ps(_mm_shuffle_ps(extents, extents, splat), absRows[axis]));
+			};
+			xformAxis.operator ()<0>();
+			xformAxis.operator ()<1>();
+			xformAxis.operator ()<2>();
+			return { _mm_sub_ps(xformedCenter, xformedExtents), _mm_add_ps(xformedCenter, xformedExtents) };
+		}
+	};
+}
+
+template<>
+inline auto Renderer::RefitAABBs(const AABB<2> *src, size_t count, size_t stride) -> AABB<2>
+{
+	// [min.x, min.y, max.x, max.y]
+	__m128 min = _mm_set1_ps(+INFINITY), max = _mm_set1_ps(-INFINITY);
+	for (size_t i = 0; i < count; i++)
+	{
+		const __m128 cur = _mm_loadu_ps(reinterpret_cast<const float *>(&Impl::AABBKernels::Fetch(src, i, stride)));
+		min = _mm_min_ps(min, cur);
+		max = _mm_max_ps(max, cur);
+	}
+	AABB<2> result;
+	_mm_storeu_ps(reinterpret_cast<float *>(&result), _mm_shuffle_ps(min, max, _MM_SHUFFLE(3, 2, 1, 0)));
+	return result;
+}
+
+template<>
+inline auto Renderer::RefitAABBs(const AABB<3> *src, size_t count, size_t stride) -> AABB<3>
+{
+	using namespace Impl::AABBKernels;
+
+	__m128 min = _mm_set1_ps(+INFINITY), max = _mm_set1_ps(-INFINITY);
+	for (size_t i = 0; i < count; i++)
+	{
+		const auto [curMin, curMax] = Load(Fetch(src, i, stride));
+		min = _mm_min_ps(min, curMin);
+		max = _mm_max_ps(max, curMax);
+	}
+	AABB<3> result;
+	Store(result, min, max);
+	return result;
+}
+
+template<>
+inline void Renderer::TransformAABBs(const AABB<2> *src, AABB<2> *dst, size_t count, const Math::VectorMath::matrix<float, 3, 2> &xform, size_t srcStride)
+{
+	for (size_t i = 0; i < count; i++)
+		dst[i] = TransformAABB(Impl::AABBKernels::Fetch(src, i, srcStride), xform);
+}
+
+template<>
+inline void Renderer::TransformAABBs(const AABB<3> *src, AABB<3> *dst, size_t count, const HLSL::float4x3 &xform, size_t srcStride)
+{
+	using namespace Impl::AABBKernels;
+
+	const AffineXform affineXform(xform);
+	for (size_t i = 0; i < count; i++)
+	{
+		const auto [min, max] = Load(Fetch(src, i, srcStride));
+		const auto [xformedMin, xformedMax] = affineXform(min, max);
+		Store(dst[i], xformedMin, xformedMax);
+	}
+}
+
+template<>
+inline auto Renderer::TransformRefitAABBs(const AABB<2> *src, size_t count, const Math::VectorMath::matrix<float, 3, 2> &xform, size_t stride) -> AABB<2>
+{
+	AABB<2> result;
+	for (size_t i = 0; i < count; i++)
+		result.Refit(TransformAABB(Impl::AABBKernels::Fetch(src, i, stride), xform));
+	return result;
+}
+
+template<>
+inline auto Renderer::TransformRefitAABBs(const AABB<3> *src, size_t count, const HLSL::float4x3 &xform, size_t stride) -> AABB<3>
+{
+	using namespace Impl::AABBKernels;
+
+	const AffineXform affineXform(xform);
+	__m128 min = _mm_set1_ps(+INFINITY), max = _mm_set1_ps(-INFINITY);
+	for (size_t i = 0; i < count; i++)
+	{
+		const auto [curMin, curMax] = Load(Fetch(src, i, stride));
+		const auto [xformedMin, xformedMax] = affineXform(curMin, curMax);
+		min = _mm_min_ps(min, xformedMin);
+		max = _mm_max_ps(max, xformedMax);
+	}
+	AABB<3> result;
+	Store(result, min, max);
+	return result;
+}
+#pragma endregion
+
 template<>
 inline auto Renderer::AABB<2>::Center() const -> HLSL::float2
 {
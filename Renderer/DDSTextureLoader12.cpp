@@ -124,6 +124,9 @@ namespace
 
     inline HANDLE safe_handle(HANDLE h) { return (h == INVALID_HANDLE_VALUE) ? nullptr : h; }
 
+    // serializes file reads for 'DDS_LOADER_THROTTLE_IO' (HDD) loads, shared between whole-file and streamed paths
+    std::mutex ioThrottleMtx;
+
     template<UINT TNameLength>
     inline void SetDebugObjectName(_In_ ID3D12DeviceChild* resource, _In_z_ const wchar_t(&name)[TNameLength])
     {
@@ -233,8 +236,7 @@ namespace
 		FILE_STANDARD_INFO fileInfo;
 		DWORD BytesRead = 0;
 		{
-			static std::mutex mtx;
-			std::unique_lock lck(mtx, std::defer_lock);
+			std::unique_lock lck(ioThrottleMtx, std::defer_lock);
 			if (throttleIO)
 				lck.lock();
 
@@ -333,6 +335,249 @@ namespace
     }
 
 
+    //--------------------------------------------------------------------------------------
+    // Chunked overlapped file reader for streamed load
+    // header read first, then up to 'queueDepth' chunk reads kept in flight, refilled whenever consumer waits
+    //--------------------------------------------------------------------------------------
+    class FileStream final : public DDSFileStream
+    {
+        static constexpr DWORD chunkSize = 1ul << 20;
+        static constexpr unsigned queueDepth = 8;
+
+        struct Request
+        {
+            OVERLAPPED overlapped;
+            ScopedHandle event;
+            DWORD size;
+        };
+
+    private:
+        ScopedHandle hFile;
+        uint8_t* data = nullptr;
+        uint32_t fileSize = 0, issuedEnd = 0, completedEnd = 0;
+        Request requests[queueDepth] = {};
+        unsigned oldest = 0, inFlight = 0;
+        HRESULT status = S_OK;
+        std::unique_lock<std::mutex> throttleLock;
+
+    public:
+        FileStream() = default;
+        FileStream(FileStream&) = delete;
+        void operator =(FileStream&) = delete;
+        ~FileStream() override;
+
+    public:
+        HRESULT Open(
+            _In_z_ const wchar_t* fileName,
+            std::unique_ptr<uint8_t[]>& ddsData,
+            const DDS_HEADER** header,
+            const uint8_t** bitData,
+            size_t* bitSize,
+            bool throttleIO);
+        HRESULT __cdecl WaitFor(_In_ const void* dataEnd) noexcept override;
+        HRESULT __cdecl WaitForAll() noexcept override;
+
+    private:
+        HRESULT Issue(Request& request, uint32_t offset, DWORD size) noexcept;
+        void Refill() noexcept;
+        HRESULT Retire(bool wait) noexcept;
+    };
+
+    FileStream::~FileStream()
+    {
+        // reads target caller`s buffer => have to be drained before it gets freed
+        if (inFlight)
+        {
+            CancelIoEx(hFile.get(), nullptr);
+            for (DWORD transferred; inFlight; oldest = (oldest + 1) % queueDepth, inFlight--)
+                GetOverlappedResult(hFile.get(), &requests[oldest].overlapped, &transferred, TRUE);
+        }
+    }
+
+    HRESULT FileStream::Open(
+        const wchar_t* fileName,
+        std::unique_ptr<uint8_t[]>& ddsData,
+        const DDS_HEADER** header,
+        const uint8_t** bitData,
+        size_t* bitSize,
+        bool throttleIO)
+    {
+        if (!header || !bitData || !bitSize)
+        {
+            return E_POINTER;
+        }
+
+        // held until last chunk arrives
+        if (throttleIO)
+            throttleLock = std::unique_lock(ioThrottleMtx);
+
+        // open the file for overlapped I/O
+        CREATEFILE2_EXTENDED_PARAMETERS params = { sizeof params, FILE_ATTRIBUTE_NORMAL, FILE_FLAG_OVERLAPPED | FILE_FLAG_SEQUENTIAL_SCAN };
+        hFile.reset(safe_handle(CreateFile2(fileName,
+            GENERIC_READ,
+            FILE_SHARE_READ,
+            OPEN_EXISTING,
+            &params)));
+
+        if (!hFile)
+        {
+            return HRESULT_FROM_WIN32(GetLastError());
+        }
+
+        // Get the file size
+        FILE_STANDARD_INFO fileInfo;
+        if (!GetFileInformationByHandleEx(hFile.get(), FileStandardInfo, &fileInfo, sizeof(fileInfo)))
+        {
+            return HRESULT_FROM_WIN32(GetLastError());
+        }
+
+        // File is too big for 32-bit allocation, so reject read
+        if (fileInfo.EndOfFile.HighPart > 0)
+        {
+            return E_FAIL;
+        }
+
+        // Need at least enough data to fill the header and magic number to be a valid DDS
+        fileSize = fileInfo.EndOfFile.LowPart;
+        if (fileSize < (sizeof(DDS_HEADER) + sizeof(uint32_t)))
+        {
+            return E_FAIL;
+        }
+
+        // create enough space for the file data
+        ddsData.reset(new (std::nothrow) uint8_t[fileSize]);
+        if (!ddsData)
+        {
+            return E_OUTOFMEMORY;
+        }
+        data = ddsData.get();
+
+        for (auto& request : requests)
+        {
+            request.event.reset(CreateEventEx(nullptr, nullptr, CREATE_EVENT_MANUAL_RESET, EVENT_MODIFY_STATE | SYNCHRONIZE));
+            if (!request.event)
+            {
+                return HRESULT_FROM_WIN32(GetLastError());
+            }
+        }
+
+        // read header first, texture layout becomes known before bulk of the data arrives
+        issuedEnd = std::min<uint32_t>(fileSize, sizeof(uint32_t) + sizeof(DDS_HEADER) + sizeof(DDS_HEADER_DXT10));
+        if (HRESULT hr = Issue(requests[oldest], 0, issuedEnd); FAILED(hr))
+        {
+            return hr;
+        }
+        inFlight = 1;
+        if (HRESULT hr = Retire(true); FAILED(hr))
+        {
+            return hr;
+        }
+
+        // validate header before queuing up chunk reads
+        if (HRESULT hr = LoadTextureDataFromMemory(data, fileSize, header, bitData, bitSize); FAILED(hr))
+        {
+            return hr;
+        }
+
+        // chunk reads proceed while caller creates texture
+        Refill();
+
+        return status;
+    }
+
+    HRESULT FileStream::WaitFor(const void* dataEnd) noexcept
+    {
+        const auto end = static_cast<const uint8_t*>(dataEnd) - data;
+        assert(end >= 0 && end <= fileSize);
+
+        while (SUCCEEDED(status) && completedEnd < end)
+        {
+            Refill();
+            if (SUCCEEDED(status))
+                Retire(true);
+        }
+
+        // keep queue full: reap already finished reads without blocking and issue next ones
+        while (SUCCEEDED(status) && inFlight && Retire(false) == S_OK);
+        Refill();
+
+        return FAILED(status) ? status : S_OK;
+    }
+
+    HRESULT FileStream::WaitForAll() noexcept
+    {
+        return WaitFor(data + fileSize);
+    }
+
+    HRESULT FileStream::Issue(Request& request, uint32_t offset, DWORD size) noexcept
+    {
+        request.overlapped = {};
+        request.overlapped.Offset = offset;
+        request.overlapped.hEvent = request.event.get();
+        request.size = size;
+
+        // may complete synchronously, event gets signaled in either case
+        if (!ReadFile(hFile.get(), data + offset, size, nullptr, &request.overlapped))
+        {
+            if (const DWORD error = GetLastError(); error != ERROR_IO_PENDING)
+            {
+                return HRESULT_FROM_WIN32(error);
+            }
+        }
+
+        return S_OK;
+    }
+
+    void FileStream::Refill() noexcept
+    {
+        while (SUCCEEDED(status) && inFlight < queueDepth && issuedEnd < fileSize)
+        {
+            const DWORD size = std::min(chunkSize, fileSize - issuedEnd);
+            if (FAILED(status = Issue(requests[(oldest + inFlight) % queueDepth], issuedEnd, size)))
+                return;
+            issuedEnd += size;
+            inFlight++;
+        }
+    }
+
+    // retires oldest request (reads complete in order of issue from consumer point of view), S_FALSE if still pending (non-blocking mode only)
+    HRESULT FileStream::Retire(bool wait) noexcept
+    {
+        assert(inFlight);
+
+        auto& request = requests[oldest];
+        DWORD transferred = 0;
+        if (!GetOverlappedResult(hFile.get(), &request.overlapped, &transferred, wait))
+        {
+            const DWORD error = GetLastError();
+            if (!wait && error == ERROR_IO_INCOMPLETE)
+            {
+                return S_FALSE;
+            }
+            status = HRESULT_FROM_WIN32(error);
+        }
+        else if (transferred < request.size)
+        {
+            status = HRESULT_FROM_WIN32(ERROR_HANDLE_EOF);
+        }
+
+        // request is no longer in flight regardless of its outcome
+        oldest = (oldest + 1) % queueDepth;
+        inFlight--;
+
+        if (FAILED(status))
+        {
+            return status;
+        }
+
+        // let next throttled load go as soon as this file is done
+        if ((completedEnd += request.size) == fileSize && throttleLock)
+            throttleLock.unlock();
+
+        return S_OK;
+    }
+
+
     //--------------------------------------------------------------------------------------
     // Return the BPP for a particular format
     //--------------------------------------------------------------------------------------
@@ -1668,3 +1913,78 @@ HRESULT DirectX::LoadDDSTextureFromFileEx(
 
     return hr;
 }
+
+_Use_decl_annotations_
+HRESULT DirectX::LoadDDSTextureFromFileStreamed(
+    ID3D12Device* d3dDevice,
+    const wchar_t* fileName,
+    size_t maxsize,
+    D3D12_RESOURCE_FLAGS resFlags,
+    unsigned int loadFlags,
+    DDS_CPU_ACCESS_FLAGS CPUAccessFlags,
+    ID3D12Resource** texture,
+    std::unique_ptr<uint8_t[]>& ddsData,
+    std::vector<D3D12_SUBRESOURCE_DATA>& subresources,
+    std::unique_ptr<DDSFileStream>& stream,
+    DDS_ALPHA_MODE* alphaMode,
+    bool* isCubeMap)
+{
+    stream.reset();
+    if (texture)
+    {
+        *texture = nullptr;
+    }
+    if (alphaMode)
+    {
+        *alphaMode = DDS_ALPHA_MODE_UNKNOWN;
+    }
+    if (isCubeMap)
+    {
+        *isCubeMap = false;
+    }
+
+    if (!d3dDevice || !fileName || !texture)
+    {
+        return E_INVALIDARG;
+    }
+
+    std::unique_ptr<FileStream> fileStream(new (std::nothrow) FileStream);
+    if (!fileStream)
+    {
+        return E_OUTOFMEMORY;
+    }
+
+    const DDS_HEADER* header = nullptr;
+    const uint8_t* bitData = nullptr;
+    size_t bitSize = 0;
+
+    HRESULT hr = fileStream->Open(fileName,
+        ddsData,
+        &header,
+        &bitData,
+        &bitSize,
+        loadFlags & DDS_LOADER_THROTTLE_IO
+    );
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    // only header consumed here, subresources just point into 'ddsData' being filled in background
+    hr = CreateTextureFromDDS(d3dDevice,
+        header, bitData, bitSize, maxsize,
+        resFlags, loadFlags, CPUAccessFlags,
+        texture, subresources, isCubeMap);
+
+    if (SUCCEEDED(hr))
+    {
+        SetDebugTextureInfo(fileName, texture);
+
+        if (alphaMode)
+            *alphaMode = GetAlphaMode(header);
+
+        stream = std::move(fileStream);
+    }
+
+    return hr;
+}
@@ -179,4 +179,31 @@ namespace DirectX
         std::vector<D3D12_SUBRESOURCE_DATA>& subresources,
         _Out_opt_ DDS_ALPHA_MODE* alphaMode = nullptr,
         _Out_opt_ bool* isCubeMap = nullptr);
+
+    // Background reader filling 'ddsData' for streamed version
+    // data covered by successful 'WaitFor' can be accessed, dtor cancels outstanding reads (have to be destroyed before 'ddsData')
+    class __declspec(novtable) DDSFileStream
+    {
+    public:
+        virtual ~DDSFileStream() = default;
+
+    public:
+        virtual HRESULT __cdecl WaitFor(_In_ const void* dataEnd) noexcept = 0;
+        virtual HRESULT __cdecl WaitForAll() noexcept = 0;
+    };
+
+    // Streamed version: texture created after reading header only, texture data arrives via 'stream' by chunked overlapped reads
+    HRESULT __cdecl LoadDDSTextureFromFileStreamed(
+        _In_ ID3D12Device* d3dDevice,
+        _In_z_ const wchar_t* szFileName,
+        size_t maxsize,
+        D3D12_RESOURCE_FLAGS resFlags,
+        unsigned int loadFlags,
+        DDS_CPU_ACCESS_FLAGS CPUAccessFlags,
+        _Outptr_ ID3D12Resource** texture,
+        std::unique_ptr<uint8_t[]>& ddsData,
+        std::vector<D3D12_SUBRESOURCE_DATA>& subresources,
+        std::unique_ptr<DDSFileStream>& stream,
+        _Out_opt_ DDS_ALPHA_MODE* alphaMode = nullptr,
+        _Out_opt_ bool* isCubeMap = nullptr);
 }
@@ -2,6 +2,8 @@
 #include "DMA engine.h"
 #include "texture.hh"
 #include "event handle.h"
+#include "memory accounting.h"
+#include "subresource copy.h"
 #include "align.h"
 
 #define DEFER_UPLOADS_SUBMISSION 1
@@ -22,7 +24,8 @@ static constexpr auto batchLenLimit = /*1024u*/256u;
 static const GUID uploadBatchMarkerGUID =
 { 0xb21bd34f, 0x2b98, 0x46c2, { 0xba, 0x23, 0x8a, 0xbd, 0x9, 0x39, 0x22, 0x51 } };
 
-static UINT64 lastBatchID, consumedBatchID/*batch containing consumed resources (e.g. textures binded to materials) => have to be uploaded before frame starts*/;
+static UINT64 lastBatchID;
+static atomic<UINT64> consumedBatchID/*batch containing consumed resources (e.g. textures binded to materials) => have to be uploaded before frame starts*/;	// updated concurrently (textures acquired from worker threads)
 static UINT64 curBatchSuballocOffset;
 static UINT curBatchLen;
 
@@ -179,26 +182,16 @@ ComPtr<ID3D12Fence> DMA::Impl::CreateFence()
 	return fence;
 }
 
-void DMA::Upload2VRAM(const ComPtr<ID3D12Resource> &dst, const vector<D3D12_SUBRESOURCE_DATA> &src, LPCWSTR name)
+/*
+	batching and upload chunk suballocation shared by texture and buffer uploads
+	'suballocate' called under lock (possibly twice on batch overflow) advances 'curBatchSuballocOffset' and returns allocated range
+	'recordCopies' records GPU copies from upload chunk, 'copyData' fills mapped upload chunk (after mutex unlock if possible)
+*/
+template<typename Suballocate, typename RecordCopies, typename CopyData>
+static void Upload(const ComPtr<ID3D12Resource> &dst, unsigned int opCount, const Suballocate &suballocate, const RecordCopies &recordCopies, const CopyData &copyData)
 {
-	assert(dmaQueue);
-
 	unique_lock lck(mtx);
 
-	// use C++20 make_unique_default_init & monotonic_buffer_resource or allocation fusion
-	const auto layouts = make_unique<D3D12_PLACED_SUBRESOURCE_FOOTPRINT []>(src.size());
-	const auto numRows = make_unique<UINT []>(src.size());
-	const auto rowSizes = make_unique<UINT64 []>(src.size());
-	const auto suballocate = [&, dstDesc = dst->GetDesc()]
-	{
-		curBatchSuballocOffset = AlignSize<D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT>(curBatchSuballocOffset);
-		UINT64 totalSize;
-		device->GetCopyableFootprints(&dstDesc, 0, src.size(), curBatchSuballocOffset, layouts.get(), numRows.get(), rowSizes.get(), &totalSize);
-		D3D12_RANGE allocation{ curBatchSuballocOffset };
-		allocation.End = curBatchSuballocOffset += totalSize;
-		return allocation;
-	};
-
 	auto allocRange = suballocate();
 	auto *curBatch = uploadQueue + CurRingIdx();
 
@@ -238,21 +231,18 @@ void DMA::Upload2VRAM(const ComPtr<ID3D12Resource> &dst, const vector<D3D12_SUBR
 			NULL,	// clear value
 			IID_PPV_ARGS(curBatch->chunk.ReleaseAndGetAddressOf())));
 		NameObjectF(curBatch->chunk.Get(), L"DMA engine upload chunk [%u][%lu]", CurRingIdx(), curBatch->chunkVersion++);
+		MemoryAccounting::Track(curBatch->chunk.Get(), MemoryAccounting::Category::DMAUpload);
 	}
 
 	// advance counter, mark batch as started (curBatchLen > 0)
-	curBatchLen += src.size();
+	curBatchLen += opCount;
 	assert(curBatchLen);
 
 	// keep dst ref
 	curBatch->outstandingRefs.push_back(dst);
 
 	// record GPU commands for DMA engine
-	for (unsigned i = 0; i < src.size(); i++)
-	{
-		const CD3DX12_TEXTURE_COPY_LOCATION cpyDst(dst.Get(), i), cpySrc(curBatch->chunk.Get(), layouts[i]);
-		cmdList->CopyTextureRegion(&cpyDst, 0, 0, 0, &cpySrc, NULL);
-	}
+	recordCopies(cmdList.Get(), curBatch->chunk.Get());
 
 	/*
 	defer memcpys to perform after mutex unlock to enable multithreaded copy
@@ -270,12 +260,7 @@ void DMA::Upload2VRAM(const ComPtr<ID3D12Resource> &dst, const vector<D3D12_SUBR
 			// copy data to upload chunk
 			std::byte *uploadPtr;
 			CheckHR(curBatch->chunk->Map(0, &CD3DX12_RANGE(0, 0), reinterpret_cast<void **>(&uploadPtr)));
-			for (unsigned i = 0; i < src.size(); i++)
-			{
-				const auto &curLayout = layouts[i];
-				const D3D12_MEMCPY_DEST cpyDst = { uploadPtr + curLayout.Offset, curLayout.Footprint.RowPitch, curLayout.Footprint.RowPitch * numRows[i] };
-				MemcpySubresource(&cpyDst, &src[i], rowSizes[i], numRows[i], curLayout.Footprint.Depth);
-			}
+			copyData(uploadPtr);
 			curBatch->chunk->Unmap(0, &allocRange);
 
 			// set upload batch marker
@@ -296,6 +281,87 @@ void DMA::Upload2VRAM(const ComPtr<ID3D12Resource> &dst, const vector<D3D12_SUBR
 	}
 }
 
+void DMA::Upload2VRAM(const ComPtr<ID3D12Resource> &dst, const vector<D3D12_SUBRESOURCE_DATA> &src, LPCWSTR name, const function<void (unsigned subresource)> &waitForSrc)
+{
+	assert(dmaQueue);
+
+	// use C++20 make_unique_default_init & monotonic_buffer_resource or allocation fusion
+	const auto layouts = make_unique<D3D12_PLACED_SUBRESOURCE_FOOTPRINT []>(src.size());
+	const auto numRows = make_unique<UINT []>(src.size());
+	const auto rowSizes = make_unique<UINT64 []>(src.size());
+	const auto dstDesc = dst->GetDesc();
+
+	// subresources [first, end)
+	const auto UploadRange = [&](unsigned first, unsigned end)
+	{
+		const auto suballocate = [&]
+		{
+			curBatchSuballocOffset = AlignSize<D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT>(curBatchSuballocOffset);
+			UINT64 totalSize;
+			device->GetCopyableFootprints(&dstDesc, first, end - first, curBatchSuballocOffset, layouts.get() + first, numRows.get() + first, rowSizes.get() + first, &totalSize);
+			D3D12_RANGE allocation{ curBatchSuballocOffset };
+			allocation.End = curBatchSuballocOffset += totalSize;
+			return allocation;
+		};
+		const auto recordCopies = [&](ID3D12GraphicsCommandList *cmdList, ID3D12Resource *chunk)
+		{
+			for (unsigned i = first; i < end; i++)
+			{
+				const CD3DX12_TEXTURE_COPY_LOCATION cpyDst(dst.Get(), i), cpySrc(chunk, layouts[i]);
+				cmdList->CopyTextureRegion(&cpyDst, 0, 0, 0, &cpySrc, NULL);
+			}
+		};
+		const auto copyData = [&](std::byte *uploadPtr)
+		{
+			for (unsigned i = first; i < end; i++)
+			{
+				const auto &curLayout = layouts[i];
+				const D3D12_MEMCPY_DEST cpyDst = { uploadPtr + curLayout.Offset, curLayout.Footprint.RowPitch, curLayout.Footprint.RowPitch * numRows[i] };
+				Renderer::Impl::SubresourceCopy::Copy(cpyDst, src[i], rowSizes[i], numRows[i], curLayout.Footprint.Depth, true);	// upload heap is write-combined
+			}
+		};
+		Upload(dst, end - first, suballocate, recordCopies, copyData);
+	};
+
+	/*
+		src still streaming in => wait for each subresource before it joins a batch
+		waiting within batch would stall every other upload as batch flush waits for its copies under DMA engine lock
+	*/
+	if (waitForSrc)
+		for (unsigned i = 0; i < src.size(); i++)
+		{
+			waitForSrc(i);
+			UploadRange(i, i + 1);
+		}
+	else
+		UploadRange(0, src.size());
+}
+
+void DMA::Upload2VRAM(const ComPtr<ID3D12Resource> &dst, UINT64 dstOffset, span<const std::byte> src, LPCWSTR name)
+{
+	assert(dmaQueue);
+
+	UINT64 srcOffset;
+	const auto suballocate = [&]
+	{
+		srcOffset = curBatchSuballocOffset = AlignSize<16u>(curBatchSuballocOffset);	// keep streaming stores aligned
+		D3D12_RANGE allocation{ srcOffset };
+		allocation.End = curBatchSuballocOffset += src.size();
+		return allocation;
+	};
+	const auto recordCopies = [&](ID3D12GraphicsCommandList *cmdList, ID3D12Resource *chunk)
+	{
+		cmdList->CopyBufferRegion(dst.Get(), dstOffset, chunk, srcOffset, src.size());
+	};
+	const auto copyData = [&](std::byte *uploadPtr)
+	{
+		const D3D12_MEMCPY_DEST cpyDst = { uploadPtr + srcOffset, src.size(), src.size() };
+		const D3D12_SUBRESOURCE_DATA cpySrc = { src.data(), LONG_PTR(src.size()), LONG_PTR(src.size()) };
+		Renderer::Impl::SubresourceCopy::Copy(cpyDst, cpySrc, src.size(), 1, 1, true);
+	};
+	Upload(dst, 1, suballocate, recordCopies, copyData);
+}
+
 // have to be called before 'Sync()'
 void DMA::TrackUsage(ID3D12Resource *res)
 {
@@ -305,7 +371,8 @@ void DMA::TrackUsage(ID3D12Resource *res)
 	{
 		CheckHR(hr);
 		assert(markerSize == sizeof uploadBatchMarker);
-		consumedBatchID = max(consumedBatchID, uploadBatchMarker);
+		// atomic max
+		for (UINT64 cur = consumedBatchID.load(memory_order_relaxed); cur < uploadBatchMarker && !consumedBatchID.compare_exchange_weak(cur, uploadBatchMarker, memory_order_relaxed););
 	}
 	// do nothing if DXGI_ERROR_NOT_FOUND - it means that resource placed in sys RAM and wasn't uploaded via DMA engine
 }
@@ -315,11 +382,12 @@ void DMA::Sync()
 	if (dmaQueue)
 	{
 		lock_guard lck(mtx);
+		const UINT64 waitBatchID = consumedBatchID.load(memory_order_relaxed);
 #		if DEFER_UPLOADS_SUBMISSION
-		if (consumedBatchID > lastBatchID)
+		if (waitBatchID > lastBatchID)
 #		endif
 			FlushPendingUploads(Texture::PendingLoadsCompleted());
-		if (fence->GetCompletedValue() < consumedBatchID)
+		if (fence->GetCompletedValue() < waitBatchID)
 		{
 			/*
 			it's called on beginning of a frame (waiting inserted at GFX queue) while end of the frame gets signaled by frame versioning fence
@@ -329,7 +397,7 @@ void DMA::Sync()
 			for more robust handling one may always insert additional signal (e.g. ~0) in frame versioning dtor (and wait for it)
 			it would ensure proper waiting regardless of whether last GFX queue operation was frame finish
 			*/
-			CheckHR(gfxQueue->Wait(fence.Get(), consumedBatchID));
+			CheckHR(gfxQueue->Wait(fence.Get(), waitBatchID));
 		}
 		CleanupFinishedUploads();
 	}
@@ -14,7 +14,10 @@ namespace Renderer::DMA
 	}
 
 	// replace vector with C++20 span
-	void Upload2VRAM(const WRL::ComPtr<ID3D12Resource> &dst, const std::vector<D3D12_SUBRESOURCE_DATA> &src, LPCWSTR name);
+	// 'waitForSrc' called before reading each src subresource (outside of DMA engine lock), allows for src data still streaming in, should not throw
+	void Upload2VRAM(const WRL::ComPtr<ID3D12Resource> &dst, const std::vector<D3D12_SUBRESOURCE_DATA> &src, LPCWSTR name, const std::function<void (unsigned subresource)> &waitForSrc = {});
+	// buffer region, 'dst' expected to be in common state (implicitly promoted on copy queue)
+	void Upload2VRAM(const WRL::ComPtr<ID3D12Resource> &dst, UINT64 dstOffset, std::span<const std::byte> src, LPCWSTR name);
 	void TrackUsage(ID3D12Resource *res);
 	void Sync();
 }
\ No newline at end of file
@@ -0,0 +1,318 @@
+#include "stdafx.h"
+#include "GPU culling.h"
+#include "GPU descriptor heap.h"
+#include "memory accounting.h"
+#include "frame versioning.h"
+#include "system.h"
+#include "shader bytecode.h"
+#include "tracked resource.inl"
+#include "cmdlist pool.inl"
+
+// keep separate mul/add as GPU kernel does under 'precise', results still can differ near plane boundaries (e.g. GPU flushes denormals)
+#pragma fp_contract(off)
+
+namespace Shaders
+{
+#	include "GPUCulling.csh"
+}
+
+using namespace std;
+using namespace Renderer::Impl;
+using namespace GPUCulling;
+using WRL::ComPtr;
+
+extern ComPtr<ID3D12Device2> device;
+void NameObject(ID3D12Object *object, LPCWSTR name) noexcept, NameObjectF(ID3D12Object *object, LPCWSTR format, ...) noexcept;
+
+namespace
+{
+	// root constants, keep in sync with 'Params' cbuffer in GPUCulling.hlsl
+	struct Constants
+	{
+		Frustum frustum;
+		uint objectCount, ZHistoryAvailable, secondPhase;
+	};
+	static_assert(sizeof(Constants) == sizeof(float[4][6]) + sizeof(float[4][4]) + sizeof(float[2]) + sizeof(uint[3]));
+}
+
+Frustum GPUCulling::MakeFrustum(const HLSL::float4x4 &frustumXform, uint ZHistoryWidth, uint ZHistoryHeight)
+{
+	Frustum frustum;
+
+	// planes from xform columns, the same as for 'FrustumCuller'
+	for (unsigned i = 0; i < 4; i++)
+	{
+		const float x = frustumXform[i][0], y = frustumXform[i][1], z = frustumXform[i][2], w = frustumXform[i][3];
+		frustum.planes[0][i] = -x - w;	// -X
+		frustum.planes[1][i] = +x - w;	// +X
+		frustum.planes[2][i] = -y - w;	// -Y
+		frustum.planes[3][i] = +y - w;	// +Y
+		frustum.planes[4][i] = -z;		// -Z
+		frustum.planes[5][i] = +z - w;	// +Z
+		for (unsigned j = 0; j < 4; j++)
+			frustum.xform[i][j] = frustumXform[i][j];
+	}
+
+	frustum.texelNDCSize[0] = ZHistoryWidth ? 2.f / ZHistoryWidth : 0.f;
+	frustum.texelNDCSize[1] = ZHistoryHeight ? 2.f / ZHistoryHeight : 0.f;
+
+	return frustum;
+}
+
+void GPUCulling::CullReference(const Frustum &frustum, const Node *nodes, const Object *objects, uint objectCount, const ZHistory &zHistory, uint *visibility)
+{
+	transform(execution::par, objects, objects + objectCount, visibility, [&](const Object &object)
+	{
+		return Cull(frustum, nodes[object.node], object, zHistory);
+	});
+}
+
+ComPtr<ID3D12RootSignature> Scene::CreateRootSig()
+{
+	ComPtr<ID3D12RootSignature> CreateRootSignature(const D3D12_VERSIONED_ROOT_SIGNATURE_DESC &desc, LPCWSTR name);
+	CD3DX12_ROOT_PARAMETER1 rootParams[ROOT_PARAM_COUNT];
+	rootParams[ROOT_PARAM_CONSTANTS].InitAsConstants(sizeof(Constants) / sizeof(uint), 0);
+	rootParams[ROOT_PARAM_NODES_SRV].InitAsShaderResourceView(1, 0, D3D12_ROOT_DESCRIPTOR_FLAG_DATA_STATIC);
+	rootParams[ROOT_PARAM_OBJECTS_SRV].InitAsShaderResourceView(2, 0, D3D12_ROOT_DESCRIPTOR_FLAG_DATA_STATIC);
+	rootParams[ROOT_PARAM_DRAWS_SRV].InitAsShaderResourceView(3, 0, D3D12_ROOT_DESCRIPTOR_FLAG_DATA_STATIC);
+	rootParams[ROOT_PARAM_ARGS_UAV].InitAsUnorderedAccessView(0);
+	rootParams[ROOT_PARAM_COUNTERS_UAV].InitAsUnorderedAccessView(1);
+	rootParams[ROOT_PARAM_VISIBILITY_UAV].InitAsUnorderedAccessView(2);
+	const CD3DX12_DESCRIPTOR_RANGE1 ZHistoryRange(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 0, 0, D3D12_DESCRIPTOR_RANGE_FLAG_DESCRIPTORS_VOLATILE);
+	rootParams[ROOT_PARAM_Z_HISTORY_DESC_TABLE].InitAsDescriptorTable(1, &ZHistoryRange);
+	const CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC sigDesc(size(rootParams), rootParams);
+	return CreateRootSignature(sigDesc, L"GPU culling root signature");
+}
+
+DeferredPSO Scene::CreatePSO()
+{
+	const D3D12_COMPUTE_PIPELINE_STATE_DESC PSO_desc =
+	{
+		rootSig.Get(),							// root signature
+		ShaderBytecode(Shaders::GPUCulling),	// CS
+		0,										// node mask
+		{},										// cached PSO
+		D3D12_PIPELINE_STATE_FLAG_NONE			// flags
+	};
+
+	return globalPSOLibrary->Compile(PSO_desc, L"GPU culling PSO");
+}
+
+Scene::Scene(const vector<Node> &nodes, const vector<Object> &objects, const vector<Draw> &draws, vector<Bucket> &&buckets, uint cmdSlotCount) :
+	buckets(move(buckets)),
+	objectsOffset(sizeof(Node) * nodes.size()),
+	drawsOffset(objectsOffset + sizeof(Object) * objects.size()),
+	zerosOffset(drawsOffset + sizeof(Draw) * draws.size()),
+	objectCount(objects.size()), drawCount(draws.size()),
+	nodes(nodes), objects(objects)
+{
+	assert(!objects.empty() && !draws.empty());
+
+	// scene buffer
+	{
+		CheckHR(device->CreateCommittedResource(
+			&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
+			D3D12_HEAP_FLAG_NONE,
+			&CD3DX12_RESOURCE_DESC::Buffer(zerosOffset + sizeof(uint) * drawCount),
+			D3D12_RESOURCE_STATE_GENERIC_READ,
+			NULL,	// clear value
+			IID_PPV_ARGS(sceneBuffer.GetAddressOf())));
+		NameObjectF(sceneBuffer.Get(), L"GPU culling scene (%u objects, %zu nodes)", objectCount, nodes.size());
+		MemoryAccounting::Track(sceneBuffer.Get(), MemoryAccounting::Category::GPUCulling);
+
+		static_assert(is_trivially_copyable_v<Node> && is_trivially_copyable_v<Object> && is_trivially_copyable_v<Draw>);
+		char *mapped;
+		CheckHR(sceneBuffer->Map(0, &CD3DX12_RANGE(0, 0), reinterpret_cast<void **>(&mapped)));
+		memcpy(mapped, nodes.data(), objectsOffset);
+		memcpy(mapped + objectsOffset, objects.data(), drawsOffset - objectsOffset);
+		memcpy(mapped + drawsOffset, draws.data(), zerosOffset - drawsOffset);
+		memset(mapped + zerosOffset, 0, sizeof(uint) * drawCount);
+		sceneBuffer->Unmap(0, NULL);
+	}
+
+	// args
+	CheckHR(device->CreateCommittedResource(
+		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
+		D3D12_HEAP_FLAG_NONE,
+		&CD3DX12_RESOURCE_DESC::Buffer(UINT64(cmdSlotCount) * indirectCmdSize, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS),
+		D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT,
+		NULL,	// clear value
+		IID_PPV_ARGS(args.GetAddressOf())));
+	NameObjectF(args.Get(), L"GPU culling indirect args (%u cmds)", cmdSlotCount);
+	MemoryAccounting::Track(args.Get(), MemoryAccounting::Category::GPUCulling);
+
+	// counters
+	CheckHR(device->CreateCommittedResource(
+		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
+		D3D12_HEAP_FLAG_NONE,
+		&CD3DX12_RESOURCE_DESC::Buffer(sizeof(uint) * drawCount, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS),
+		D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT,
+		NULL,	// clear value
+		IID_PPV_ARGS(counters.GetAddressOf())));
+	NameObjectF(counters.Get(), L"GPU culling indirect counters (%u draws)", drawCount);
+	MemoryAccounting::Track(counters.Get(), MemoryAccounting::Category::GPUCulling);
+
+	// visibility, stays in UAV state
+	CheckHR(device->CreateCommittedResource(
+		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
+		D3D12_HEAP_FLAG_NONE,
+		&CD3DX12_RESOURCE_DESC::Buffer(sizeof(uint) * objectCount, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS),
+		D3D12_RESOURCE_STATE_UNORDERED_ACCESS,
+		NULL,	// clear value
+		IID_PPV_ARGS(visibility.GetAddressOf())));
+	NameObjectF(visibility.Get(), L"GPU culling visibility (%u objects)", objectCount);
+	MemoryAccounting::Track(visibility.Get(), MemoryAccounting::Category::GPUCulling);
+}
+
+void Scene::Cull(CmdListPool::CmdList &cmdList, const HLSL::float4x4 &frustumXform, ID3D12Resource *ZBuffer, bool secondPhase) const
+{
+	namespace GPUDescriptorHeap = Descriptors::GPUDescriptorHeap;
+
+	// Z view (null descriptor if unavailable, not accessed by shader in that case)
+	D3D12_CPU_DESCRIPTOR_HANDLE ZHistorySRV;
+	const auto ZHistoryDescTable = GPUDescriptorHeap::AllocateCurFrameTransientDescs(1, ZHistorySRV);
+	const D3D12_SHADER_RESOURCE_VIEW_DESC ZHistorySRVDesc =
+	{
+		.Format						= DXGI_FORMAT_R24_UNORM_X8_TYPELESS,
+		.ViewDimension				= D3D12_SRV_DIMENSION_TEXTURE2DMS,
+		.Shader4ComponentMapping	= D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING
+	};
+	device->CreateShaderResourceView(ZBuffer, &ZHistorySRVDesc, ZHistorySRV);
+
+	Constants constants{ .objectCount = objectCount, .ZHistoryAvailable = ZBuffer != NULL, .secondPhase = secondPhase };
+	if (ZBuffer)
+	{
+		const auto ZBufferDesc = ZBuffer->GetDesc();
+		constants.frustum = MakeFrustum(frustumXform, UINT(ZBufferDesc.Width), ZBufferDesc.Height);
+	}
+	else
+		constants.frustum = MakeFrustum(frustumXform, 0, 0);
+
+	// 1st phase results validated (frustum culling happens there)
+	extern atomic<bool> validateGPUCulling;
+	const bool validate = !secondPhase && validateGPUCulling.load(memory_order_relaxed) && ScheduleValidation(constants.frustum);
+
+	// reset counters
+	cmdList.ResourceBarrier(
+	{
+		CD3DX12_RESOURCE_BARRIER::Transition(counters.Get(), D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT, D3D12_RESOURCE_STATE_COPY_DEST),
+		CD3DX12_RESOURCE_BARRIER::Transition(args.Get(), D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT, D3D12_RESOURCE_STATE_UNORDERED_ACCESS)
+	});
+	cmdList.FlushBarriers<true>();
+	cmdList->CopyBufferRegion(counters.Get(), 0, sceneBuffer.Get(), zerosOffset, sizeof(uint) * drawCount);
+	cmdList.ResourceBarrier(
+	{
+		CD3DX12_RESOURCE_BARRIER::Transition(counters.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_UNORDERED_ACCESS),
+		CD3DX12_RESOURCE_BARRIER::UAV(visibility.Get())	// previous cull (1st phase for 2nd one)
+	});
+	cmdList.FlushBarriers<true>();
+
+	// cull
+	const auto sceneGPUAddress = sceneBuffer->GetGPUVirtualAddress();
+	ID3D12DescriptorHeap *const descHeaps[] = { GPUDescriptorHeap::GetHeap().Get() };
+	cmdList->SetDescriptorHeaps(size(descHeaps), descHeaps);
+	cmdList->SetPipelineState(PSO.Get());
+	cmdList->SetComputeRootSignature(rootSig.Get());
+	cmdList->SetComputeRoot32BitConstants(ROOT_PARAM_CONSTANTS, sizeof constants / sizeof(uint), &constants, 0);
+	cmdList->SetComputeRootShaderResourceView(ROOT_PARAM_NODES_SRV, sceneGPUAddress);
+	cmdList->SetComputeRootShaderResourceView(ROOT_PARAM_OBJECTS_SRV, sceneGPUAddress + objectsOffset);
+	cmdList->SetComputeRootShaderResourceView(ROOT_PARAM_DRAWS_SRV, sceneGPUAddress + drawsOffset);
+	cmdList->SetComputeRootUnorderedAccessView(ROOT_PARAM_ARGS_UAV, args->GetGPUVirtualAddress());
+	cmdList->SetComputeRootUnorderedAccessView(ROOT_PARAM_COUNTERS_UAV, counters->GetGPUVirtualAddress());
+	cmdList->SetComputeRootUnorderedAccessView(ROOT_PARAM_VISIBILITY_UAV, visibility->GetGPUVirtualAddress());
+	cmdList->SetComputeRootDescriptorTable(ROOT_PARAM_Z_HISTORY_DESC_TABLE, ZHistoryDescTable);
+	cmdList->Dispatch((objectCount + groupSize - 1) / groupSize, 1, 1);
+
+	// copy out cull results for validation
+	if (validate)
+	{
+		cmdList.ResourceBarrier(CD3DX12_RESOURCE_BARRIER::Transition(visibility.Get(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_COPY_SOURCE));
+		cmdList.FlushBarriers<true>();
+		cmdList->CopyResource(visibilityReadback.Get(), visibility.Get());
+		cmdList.ResourceBarrier(CD3DX12_RESOURCE_BARRIER::Transition(visibility.Get(), D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS));
+	}
+
+	// results => indirect args
+	cmdList.ResourceBarrier(
+	{
+		CD3DX12_RESOURCE_BARRIER::Transition(args.Get(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT),
+		CD3DX12_RESOURCE_BARRIER::Transition(counters.Get(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT)
+	});
+}
+
+// returns true if cull results should be copied out to 'visibilityReadback', launches check of previous copy once GPU is done with it
+bool Scene::ScheduleValidation(const Frustum &frustum) const
+{
+	lock_guard lck(validationMtx);
+
+	// previous check still reads 'visibilityReadback'
+	if (validationTask.valid())
+	{
+		if (validationTask.wait_for(0s) != future_status::ready)
+			return false;
+		validationTask.get();
+	}
+
+	if (pendingValidation)
+	{
+		if (globalFrameVersioning->GetCompletedFrameID() < pendingValidation->frameID)
+			return false;
+		validationTask = async(launch::async, &Scene::Validate, this, *pendingValidation);
+		pendingValidation.reset();
+		return false;
+	}
+
+	if (!visibilityReadback)
+	{
+		CheckHR(device->CreateCommittedResource(
+			&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_READBACK),
+			D3D12_HEAP_FLAG_NONE,
+			&CD3DX12_RESOURCE_DESC::Buffer(sizeof(uint) * objectCount),
+			D3D12_RESOURCE_STATE_COPY_DEST,
+			NULL,	// clear value
+			IID_PPV_ARGS(visibilityReadback.GetAddressOf())));
+		NameObjectF(visibilityReadback.Get(), L"GPU culling visibility readback (%u objects)", objectCount);
+		MemoryAccounting::Track(visibilityReadback.Get(), MemoryAccounting::Category::GPUCulling);
+	}
+
+	pendingValidation = { globalFrameVersioning->GetCurFrameID(), frustum };
+	return true;
+}
+
+/*
+	Z history contents are not available on CPU => reference culls against frustum only
+	frustum results compared directly, objects GPU culled by occlusion expected to pass frustum test
+	mismatches are reported rather than asserted as GPU float behavior (denormals flush, instruction selection) can flip results for AABBs touching frustum planes
+*/
+void Scene::Validate(const PendingValidation &validation) const noexcept
+{
+	try
+	{
+		vector<uint> reference(objectCount);
+		CullReference(validation.frustum, nodes.data(), objects.data(), objectCount, ZHistory{}, reference.data());
+
+		void *mapped;
+		if (const HRESULT hr = visibilityReadback->Map(0, &CD3DX12_RANGE(0, sizeof(uint) * objectCount), &mapped); FAILED(hr))
+		{
+			System::WideIOGuard IOGuard(stderr);
+			wcerr << "Fail to map GPU culling visibility readback, validation skipped: " << _com_error(hr).ErrorMessage() << endl;
+			return;
+		}
+		const auto results = static_cast<const uint *>(mapped);
+		unsigned long int mismatches = 0;
+		for (uint i = 0; i < objectCount; i++)
+			mismatches += results[i] > VISIBLE || (results[i] == CULLED_FRUSTUM) != (reference[i] == CULLED_FRUSTUM);
+		visibilityReadback->Unmap(0, &CD3DX12_RANGE(0, 0));
+
+		if (mismatches)
+		{
+			System::WideIOGuard IOGuard(stderr);
+			wcerr << "GPU culling validation: " << mismatches << " of " << objectCount << " objects frustum culled differently from CPU reference (frame " << validation.frameID << ")." << endl;
+		}
+	}
+	catch (const exception &error)
+	{
+		System::WideIOGuard IOGuard(stderr);
+		wcerr << "GPU culling validation failed: " << error.what() << '.' << endl;
+	}
+}
\ No newline at end of file
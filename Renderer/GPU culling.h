@@ -0,0 +1,125 @@
+#pragma once
+
+#include "stdafx.h"
+#include "tracked resource.h"
+#include "cmdlist pool.h"
+#include "PSO library.h"
+
+extern void __cdecl InitRenderer();
+
+namespace Renderer
+{
+	class Instance;
+}
+
+namespace Renderer::Impl::GPUCulling
+{
+	namespace HLSL = Math::VectorMath::HLSL;
+	typedef unsigned int uint;
+
+	// Z history as seen by CPU reference kernel, 0 size means unavailable
+	// depth expected to be decoded to float the same way as D3D does for UNORM (e.g. from readback)
+	struct ZHistory
+	{
+		uint width, height;
+		const float *depth;
+
+	public:
+		float Load(uint x, uint y) const noexcept { return depth[y * width + x]; }
+	};
+}
+
+namespace Renderer::Impl
+{
+#	define precise
+#	include "GPU culling.hlsli"
+#	undef precise
+}
+
+namespace Renderer::Impl::GPUCulling
+{
+	Frustum MakeFrustum(const HLSL::float4x4 &frustumXform, uint ZHistoryWidth, uint ZHistoryHeight);
+
+	// CPU reference for compute kernel, 'visibility' receives per object cull result
+	void CullReference(const Frustum &frustum, const Node *nodes, const Object *objects, uint objectCount, const ZHistory &zHistory, uint *visibility);
+
+	// flattened BVH uploaded once, culled on GPU each frame producing ExecuteIndirect args
+	class Scene
+	{
+		friend extern void __cdecl ::InitRenderer();
+
+	public:
+		// instances sharing 3D object, draws for its subobjects follow each other
+		struct Bucket
+		{
+			const Renderer::Instance *instance;	// any of bucket's instances, provides object to render
+			uint maxInstanceCount;
+			UINT64 argsOffset, countersOffset;
+		};
+
+	private:
+		enum
+		{
+			ROOT_PARAM_CONSTANTS,
+			ROOT_PARAM_NODES_SRV,
+			ROOT_PARAM_OBJECTS_SRV,
+			ROOT_PARAM_DRAWS_SRV,
+			ROOT_PARAM_ARGS_UAV,
+			ROOT_PARAM_COUNTERS_UAV,
+			ROOT_PARAM_VISIBILITY_UAV,
+			ROOT_PARAM_Z_HISTORY_DESC_TABLE,
+			ROOT_PARAM_COUNT
+		};
+
+	private:
+		static WRL::ComPtr<ID3D12RootSignature> rootSig, CreateRootSig();
+		static DeferredPSO PSO, CreatePSO();
+
+	private:
+		TrackedResource<ID3D12Resource> sceneBuffer;			// upload heap: nodes, objects, draws, zeros for counters reset
+		TrackedResource<ID3D12Resource> args, counters, visibility;	// default heap, kept in indirect argument state between culls
+		std::vector<Bucket> buckets;
+		UINT64 objectsOffset, drawsOffset, zerosOffset;
+		uint objectCount, drawCount;
+
+	private:
+		// validation against 'CullReference()', single readback in flight shared by all views culling the scene, checked asynchronously off the recording path
+		struct PendingValidation
+		{
+			UINT64 frameID;
+			Frustum frustum;
+		};
+		const std::vector<Node> nodes;
+		const std::vector<Object> objects;
+		mutable std::mutex validationMtx;
+		mutable TrackedResource<ID3D12Resource> visibilityReadback;
+		mutable std::optional<PendingValidation> pendingValidation;
+		mutable std::future<void> validationTask;	// declared last => dtor waits for it before data it reads gets destroyed
+
+	public:
+		// 'cmdSlotCount' is total capacity of all draws' cmd ranges in args buffer
+		Scene(const std::vector<Node> &nodes, const std::vector<Object> &objects, const std::vector<Draw> &draws, std::vector<Bucket> &&buckets, uint cmdSlotCount);
+		Scene(Scene &) = delete;
+		void operator =(Scene &) = delete;
+
+	public:
+		const auto &GetBuckets() const noexcept { return buckets; }
+		ID3D12Resource *GetArgs() const noexcept { return args.Get(); }
+		ID3D12Resource *GetCounters() const noexcept { return counters.Get(); }
+		// per object cull results of last cull, can be copied out to compare against 'CullReference()'
+		ID3D12Resource *GetVisibility() const noexcept { return visibility.Get(); }
+
+	public:
+		/*
+			1st phase culls all objects against frustum and previous frame's Z ('ZBuffer' = Z history)
+			2nd phase retests objects occluded in 1st one against current frame's Z ('ZBuffer' = copy of Z after drawing 1st phase results)
+			so objects which became visible this frame get drawn without a frame delay, args/counters reused by both phases
+			'cmdList' expected to be already set up, 'ZBuffer' expected in NON_PIXEL_SHADER_RESOURCE state, NULL disables occlusion culling
+		*/
+		void Cull(CmdListPool::CmdList &cmdList, const HLSL::float4x4 &frustumXform, ID3D12Resource *ZBuffer, bool secondPhase) const;
+
+	private:
+		bool ScheduleValidation(const Frustum &frustum) const;
+		void Validate(const PendingValidation &validation) const noexcept;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,159 @@
+#pragma once
+
+/*
+	GPU culling kernel shared by compute shader and its CPU reference ("GPU culling.h")
+	only exactly rounded ops used (add, mul, compare, int <-> float for small ints), 'precise' prevents fusion/reassociation on GPU (empty on CPU where fp_contract is off instead)
+	CPU reference still may disagree for AABBs touching frustum planes (e.g. GPU flushes denormals), 'Scene' validation reports such mismatches
+	perspective divide avoided: screen rect found by comparing clip space coords against texel boundaries scaled by w, occlusion test done in the same manner
+	'ZHistory' should be defined by includer, it provides 'width', 'height' (0 if unavailable) and 'Load(x, y)'
+*/
+namespace GPUCulling
+{
+	static const uint groupSize = 64;
+	static const uint maxOcclusionTexels = 64;	// bigger screen rects treated as visible (Z history has no mips)
+	static const uint indirectCmdSize = 28;		// instance data CBV (8) + DrawIndexedInstanced args (20)
+
+	// cull results
+	static const uint CULLED_FRUSTUM = 0, CULLED_OCCLUSION = 1, VISIBLE = 2;
+
+	struct Node
+	{
+		float center[3], extents[3];
+	};
+
+	struct Object
+	{
+		float center[3], extents[3];
+		uint node;
+		uint drawsBegin, drawsEnd;	// draw per subobject, shared between instances of the same 3D object
+		uint instanceCB[2];			// GPU VA (lo, hi)
+	};
+
+	struct Draw
+	{
+		uint indexCount, startIndex;
+		int baseVertex;
+		uint argsOffset;	// 1st cmd slot in args buffer, draw idx used for counter
+	};
+
+	struct Frustum
+	{
+		float planes[6][4];		// outside if dot(plane.xyz, p) + plane.w - dot(abs(plane.xyz), extents) > 0
+		float xform[4][4];		// row vector convention
+		float texelNDCSize[2];	// 2 / Z history size
+	};
+
+	inline float Abs(float x)
+	{
+		return x < 0 ? -x : x;
+	}
+
+	inline bool FrustumCull(Frustum frustum, float center[3], float extents[3])
+	{
+		for (uint i = 0; i < 6; i++)
+		{
+			precise float dist = frustum.planes[i][0] * center[0] + frustum.planes[i][1] * center[1] + frustum.planes[i][2] * center[2] + frustum.planes[i][3];
+			precise float offset = Abs(frustum.planes[i][0]) * extents[0] + Abs(frustum.planes[i][1]) * extents[1] + Abs(frustum.planes[i][2]) * extents[2];
+			if (dist - offset > 0)
+				return true;
+		}
+		return false;
+	}
+
+	// last column which left boundary is not to the right of clip space point (x, w), w > 0
+	inline uint TexelColumn(float x, float w, float texelNDCSize, uint size)
+	{
+		uint first = 0, last = size - 1;
+		while (first < last)
+		{
+			const uint mid = (first + last + 1) / 2;
+			precise float boundary = (float(mid) * texelNDCSize - 1) * w;
+			if (x >= boundary)
+				first = mid;
+			else
+				last = mid - 1;
+		}
+		return first;
+	}
+
+	// rows go top to bottom while NDC y goes up
+	inline uint TexelRow(float y, float w, float texelNDCSize, uint size)
+	{
+		uint first = 0, last = size - 1;
+		while (first < last)
+		{
+			const uint mid = (first + last + 1) / 2;
+			precise float boundary = (1 - float(mid) * texelNDCSize) * w;
+			if (y <= boundary)
+				first = mid;
+			else
+				last = mid - 1;
+		}
+		return first;
+	}
+
+	// AABB is occluded if all its corners are behind farthest Z history texel within its screen rect
+	inline bool OcclusionCull(Frustum frustum, float center[3], float extents[3], ZHistory zHistory)
+	{
+		if (zHistory.width == 0 || zHistory.height == 0)
+			return false;
+
+		float z[8], w[8];
+		uint colMin = zHistory.width - 1, colMax = 0, rowMin = zHistory.height - 1, rowMax = 0;
+		for (uint corner = 0; corner < 8; corner++)
+		{
+			precise float x = (corner & 1u) != 0 ? center[0] + extents[0] : center[0] - extents[0];
+			precise float y = (corner & 2u) != 0 ? center[1] + extents[1] : center[1] - extents[1];
+			precise float h = (corner & 4u) != 0 ? center[2] + extents[2] : center[2] - extents[2];
+			precise float clipX = x * frustum.xform[0][0] + y * frustum.xform[1][0] + h * frustum.xform[2][0] + frustum.xform[3][0];
+			precise float clipY = x * frustum.xform[0][1] + y * frustum.xform[1][1] + h * frustum.xform[2][1] + frustum.xform[3][1];
+			precise float clipZ = x * frustum.xform[0][2] + y * frustum.xform[1][2] + h * frustum.xform[2][2] + frustum.xform[3][2];
+			precise float clipW = x * frustum.xform[0][3] + y * frustum.xform[1][3] + h * frustum.xform[2][3] + frustum.xform[3][3];
+
+			// crosses eye plane
+			if (!(clipW > 0))
+				return false;
+
+			const uint col = TexelColumn(clipX, clipW, frustum.texelNDCSize[0], zHistory.width), row = TexelRow(clipY, clipW, frustum.texelNDCSize[1], zHistory.height);
+			colMin = col < colMin ? col : colMin;
+			colMax = col > colMax ? col : colMax;
+			rowMin = row < rowMin ? row : rowMin;
+			rowMax = row > rowMax ? row : rowMax;
+			z[corner] = clipZ;
+			w[corner] = clipW;
+		}
+
+		if ((colMax - colMin + 1) * (rowMax - rowMin + 1) > maxOcclusionTexels)
+			return false;
+
+		float farthest = 0;
+		for (uint row = rowMin; row <= rowMax; row++)
+			for (uint col = colMin; col <= colMax; col++)
+			{
+				const float depth = zHistory.Load(col, row);
+				farthest = depth > farthest ? depth : farthest;
+			}
+
+		for (uint corner = 0; corner < 8; corner++)
+		{
+			precise float threshold = farthest * w[corner];
+			if (!(z[corner] > threshold))
+				return false;
+		}
+		return true;
+	}
+
+	// 1st phase, 'zHistory' is previous frame's Z
+	inline uint Cull(Frustum frustum, Node node, Object object, ZHistory zHistory)
+	{
+		if (FrustumCull(frustum, node.center, node.extents) || FrustumCull(frustum, object.center, object.extents))
+			return CULLED_FRUSTUM;
+		return OcclusionCull(frustum, object.center, object.extents, zHistory) ? CULLED_OCCLUSION : VISIBLE;
+	}
+
+	// 2nd phase for objects 'Cull()' found occluded, 'zBuffer' is current frame's Z after 1st phase draws => disoccluded objects get drawn this frame
+	inline uint Recull(Frustum frustum, Object object, ZHistory zBuffer)
+	{
+		return OcclusionCull(frustum, object.center, object.extents, zBuffer) ? CULLED_OCCLUSION : VISIBLE;
+	}
+}
\ No newline at end of file
@@ -2,6 +2,7 @@
 #include "GPU descriptor heap.h"
 #include "tonemap resource views stage.h"
 #include "frame versioning.h"
+#include "memory accounting.h"
 #include "tracked resource.inl"
 
 // Kepler driver issue workaround, it fails to create heap after a lot of textures have been created
@@ -12,13 +13,15 @@ using namespace Renderer::Impl;
 using namespace Descriptors;
 
 extern Microsoft::WRL::ComPtr<ID3D12Device2> device;
-static constexpr auto heapStaticBlockSize = TonemapResourceViewsStage::ViewCount * maxFrameLatency;
+static constexpr unsigned transientDescsPerFrame = 16;
+static constexpr auto heapStaticBlockSize = (TonemapResourceViewsStage::ViewCount + transientDescsPerFrame) * maxFrameLatency;
 static UINT heapSize = heapStaticBlockSize;
 decltype(GPUDescriptorHeap::AllocationClient::registeredClients) GPUDescriptorHeap::AllocationClient::registeredClients;
 #if ENABLE_PREALLOCATION
 static constexpr UINT preallocSize = 16384U;
 static bool commited;
 #endif
+static mutex clientsMtx;	// clients can be created/destroyed concurrently (e.g. bulk 3D objects loading), guards heap recreation as well
 
 static TrackedResource<ID3D12DescriptorHeap> CreateHeap(UINT size)
 {
@@ -34,6 +37,7 @@ static TrackedResource<ID3D12DescriptorHeap> CreateHeap(UINT size)
 	};
 	CheckHR(device->CreateDescriptorHeap(&desc, IID_PPV_ARGS(heap.GetAddressOf())));
 	NameObjectF(heap.Get(), L"GPU descriptor heap [%lu] (heap start CPU address: %p)", version++, heap->GetCPUDescriptorHandleForHeapStart());
+	Renderer::MemoryAccounting::Track(heap.Get(), Renderer::MemoryAccounting::Category::Descriptors);
 	return heap;
 }
 
@@ -50,6 +54,8 @@ using GPUDescriptorHeap::Impl::heap;
 
 void GPUDescriptorHeap::OnFrameStart()
 {
+	lock_guard lck(clientsMtx);
+
 #if ENABLE_PREALLOCATION
 	if (!commited)
 #else
@@ -92,8 +98,37 @@ D3D12_GPU_DESCRIPTOR_HANDLE GPUDescriptorHeap::SetCurFrameTonemapReductionDescs(
 	return CD3DX12_GPU_DESCRIPTOR_HANDLE(GetHeap()->GetGPUDescriptorHandleForHeapStart(), GPUHeapOffset);
 }
 
+D3D12_GPU_DESCRIPTOR_HANDLE GPUDescriptorHeap::AllocateCurFrameTransientDescs(unsigned count, D3D12_CPU_DESCRIPTOR_HANDLE &CPU_handle)
+{
+	static mutex mtx;
+	static UINT64 frameID;
+	static unsigned allocated;
+
+	unsigned offset;
+	{
+		lock_guard lck(mtx);
+		if (const auto curFrameID = globalFrameVersioning->GetCurFrameID(); frameID != curFrameID)
+		{
+			frameID = curFrameID;
+			allocated = 0;
+		}
+		if (allocated + count > transientDescsPerFrame)
+			throw overflow_error("Per-frame transient descriptors exhausted.");
+		offset = allocated;
+		allocated += count;
+	}
+
+	// transient block follows tonemap reduction descs
+	const auto descriptorSize = device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+	const auto GPUHeapOffset = (TonemapResourceViewsStage::ViewCount * maxFrameLatency + globalFrameVersioning->GetContinuousRingIdx() * transientDescsPerFrame + offset) * descriptorSize;
+	CPU_handle = CD3DX12_CPU_DESCRIPTOR_HANDLE(GetHeap()->GetCPUDescriptorHandleForHeapStart(), GPUHeapOffset);
+	return CD3DX12_GPU_DESCRIPTOR_HANDLE(GetHeap()->GetGPUDescriptorHandleForHeapStart(), GPUHeapOffset);
+}
+
 GPUDescriptorHeap::AllocationClient::AllocationClient(unsigned allocSize)
 {
+	lock_guard lck(clientsMtx);
+
 	// force heap to recreate on next frame
 #if ENABLE_PREALLOCATION
 	commited = false;
@@ -109,6 +144,7 @@ GPUDescriptorHeap::AllocationClient::AllocationClient(unsigned allocSize)
 // heap recreation is not mandatory, just descriptor memory would not be reclaimed and would remain wasted (trade it for perf here)
 GPUDescriptorHeap::AllocationClient::~AllocationClient()
 {
+	lock_guard lck(clientsMtx);
 	heapSize -= clientLocation->second;
 	registeredClients.erase(clientLocation);
 }
\ No newline at end of file
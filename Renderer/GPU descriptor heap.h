@@ -22,6 +22,8 @@ namespace Renderer::Impl::Descriptors
 		inline const auto &GetHeap() noexcept { return Impl::heap; }
 		void OnFrameStart();
 		D3D12_GPU_DESCRIPTOR_HANDLE SetCurFrameTonemapReductionDescs(const TonemapResourceViewsStage &src);
+		// descriptors for views created on the fly, valid during current frame only
+		D3D12_GPU_DESCRIPTOR_HANDLE AllocateCurFrameTransientDescs(unsigned count, D3D12_CPU_DESCRIPTOR_HANDLE &CPU_handle);
 
 		class AllocationClient
 		{
@@ -2,6 +2,7 @@
 #include "GPU stream buffer allocator.h"
 #include "tracked resource.inl"
 #include "frame versioning.h"
+#include "memory accounting.h"
 
 using namespace std;
 using namespace Renderer::Impl::GPUStreamBuffer;
@@ -19,6 +20,7 @@ void AllocatorBase::AllocateChunk(const D3D12_RESOURCE_DESC &chunkDesc, LPCWSTR
 		NULL,	// clear value
 		IID_PPV_ARGS(chunk.ReleaseAndGetAddressOf())));
 	NameObjectF(chunk.Get(), L"%ls (chunk[%lu])", resourceName, chunkVersion++);
+	Renderer::MemoryAccounting::Track(chunk.Get(), Renderer::MemoryAccounting::Category::StreamBuffers);
 }
 
 pair<ID3D12Resource *, unsigned long> AllocatorBase::Allocate(unsigned long count, unsigned itemSize, unsigned long allocGranularity, LPCWSTR resourceName)
@@ -1,6 +1,7 @@
 #include "stdafx.h"
 #include "GPU texture sampler tables.h"
 #include "config.h"
+#include "memory accounting.h"
 
 using namespace Renderer::Impl::Descriptors;
 using Microsoft::WRL::ComPtr;
@@ -43,6 +44,7 @@ ComPtr<ID3D12DescriptorHeap> TextureSamplers::Impl::CreateHeap()
 		};
 		CheckHR(device->CreateDescriptorHeap(&desc, IID_PPV_ARGS(result.GetAddressOf())));
 		NameObject(result.Get(), L"GPU texture sampler heap");
+		Renderer::MemoryAccounting::Track(result.Get(), Renderer::MemoryAccounting::Category::Descriptors);
 	}
 
 	// fill
@@ -32,6 +32,7 @@ namespace Renderer::Impl::RenderPipeline
 
 	private:
 		friend PipelineItem GetNext(unsigned int &length);
+		friend class IRenderStage;
 		PipelineItem() = default;
 		PipelineItem(ID3D12GraphicsCommandList4 *cmdList) : variant(cmdList) {}
 	};
@@ -13,7 +13,8 @@ extern pmr::synchronized_pool_resource globalTransientRAM;
 extern ComPtr<ID3D12CommandQueue> gfxQueue;
 
 /*
-Current tasks wait implementation based on 'condition_variable' notification mechanism.
+Current tasks wait implementation based on C++20 atomic wait/notify on wakeup counter (futex-like).
+Completing task bumps counter, 'Run()' samples it before inspecting pipeline and ROB and sleeps only if it hasn't changed since, so no wakeups get lost.
 
 'launch::async' policy required in order to guarantee deadlocks elimination that are possible if stdlib select deferred launch policy.
 It forces stdlib to launch dedicated thread for task but MSVC implementation is non-conforming in that regard and uses thread pool.
@@ -35,7 +36,7 @@ namespace
 	constexpr unsigned int targetCmdListWorkSize = 1'00u, GPUSubmitWorkSizeThreshold = 1'000u;
 
 	mutex mtx;
-	condition_variable workReadyEvent;
+	atomic<unsigned int> wakeups;
 	struct WorkBatch
 	{
 		pmr::vector<RenderPipeline::RenderStageItem::Work> work{ &globalTransientRAM };
@@ -133,6 +134,12 @@ namespace
 	typedef packaged_task<decltype(RecordCmdList)> RecordCmdListTask;
 #endif
 
+	inline void Wakeup() noexcept
+	{
+		wakeups.fetch_add(1, memory_order_release);
+		wakeups.notify_one();
+	}
+
 	inline void LaunchRecordCmdList(RecordCmdListTask &&task, WorkBatch &&batch, CmdListPool::CmdList &&target)
 	{
 		task(move(batch), move(target));
@@ -140,15 +147,14 @@ namespace
 			lock_guard lck(mtx);
 			runningTaskCount--;
 		}
-		workReadyEvent.notify_one();
+		Wakeup();
 	}
 
-	inline void LaunchBuildRenderStage(packaged_task<RenderPipeline::PipelineStage ()> &&buildRenderStage)
+	inline void LaunchBuildRenderStage(packaged_task<RenderPipeline::PipelineStage ()> &&buildRenderStage, RenderPipeline::StageSlot &slot)
 	{
 		buildRenderStage();
-		mtx.lock();
-		mtx.unlock();
-		workReadyEvent.notify_one();
+		RenderPipeline::StageReady(slot);
+		Wakeup();
 	}
 
 	void FlushWorkBatch(unique_lock<decltype(mtx)> &lck)
@@ -158,7 +164,7 @@ namespace
 		const auto lastCapacity = workBatch.work.capacity();
 		ROB.emplace_back(PendingWork{ task.get_future(), targetCmdListWorkSize - workBatchFreeSpace, workBatch.suspended });
 
-		auto asyncRef = async(launch::async, LaunchRecordCmdList, move(task), move(workBatch), CmdListPool::CmdList());
+		auto asyncRef = async(launch::async, LaunchRecordCmdList, move(task), move(workBatch), CmdListPool::CmdList(targetCmdListWorkSize - workBatchFreeSpace));
 		auto lckSentry(move(lck));
 		pendingAsyncRefs.push_back(move(asyncRef));
 		lckSentry.swap(lck);
@@ -183,8 +189,8 @@ namespace Renderer::GPUWorkSubmission
 {
 	void AppendRenderStage(packaged_task<RenderPipeline::PipelineStage()> &&buildRenderStage)
 	{
-		RenderPipeline::AppendStage(buildRenderStage.get_future());
-		auto asyncRef = async(launch::async, LaunchBuildRenderStage, move(buildRenderStage));
+		auto &slot = RenderPipeline::AppendAsyncStage(buildRenderStage.get_future());
+		auto asyncRef = async(launch::async, LaunchBuildRenderStage, move(buildRenderStage), ref(slot));
 		unique_lock lckSentry(mtx, adopt_lock);
 		pendingAsyncRefs.push_back(move(asyncRef));
 		lckSentry.release();
@@ -196,9 +202,10 @@ void GPUWorkSubmission::Run()
 	{
 		unique_lock lck(mtx, adopt_lock);
 
-		do
+		for (;;)
 		{
-			workReadyEvent.wait(lck);
+			// sample before inspecting pipeline and ROB, completions happening meanwhile would make wait below return immediately
+			const auto observedWakeups = wakeups.load(memory_order_acquire);
 
 			// launch command lists recording
 			while (workBatch.work.empty() || runningTaskCount < targetTaskCount)
@@ -248,14 +255,22 @@ void GPUWorkSubmission::Run()
 				++(readyWorkEnd = doneWorkEnd);
 				readyWorkSize = doneWorkSize;
 			}
-			if (readyWorkSize >= GPUSubmitWorkSizeThreshold || RenderPipeline::Empty() && readyWorkEnd == ROB.end())
+			if (readyWorkEnd != ROB.begin() && (readyWorkSize >= GPUSubmitWorkSizeThreshold || RenderPipeline::Empty() && readyWorkEnd == ROB.end()))
 			{
 				static vector<ID3D12CommandList *> listsToExequte;
 				listsToExequte.assign(ROB.begin(), readyWorkEnd);
 				gfxQueue->ExecuteCommandLists(listsToExequte.size(), listsToExequte.data());
 				ROB.erase(ROB.begin(), readyWorkEnd);
 			}
-		} while (!ROB.empty() || !RenderPipeline::Empty());
+
+			if (ROB.empty() && RenderPipeline::Empty())
+				break;
+
+			// sleep until stage build or cmd list recording completes
+			lck.unlock();
+			wakeups.wait(observedWakeups, memory_order_acquire);
+			lck.lock();
+		}
 	}
 
 	pendingAsyncRefs.clear();
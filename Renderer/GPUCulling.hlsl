@@ -0,0 +1,89 @@
+Texture2DMS<float> ZHistoryTex : register(t0);
+
+struct ZHistory
+{
+	uint width, height;
+
+	float Load(uint x, uint y)
+	{
+		return ZHistoryTex.Load(int2(x, y), 0);
+	}
+};
+
+#include "GPU culling.hlsli"
+
+// root constants, layout matches GPUCulling::Frustum followed by counts
+cbuffer Params : register(b0)
+{
+	float4 planes[6];
+	row_major float4x4 frustumXform;
+	float2 texelNDCSize;
+	uint objectCount, ZHistoryAvailable, secondPhase;
+};
+
+StructuredBuffer<GPUCulling::Node> nodes : register(t1);
+StructuredBuffer<GPUCulling::Object> objects : register(t2);
+StructuredBuffer<GPUCulling::Draw> draws : register(t3);
+RWByteAddressBuffer args : register(u0);
+RWByteAddressBuffer counters : register(u1);
+RWByteAddressBuffer visibility : register(u2);	// per object cull result for validation against CPU reference, 2nd phase input
+
+[numthreads(GPUCulling::groupSize, 1, 1)]
+void main(in uint objectIdx : SV_DispatchThreadID)
+{
+	if (objectIdx >= objectCount)
+		return;
+
+	GPUCulling::Frustum frustum;
+	[unroll]
+	for (uint i = 0; i < 6; i++)
+	{
+		frustum.planes[i][0] = planes[i].x;
+		frustum.planes[i][1] = planes[i].y;
+		frustum.planes[i][2] = planes[i].z;
+		frustum.planes[i][3] = planes[i].w;
+	}
+	[unroll]
+	for (uint r = 0; r < 4; r++)
+		[unroll]
+		for (uint c = 0; c < 4; c++)
+			frustum.xform[r][c] = frustumXform[r][c];
+	frustum.texelNDCSize[0] = texelNDCSize.x;
+	frustum.texelNDCSize[1] = texelNDCSize.y;
+
+	ZHistory zHistory;
+	zHistory.width = zHistory.height = 0;
+	if (ZHistoryAvailable)
+	{
+		uint sampleCount;
+		ZHistoryTex.GetDimensions(zHistory.width, zHistory.height, sampleCount);
+	}
+
+	const GPUCulling::Object object = objects[objectIdx];
+	uint result;
+	if (secondPhase)
+	{
+		// retest objects occluded by previous frame's Z against current one, 1st phase results kept for validation
+		if (visibility.Load(objectIdx * 4) != GPUCulling::CULLED_OCCLUSION)
+			return;
+		result = GPUCulling::Recull(frustum, object, zHistory);
+	}
+	else
+	{
+		result = GPUCulling::Cull(frustum, nodes[object.node], object, zHistory);
+		visibility.Store(objectIdx * 4, result);
+	}
+
+	// append cmd into each subobject's bucket
+	if (result == GPUCulling::VISIBLE)
+		for (uint drawIdx = object.drawsBegin; drawIdx < object.drawsEnd; drawIdx++)
+		{
+			const GPUCulling::Draw draw = draws[drawIdx];
+			uint slot;
+			counters.InterlockedAdd(drawIdx * 4, 1, slot);
+			const uint cmdOffset = (draw.argsOffset + slot) * GPUCulling::indirectCmdSize;
+			args.Store2(cmdOffset, uint2(object.instanceCB[0], object.instanceCB[1]));
+			args.Store4(cmdOffset + 8, uint4(draw.indexCount, 1, draw.startIndex, asuint(draw.baseVertex)));
+			args.Store(cmdOffset + 24, 0);
+		}
+}
\ No newline at end of file
@@ -0,0 +1,351 @@
+#include "stdafx.h"
+#include "PSO library.h"
+#include "system.h"
+
+using namespace std;
+using namespace Renderer;
+using Impl::DeferredPSO;
+using Impl::PSOLibrary;
+using Microsoft::WRL::ComPtr;
+
+extern ComPtr<ID3D12Device2> device;
+void NameObject(ID3D12Object *object, LPCWSTR name) noexcept;
+
+namespace
+{
+	// FNV-1a, unlike std::hash stable across runs/builds
+	class Hasher
+	{
+		uint64_t hash = 0xcbf29ce484222325ull;
+
+	public:
+		void Bytes(const void *data, size_t size) noexcept
+		{
+			for (const unsigned char octet : span((const unsigned char *)data, size))
+				hash = (hash ^ octet) * 0x100000001b3ull;
+		}
+
+		void String(const char *str) noexcept
+		{
+			if (str)
+				Bytes(str, strlen(str) + 1);
+		}
+
+		void Shader(const D3D12_SHADER_BYTECODE &shader) noexcept
+		{
+			Bytes(shader.pShaderBytecode, shader.BytecodeLength);
+			Fields(shader.BytecodeLength);
+		}
+
+		// should not contain padding
+		template<typename ...Field>
+		void Fields(const Field &...fields) noexcept
+		{
+			(Bytes(&fields, sizeof fields), ...);
+		}
+
+	public:
+		operator uint64_t() const noexcept { return hash; }
+	};
+
+	// root signature not covered (it is not serializable back), its mismatch detected by library
+	uint64_t Hash(const D3D12_GRAPHICS_PIPELINE_STATE_DESC &desc) noexcept
+	{
+		Hasher hasher;
+
+		for (const auto &shader : { desc.VS, desc.PS, desc.DS, desc.HS, desc.GS })
+			hasher.Shader(shader);
+
+		for (const auto &entry : span(desc.StreamOutput.pSODeclaration, desc.StreamOutput.NumEntries))
+		{
+			hasher.String(entry.SemanticName);
+			hasher.Fields(entry.Stream, entry.SemanticIndex, entry.StartComponent, entry.ComponentCount, entry.OutputSlot);
+		}
+		hasher.Bytes(desc.StreamOutput.pBufferStrides, desc.StreamOutput.NumStrides * sizeof *desc.StreamOutput.pBufferStrides);
+		hasher.Fields(desc.StreamOutput.RasterizedStream);
+
+		// render target blend desc has padding after write mask
+		hasher.Fields(desc.BlendState.AlphaToCoverageEnable, desc.BlendState.IndependentBlendEnable);
+		for (const auto &RT : desc.BlendState.RenderTarget)
+			hasher.Fields(RT.BlendEnable, RT.LogicOpEnable, RT.SrcBlend, RT.DestBlend, RT.BlendOp, RT.SrcBlendAlpha, RT.DestBlendAlpha, RT.BlendOpAlpha, RT.LogicOp, RT.RenderTargetWriteMask);
+
+		hasher.Fields(desc.SampleMask, desc.RasterizerState);
+
+		// stencil masks followed by padding
+		const auto &DS = desc.DepthStencilState;
+		hasher.Fields(DS.DepthEnable, DS.DepthWriteMask, DS.DepthFunc, DS.StencilEnable, DS.StencilReadMask, DS.StencilWriteMask, DS.FrontFace, DS.BackFace);
+
+		for (const auto &element : span(desc.InputLayout.pInputElementDescs, desc.InputLayout.NumElements))
+		{
+			hasher.String(element.SemanticName);
+			hasher.Fields(element.SemanticIndex, element.Format, element.InputSlot, element.AlignedByteOffset, element.InputSlotClass, element.InstanceDataStepRate);
+		}
+
+		hasher.Fields(desc.IBStripCutValue, desc.PrimitiveTopologyType, desc.NumRenderTargets, desc.RTVFormats, desc.DSVFormat, desc.SampleDesc, desc.NodeMask, desc.Flags);
+
+		return hasher;
+	}
+
+	uint64_t Hash(const D3D12_COMPUTE_PIPELINE_STATE_DESC &desc) noexcept
+	{
+		Hasher hasher;
+		hasher.Shader(desc.CS);
+		hasher.Fields(desc.NodeMask, desc.Flags);
+		return hasher;
+	}
+
+	// deep copy of stuff referenced by desc which can go out of scope before async compilation
+	class GraphicsDescCapture
+	{
+		ComPtr<ID3D12RootSignature> rootSig;
+		vector<D3D12_INPUT_ELEMENT_DESC> inputLayout;
+		vector<D3D12_SO_DECLARATION_ENTRY> SODecl;
+		vector<UINT> SOStrides;
+
+	public:
+		D3D12_GRAPHICS_PIPELINE_STATE_DESC desc;
+
+	public:
+		explicit GraphicsDescCapture(const D3D12_GRAPHICS_PIPELINE_STATE_DESC &src) :
+			rootSig(src.pRootSignature),
+			inputLayout(src.InputLayout.pInputElementDescs, src.InputLayout.pInputElementDescs + src.InputLayout.NumElements),
+			SODecl(src.StreamOutput.pSODeclaration, src.StreamOutput.pSODeclaration + src.StreamOutput.NumEntries),
+			SOStrides(src.StreamOutput.pBufferStrides, src.StreamOutput.pBufferStrides + src.StreamOutput.NumStrides),
+			desc(src)
+		{
+			desc.InputLayout.pInputElementDescs = inputLayout.data();
+			desc.StreamOutput.pSODeclaration = SODecl.data();
+			desc.StreamOutput.pBufferStrides = SOStrides.data();
+			desc.CachedPSO = {};
+		}
+
+		// move keeps vectors storage => pointers in desc remain valid
+		GraphicsDescCapture(GraphicsDescCapture &&) = default;
+		GraphicsDescCapture(const GraphicsDescCapture &) = delete;
+		void operator =(const GraphicsDescCapture &) = delete;
+	};
+
+	class ComputeDescCapture
+	{
+		ComPtr<ID3D12RootSignature> rootSig;
+
+	public:
+		D3D12_COMPUTE_PIPELINE_STATE_DESC desc;
+
+	public:
+		explicit ComputeDescCapture(const D3D12_COMPUTE_PIPELINE_STATE_DESC &src) : rootSig(src.pRootSignature), desc(src)
+		{
+			desc.CachedPSO = {};
+		}
+	};
+
+	inline HRESULT Load(ID3D12PipelineLibrary *library, LPCWSTR name, const D3D12_GRAPHICS_PIPELINE_STATE_DESC &desc, ComPtr<ID3D12PipelineState> &PSO)
+	{
+		return library->LoadGraphicsPipeline(name, &desc, IID_PPV_ARGS(PSO.GetAddressOf()));
+	}
+
+	inline HRESULT Load(ID3D12PipelineLibrary *library, LPCWSTR name, const D3D12_COMPUTE_PIPELINE_STATE_DESC &desc, ComPtr<ID3D12PipelineState> &PSO)
+	{
+		return library->LoadComputePipeline(name, &desc, IID_PPV_ARGS(PSO.GetAddressOf()));
+	}
+
+	inline void Create(const D3D12_GRAPHICS_PIPELINE_STATE_DESC &desc, ComPtr<ID3D12PipelineState> &PSO)
+	{
+		CheckHR(device->CreateGraphicsPipelineState(&desc, IID_PPV_ARGS(PSO.GetAddressOf())));
+	}
+
+	inline void Create(const D3D12_COMPUTE_PIPELINE_STATE_DESC &desc, ComPtr<ID3D12PipelineState> &PSO)
+	{
+		CheckHR(device->CreateComputePipelineState(&desc, IID_PPV_ARGS(PSO.GetAddressOf())));
+	}
+
+	void PrintCacheError(const char msg[], HRESULT hr)
+	{
+		System::WideIOGuard IOGuard(stderr);
+		wclog << msg << ": " << _com_error(hr).ErrorMessage() << endl;
+	}
+}
+
+#pragma region DeferredPSO
+DeferredPSO::DeferredPSO(ComPtr<ID3D12PipelineState> PSO)
+{
+	if (PSO)
+	{
+		promise<ComPtr<ID3D12PipelineState>> compiled;
+		compiled.set_value(move(PSO));
+		this->PSO = compiled.get_future().share();
+	}
+}
+
+DeferredPSO &DeferredPSO::operator =(const DeferredPSO &src)
+{
+	PSO = src.PSO;
+	resolved.store(src.resolved.load(memory_order_acquire), memory_order_release);
+	return *this;
+}
+
+ID3D12PipelineState *DeferredPSO::Resolve() const
+{
+	if (!PSO.valid())
+		return nullptr;
+	const auto compiled = PSO.get().Get();
+	resolved.store(compiled, memory_order_release);
+	return compiled;
+}
+
+bool DeferredPSO::Ready() const
+{
+	return PSO.valid() && PSO.wait_for(0s) == future_status::ready;
+}
+#pragma endregion
+
+#pragma region PSOLibrary
+PSOLibrary::PSOLibrary(filesystem::path location) : location(move(location))
+{
+	if (error_code ec; filesystem::exists(this->location, ec))
+	{
+		try
+		{
+			serialized = make_unique<System::MappedFile>(this->location);
+		}
+		catch (const _com_error &error)
+		{
+			PrintCacheError("Fail to open PSO cache, PSOs will be recompiled", error.Error());
+		}
+
+		if (serialized)
+		{
+			// the same failure codes for outdated driver/adapter change and corrupted cache => compile PSOs anew and overwrite cache
+			if (const HRESULT hr = device->CreatePipelineLibrary(serialized->Data(), serialized->Size(), IID_PPV_ARGS(library.GetAddressOf())); FAILED(hr))
+			{
+				serialized.reset();
+				if (hr == DXGI_ERROR_UNSUPPORTED)
+				{
+					PrintCacheError("PSO library not supported, PSOs will be compiled every run", hr);
+					return;
+				}
+				PrintCacheError("PSO cache invalidated (driver or adapter changed?), PSOs will be recompiled", hr);
+			}
+		}
+	}
+
+	if (!library)
+	{
+		// not fatal, just no caching
+		if (const HRESULT hr = device->CreatePipelineLibrary(NULL, 0, IID_PPV_ARGS(library.GetAddressOf())); FAILED(hr))
+		{
+			PrintCacheError(hr == DXGI_ERROR_UNSUPPORTED ? "PSO library not supported, PSOs will be compiled every run" : "Fail to create PSO library, PSOs will be compiled every run", hr);
+			return;
+		}
+	}
+
+	NameObject(library.Get(), L"PSO library");
+}
+
+PSOLibrary::~PSOLibrary()
+{
+	// compilation tasks refer to library
+	for (const auto &PSO : pending)
+		PSO.wait();
+
+	vector<std::byte> blob;
+	if (library && dirty && !stale)
+	{
+		blob.resize(library->GetSerializedSize());
+		if (const HRESULT hr = library->Serialize(blob.data(), blob.size()); FAILED(hr))
+		{
+			PrintCacheError("Fail to serialize PSO library", hr);
+			blob.clear();
+		}
+	}
+
+	// cache file can not be replaced while mapped
+	library.Reset();
+	serialized.reset();
+
+	error_code ec;
+	if (stale)
+		filesystem::remove(location, ec);
+	else if (!blob.empty())
+	{
+		// write to temp file first in order not to leave corrupted cache on failure
+		auto temp = location;
+		temp += L".tmp";
+		{
+			ofstream file(temp, ios::binary | ios::trunc);
+			file.write(reinterpret_cast<const char *>(blob.data()), blob.size());
+			file.close();
+			if (!file)
+				ec = make_error_code(errc::io_error);
+		}
+		if (!ec)
+			filesystem::rename(temp, location, ec);
+	}
+	if (ec)
+		clog << "Fail to update PSO cache: " << ec.message() << endl;
+}
+
+DeferredPSO PSOLibrary::Compile(const D3D12_GRAPHICS_PIPELINE_STATE_DESC &desc, const wchar_t name[])
+{
+	return Track(async(launch::async, [this, captured = GraphicsDescCapture(desc), name = wstring(name), hash = Hash(desc)]
+	{
+		return LoadOrCompile(captured.desc, name, hash);
+	}).share());
+}
+
+DeferredPSO PSOLibrary::Compile(const D3D12_COMPUTE_PIPELINE_STATE_DESC &desc, const wchar_t name[])
+{
+	return Track(async(launch::async, [this, captured = ComputeDescCapture(desc), name = wstring(name), hash = Hash(desc)]
+	{
+		return LoadOrCompile(captured.desc, name, hash);
+	}).share());
+}
+
+DeferredPSO PSOLibrary::Track(shared_future<ComPtr<ID3D12PipelineState>> &&PSO)
+{
+	{
+		lock_guard lck(mtx);
+		pending.push_back(PSO);
+	}
+	return DeferredPSO(move(PSO));
+}
+
+template<class Desc>
+ComPtr<ID3D12PipelineState> PSOLibrary::LoadOrCompile(const Desc &desc, const wstring &name, uint64_t hash)
+{
+	ComPtr<ID3D12PipelineState> PSO;
+	const wstring key = name + L" #" + to_wstring(hash);
+
+	if (library)
+	{
+		// E_INVALIDARG for both missing name and desc mismatch
+		if (const HRESULT hr = Load(library.Get(), key.c_str(), desc, PSO); SUCCEEDED(hr))
+		{
+			hits.fetch_add(1, memory_order_relaxed);
+			NameObject(PSO.Get(), name.c_str());
+			return PSO;
+		}
+		else if (hr != E_INVALIDARG)
+			CheckHR(hr);
+	}
+
+	Create(desc, PSO);
+	NameObject(PSO.Get(), name.c_str());
+	misses.fetch_add(1, memory_order_relaxed);
+
+	if (library)
+	{
+		lock_guard lck(mtx);
+		// name already taken by PSO with another desc
+		if (const HRESULT hr = library->StorePipeline(key.c_str(), PSO.Get()); hr == E_INVALIDARG)
+			stale = true;
+		else
+		{
+			CheckHR(hr);
+			dirty = true;
+		}
+	}
+
+	return PSO;
+}
+#pragma endregion
\ No newline at end of file
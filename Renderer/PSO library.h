@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <future>
+#include <mutex>
+#include <atomic>
+#include <optional>
+#include <vector>
+#include <filesystem>
+#include <wrl/client.h>
+
+struct ID3D12PipelineState;
+struct ID3D12PipelineLibrary;
+struct D3D12_GRAPHICS_PIPELINE_STATE_DESC;
+struct D3D12_COMPUTE_PIPELINE_STATE_DESC;
+
+namespace System
+{
+	class MappedFile;
+}
+
+namespace Renderer::Impl
+{
+	namespace WRL = Microsoft::WRL;
+
+	// PSO handle which waits for async compilation on first use
+	class DeferredPSO
+	{
+		std::shared_future<WRL::ComPtr<ID3D12PipelineState>> PSO;
+		mutable std::atomic<ID3D12PipelineState *> resolved = nullptr;	// cached on first successful 'Get()' to avoid shared state locking on hot paths, kept alive by 'PSO'
+
+	public:
+		DeferredPSO() = default;
+		DeferredPSO(WRL::ComPtr<ID3D12PipelineState> PSO);	// already compiled
+		explicit DeferredPSO(std::shared_future<WRL::ComPtr<ID3D12PipelineState>> &&PSO) noexcept : PSO(std::move(PSO)) {}
+		DeferredPSO(const DeferredPSO &src) : PSO(src.PSO), resolved(src.resolved.load(std::memory_order_acquire)) {}
+		DeferredPSO &operator =(const DeferredPSO &src);
+
+	public:
+		// blocks until compiled, rethrows compilation error
+		ID3D12PipelineState *Get() const
+		{
+			if (const auto cached = resolved.load(std::memory_order_acquire))
+				return cached;
+			return Resolve();
+		}
+		bool Ready() const;
+		explicit operator bool() const noexcept { return PSO.valid(); }
+
+	private:
+		ID3D12PipelineState *Resolve() const;
+	};
+
+	/*
+		disk backed pipeline library, PSOs compiled on worker threads
+		PSO looked up by name + hash of its shaders and states, compiled and stored on miss
+		serialized on destruction (after pending compilations finish) if new PSOs were stored
+		desc mismatch for existing name (e.g. state not covered by hash changed) marks cache stale => it gets dropped and rebuilt on next run
+		shaders bytecode should outlive compilation, root signature, input layout and SO decl are captured
+	*/
+	class PSOLibrary
+	{
+		const std::filesystem::path location;
+		std::unique_ptr<System::MappedFile> serialized;	// should outlive 'library'
+		WRL::ComPtr<ID3D12PipelineLibrary> library;		// null if not supported by driver => compile always
+		std::mutex mtx;
+		std::vector<std::shared_future<WRL::ComPtr<ID3D12PipelineState>>> pending;
+		bool dirty = false, stale = false;
+		std::atomic<unsigned int> hits = 0, misses = 0;
+
+	public:
+		struct Stats
+		{
+			unsigned int hits, misses;
+		};
+
+	public:
+		explicit PSOLibrary(std::filesystem::path location = L"PSO cache.bin");
+		~PSOLibrary();
+		PSOLibrary(PSOLibrary &) = delete;
+		void operator =(PSOLibrary &) = delete;
+
+	public:
+		DeferredPSO Compile(const D3D12_GRAPHICS_PIPELINE_STATE_DESC &desc, const wchar_t name[]);
+		DeferredPSO Compile(const D3D12_COMPUTE_PIPELINE_STATE_DESC &desc, const wchar_t name[]);
+		Stats GetStats() const noexcept { return { hits, misses }; }
+
+	private:
+		DeferredPSO Track(std::shared_future<WRL::ComPtr<ID3D12PipelineState>> &&PSO);
+		template<class Desc>
+		WRL::ComPtr<ID3D12PipelineState> LoadOrCompile(const Desc &desc, const std::wstring &name, uint64_t hash);
+	};
+
+	extern std::optional<PSOLibrary> globalPSOLibrary;
+}
\ No newline at end of file
@@ -1,5 +1,6 @@
 #include "stdafx.h"
 #include "SO buffer.h"
+#include "memory accounting.h"
 #include "tracked resource.inl"
 #include "cmdlist pool.inl"
 
@@ -111,6 +112,7 @@ Handle AllocatorBase::Allocate(unsigned long payloadSize, D3D12_RESOURCE_STATES
 						NULL,	// clear value
 						IID_PPV_ARGS(buffer.ReleaseAndGetAddressOf())));
 					NameObjectF(buffer.Get(), L"SO buffer for %ls [%lu]", resourceName, version++);
+					MemoryAccounting::Track(buffer.Get(), MemoryAccounting::Category::OcclusionQueries);
 				}
 			}
 			sharedLock.lock();
@@ -8,27 +8,89 @@ using namespace Impl::CmdListPool;
 using Impl::globalFrameVersioning;
 using Microsoft::WRL::ComPtr;
 
-decltype(PerFramePool::ctxPool)::size_type PerFramePool::firstFreePoolIdx;
+mutex PerFramePool::mtx;
+BucketStats PerFramePool::stats[bucketCount];
 
-PerFramePool::PerFramePool(PerFramePool &&src) : ctxPool(move(src.ctxPool)), ringIdx(src.ringIdx)
+#pragma region PerFramePool
+PerFramePool::PerFramePool(PerFramePool &&src) : frameID(src.frameID), ringIdx(src.ringIdx)
 {
+	move(begin(src.buckets), end(src.buckets), buckets);
 	src.ringIdx = globalFrameVersioning->GetFrameLatency() - 1;
 }
 
 PerFramePool &PerFramePool::operator =(PerFramePool &&src)
 {
-	ctxPool = move(src.ctxPool);
+	move(begin(src.buckets), end(src.buckets), buckets);
+	frameID = src.frameID;
 	ringIdx = src.ringIdx;
 	src.ringIdx = globalFrameVersioning->GetFrameLatency() - 1;
 	return *this;
 }
 
+auto PerFramePool::GetStats() -> array<BucketStats, bucketCount>
+{
+	array<BucketStats, bucketCount> result;
+	lock_guard lck(mtx);
+	copy_n(stats, bucketCount, result.begin());
+	return result;
+}
+
+// log2 buckets
+inline unsigned short PerFramePool::SelectBucket(unsigned int workload) noexcept
+{
+	return min<unsigned short>(bit_width(workload), bucketCount - 1);
+}
+
+// should be called under lock
+CmdCtx &PerFramePool::Acquire(unsigned int workload, unsigned short &bucketIdx, size_t &poolIdx)
+{
+	if (const auto curFrameID = globalFrameVersioning->GetCurFrameID(); frameID != curFrameID)
+		Recycle(curFrameID);
+
+	auto &bucket = buckets[bucketIdx = SelectBucket(workload)];
+	auto &bucketStats = stats[bucketIdx];
+	poolIdx = bucket.firstFreeIdx;
+	if (bucket.ctxPool.size() <= bucket.firstFreeIdx)
+	{
+		bucket.ctxPool.emplace_back();
+		bucketStats.liveCount++;
+	}
+	auto &ctx = bucket.ctxPool[bucket.firstFreeIdx++];	// increment after insertion improves exception safety guarantee
+	ctx.lastUsedFrameID = frameID;
+	bucketStats.peakUsage = max<unsigned long long>(bucketStats.peakUsage, bucket.firstFreeIdx);
+	bucketStats.peakWorkload = max<unsigned long long>(bucketStats.peakWorkload, workload);
+	return ctx;
+}
+
+/*
+	first use of frame version on new frame
+	frame versioning guarantees GPU is done with previous frame this version was used in, hence with all its ctxs
+	ctxs acquired in order starting from bucket's beginning so stale ones reside at tail and can be popped without invalidating the rest
+*/
+void PerFramePool::Recycle(unsigned long long curFrameID)
+{
+	frameID = curFrameID;
+	for (unsigned short bucketIdx = 0; bucketIdx < bucketCount; bucketIdx++)
+	{
+		auto &bucket = buckets[bucketIdx];
+		bucket.firstFreeIdx = 0;
+		while (!bucket.ctxPool.empty() && bucket.ctxPool.back().lastUsedFrameID + trimLatency < curFrameID)
+		{
+			bucket.ctxPool.pop_back();
+			stats[bucketIdx].liveCount--;
+			stats[bucketIdx].trimCount++;
+		}
+	}
+}
+#pragma endregion
+
 #pragma region CmdList
-CmdList::CmdList() : poolIdx(PerFramePool::firstFreePoolIdx), ringIdx(globalFrameVersioning->GetCurFrameDataVersion().ringIdx)
+CmdList::CmdList(unsigned int expectedWorkload)
 {
-	auto &curFramePool = globalFrameVersioning->GetCurFrameDataVersion().ctxPool;
-	cmdCtx = curFramePool.size() <= PerFramePool::firstFreePoolIdx ? &curFramePool.emplace_back() : &curFramePool[PerFramePool::firstFreePoolIdx];
-	PerFramePool::firstFreePoolIdx++;	// increment after insertion improves exception safety guarantee
+	auto &curFramePool = globalFrameVersioning->GetCurFrameDataVersion();
+	lock_guard lck(PerFramePool::mtx);
+	ringIdx = curFramePool.ringIdx;
+	cmdCtx = &curFramePool.Acquire(expectedWorkload, bucketIdx, poolIdx);
 	assert(cmdCtx->pendingBarriers.empty());
 }
 
@@ -75,7 +137,7 @@ void CmdList::Init(ID3D12PipelineState *PSO)
 	{
 		// create
 		CheckHR(device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(cmdCtx->allocator.GetAddressOf())));
-		NameObjectF(cmdCtx->allocator.Get(), L"pool command allocator [%hu][%zu]", ringIdx, poolIdx);
+		NameObjectF(cmdCtx->allocator.Get(), L"pool command allocator [%hu][%hu][%zu]", ringIdx, bucketIdx, poolIdx);
 	}
 
 	// cmd list
@@ -88,7 +150,7 @@ void CmdList::Init(ID3D12PipelineState *PSO)
 	{
 		// create
 		CheckHR(device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, cmdCtx->allocator.Get(), PSO, IID_PPV_ARGS(cmdCtx->list.ReleaseAndGetAddressOf())));
-		NameObjectF(cmdCtx->list.Get(), L"pool command list [%hu][%zu][%llu]", ringIdx, poolIdx, cmdCtx->listVersion++);
+		NameObjectF(cmdCtx->list.Get(), L"pool command list [%hu][%hu][%zu][%llu]", ringIdx, bucketIdx, poolIdx, cmdCtx->listVersion++);
 	}
 
 	setup = &CmdList::Update;
@@ -101,10 +163,5 @@ void CmdList::Update(ID3D12PipelineState *PSO)
 }
 #pragma endregion
 
-void Impl::CmdListPool::OnFrameFinish()
-{
-	PerFramePool::firstFreePoolIdx = 0;
-}
-
 template void CmdList::FlushBarriers<false>();
 template void CmdList::FlushBarriers<true>();
\ No newline at end of file
@@ -2,6 +2,8 @@
 
 #include <vector>
 #include <deque>
+#include <array>
+#include <mutex>
 #include <initializer_list>
 #include "../cmd buffer.h"
 
@@ -9,46 +11,77 @@ struct ID3D12PipelineState;
 struct ID3D12GraphicsCommandList4;
 struct D3D12_RESOURCE_BARRIER;
 
-// not thread-safe
+/*
+	thread-safe
+	allocators are bucketed by expected workload (work items count) - D3D12 allocator never returns memory on reset so heavy cmd lists should not pin their memory in allocators used for light ones
+	ctxs unused for 'trimLatency' frames get released from bucket's tail
+*/
 namespace Renderer::Impl::CmdListPool
 {
+	static constexpr unsigned short bucketCount = 8, trimLatency = 120/*frames*/;
+
 	struct CmdCtx : private CmdBuffer<>
 	{
 		friend class CmdList;
+		friend class PerFramePool;
 
 	private:
 		std::vector<D3D12_RESOURCE_BARRIER> pendingBarriers;
 		unsigned long long listVersion = 0;	// for name generation
+		unsigned long long lastUsedFrameID = 0;
 		bool suspended = false;
 	};
 
+	struct BucketStats
+	{
+		unsigned long long peakUsage;		// high-water mark of cmd lists per frame
+		unsigned long long peakWorkload;	// high-water mark of expected workload for single cmd list
+		unsigned long long liveCount;		// ctxs across all frame versions
+		unsigned long long trimCount;		// total ctxs released
+	};
+
 	class PerFramePool
 	{
 		friend class CmdList;
-		friend void OnFrameFinish();
 
 	private:
-		std::deque<struct CmdCtx> ctxPool;
+		struct Bucket
+		{
+			std::deque<CmdCtx> ctxPool;
+			decltype(ctxPool)::size_type firstFreeIdx = 0;
+		} buckets[bucketCount];
+		unsigned long long frameID = 0;	// last frame pool was used in
 		unsigned short ringIdx = 0;
 
 	private:
-		static decltype(ctxPool)::size_type firstFreePoolIdx;
+		static std::mutex mtx;
+		static BucketStats stats[bucketCount];
 
 	public:
 		PerFramePool() = default;
 		PerFramePool(PerFramePool &&src);
 		PerFramePool &operator =(PerFramePool &&src);
+
+	public:
+		static std::array<BucketStats, bucketCount> GetStats();
+
+	private:
+		static unsigned short SelectBucket(unsigned int workload) noexcept;
+		CmdCtx &Acquire(unsigned int workload, unsigned short &bucketIdx, size_t &poolIdx);
+		void Recycle(unsigned long long curFrameID);
 	};
 
 	class CmdList
 	{
 		struct CmdCtx *cmdCtx;
 		void (CmdList::*setup)(ID3D12PipelineState *PSO) = &CmdList::Init, (CmdList::*setupSimple)(ID3D12PipelineState *) = &CmdList::Init;
-		size_t poolIdx;			// for name generation
-		unsigned short ringIdx;	// for name generation
+		size_t poolIdx;				// for name generation
+		unsigned short bucketIdx;	// for name generation
+		unsigned short ringIdx;		// for name generation
 
 	public:
-		explicit CmdList();
+		// 'expectedWorkload' is work items count to be recorded, used for allocator bucket selection
+		explicit CmdList(unsigned int expectedWorkload = 0);
 		inline CmdList(CmdList &&src);
 		inline CmdList &operator =(CmdList &&src);
 
@@ -71,6 +104,4 @@ namespace Renderer::Impl::CmdListPool
 		void Init(ID3D12PipelineState *PSO), Update(ID3D12PipelineState *PSO);
 		void NOP(ID3D12PipelineState *) noexcept {}
 	};
-
-	void OnFrameFinish();
 }
\ No newline at end of file
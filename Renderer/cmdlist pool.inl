@@ -5,7 +5,7 @@
 
 namespace Renderer::Impl::CmdListPool
 {
-	inline CmdList::CmdList(CmdList &&src) : cmdCtx(src.cmdCtx), setup(src.setup), setupSimple(src.setupSimple), poolIdx(src.poolIdx), ringIdx(src.ringIdx)
+	inline CmdList::CmdList(CmdList &&src) : cmdCtx(src.cmdCtx), setup(src.setup), setupSimple(src.setupSimple), poolIdx(src.poolIdx), bucketIdx(src.bucketIdx), ringIdx(src.ringIdx)
 	{
 		src.cmdCtx = nullptr;
 	}
@@ -16,6 +16,7 @@ namespace Renderer::Impl::CmdListPool
 		setup = src.setup;
 		setupSimple = src.setupSimple;
 		poolIdx = src.poolIdx;
+		bucketIdx = src.bucketIdx;
 		ringIdx = src.ringIdx;
 		src.cmdCtx = nullptr;
 		return *this;
@@ -5,6 +5,16 @@ using namespace std;
 using namespace Renderer::Impl;
 using WRL::ComPtr;
 
+static constexpr unsigned short shrinkHysteresis = 60;	// frames
+static constexpr float statsSmoothing = 1.f / 16;
+
+atomic<unsigned short> FrameVersioningBase::minLatency = 1, FrameVersioningBase::maxLatency = maxFrameLatency;
+
+static inline void UpdateAverage(float &avg, float sample) noexcept
+{
+	avg += (sample - avg) * statsSmoothing;
+}
+
 FrameVersioningBase::FrameVersioningBase(LPCWSTR objectName)
 {
 	extern ComPtr<ID3D12Device2> device;
@@ -27,17 +37,65 @@ void FrameVersioningBase::WaitForGPU(UINT64 waitFrameID) const
 		throw _com_error(HRESULT_FROM_WIN32(GetLastError()));
 }
 
-unsigned short FrameVersioningBase::OnFrameStart()
+void FrameVersioningBase::TimedWaitForGPU(UINT64 waitFrameID)
 {
-	const auto oldestTrackedFrame = ++frameID - frameLatency;
-	if (fence->GetCompletedValue() < oldestTrackedFrame)
+	const auto waitStart = chrono::steady_clock::now();
+	WaitForGPU(waitFrameID);
+	UpdateAverage(latencyStats.fenceWait, chrono::duration<float, milli>(chrono::steady_clock::now() - waitStart).count());
+}
+
+void FrameVersioningBase::SetLatencyLimits(unsigned short min, unsigned short max)
+{
+	if (min < 1 || min > max || max > maxFrameLatency)
+		throw out_of_range("Invalid frame latency limits.");
+	minLatency.store(min, memory_order_relaxed);
+	maxLatency.store(max, memory_order_relaxed);
+}
+
+auto FrameVersioningBase::OnFrameStart() -> optional<RingRotation>
+{
+	const UINT64 completedFrameID = fence->GetCompletedValue();
+	const auto framesInFlight = frameID++ - completedFrameID;
+	UpdateAverage(latencyStats.framesInFlight, float(framesInFlight));
+	UpdateAverage(latencyStats.GPUStarvation, !framesInFlight);
+
+	const auto min = minLatency.load(memory_order_relaxed), max = maxLatency.load(memory_order_relaxed);
+
+	// shrink if one frame less in flight would not stall CPU for a while or if limit lowered
+	slackFrames = framesInFlight + 1 < frameLatency ? slackFrames + 1u : 0u;
+	if (frameLatency > max || frameLatency > min && slackFrames >= shrinkHysteresis)
 	{
-		if (frameLatency < maxFrameLatency)
-			return frameLatency++;
+		slackFrames = 0;
+
+		// slot next to current one becomes current, it should be free
+		if (const auto nextOldestTrackedFrame = frameID - --frameLatency; completedFrameID < nextOldestTrackedFrame)
+			TimedWaitForGPU(nextOldestTrackedFrame);
 		else
-			WaitForGPU(oldestTrackedFrame);
+			UpdateAverage(latencyStats.fenceWait, 0.f);
+
+		// park current slot at ring end
+		if (ringBufferIdx == frameLatency)
+		{
+			ringBufferIdx = 0;
+			return nullopt;
+		}
+		return RingRotation{ ringBufferIdx, static_cast<unsigned short>(ringBufferIdx + 1), static_cast<unsigned short>(frameLatency + 1) };
 	}
-	return 0;
+
+	if (const auto oldestTrackedFrame = frameID - frameLatency; completedFrameID < oldestTrackedFrame)
+	{
+		// bring parked slot in instead of waiting
+		if (frameLatency < max)
+		{
+			UpdateAverage(latencyStats.fenceWait, 0.f);
+			return RingRotation{ ringBufferIdx, frameLatency, ++frameLatency };
+		}
+		TimedWaitForGPU(oldestTrackedFrame);
+	}
+	else
+		UpdateAverage(latencyStats.fenceWait, 0.f);
+
+	return nullopt;
 }
 
 void FrameVersioningBase::OnFrameFinish()
@@ -5,6 +5,7 @@
 #include <algorithm>
 #include <deque>
 #include <optional>
+#include <atomic>
 #include <wrl/client.h>
 #include "../event handle.h"
 #include "../cmdlist pool.h"
@@ -17,12 +18,31 @@ namespace Renderer::Impl
 
 	static constexpr unsigned short maxFrameLatency = 3;
 
+	/*
+		frame latency controller
+		latency grows when GPU has not finished oldest tracked frame yet (instead of stalling CPU on fence) until upper limit reached
+		and shrinks when GPU consistently keeps up with one frame less in flight (CPU bound => no throughput loss, lower input latency)
+		ring slots are never reallocated: removed slot gets parked past ring end and is brought back on growth
+	*/
 	class FrameVersioningBase
 	{
 		UINT64 frameID = 0;
 		EventHandle fenceEvent;
 		WRL::ComPtr<ID3D12Fence> fence;
 		unsigned short frameLatency = 1, ringBufferIdx = 0;
+		unsigned short slackFrames = 0;	// consecutive frames started with less than 'frameLatency - 1' frames in flight
+
+	public:
+		struct LatencyStats
+		{
+			float fenceWait;		// ms, moving average
+			float framesInFlight;	// on frame start, moving average
+			float GPUStarvation;	// fraction of frames started with GPU idle, moving average
+		};
+
+	private:
+		LatencyStats latencyStats{};
+		static std::atomic<unsigned short> minLatency, maxLatency;
 
 	protected:
 		FrameVersioningBase(LPCWSTR objectName);
@@ -37,13 +57,22 @@ namespace Renderer::Impl
 		UINT64 GetCurFrameID() const noexcept { return frameID; }
 		UINT64 GetCompletedFrameID() const;
 		void WaitForGPU() const { WaitForGPU(frameID); }
+		const LatencyStats &GetLatencyStats() const noexcept { return latencyStats; }
+		// applies to all frame versionings, latency converges to new limits one frame at a time
+		static void SetLatencyLimits(unsigned short min, unsigned short max);
 
 	private:
 		void WaitForGPU(UINT64 waitFrameID) const;
+		void TimedWaitForGPU(UINT64 waitFrameID);
 
 	protected:
+		// ring slots [first, last) to be rotated by derived so that 'middle' becomes 'first'
+		struct RingRotation
+		{
+			unsigned short first, middle, last;
+		};
 		unsigned short GetRingBufferIdx() const noexcept { return ringBufferIdx; }
-		unsigned short OnFrameStart();
+		std::optional<RingRotation> OnFrameStart();
 
 	public:
 		void OnFrameFinish();
@@ -75,10 +104,7 @@ namespace Renderer::Impl
 	template<class Data, LPCWSTR objectName>
 	void FrameVersioning<Data, objectName>::OnFrameStart()
 	{
-		if (const unsigned short rangeEndIdx = FrameVersioningBase::OnFrameStart())
-		{
-			const auto rangeBegin = ringBuffer + GetRingBufferIdx(), rangeEnd = ringBuffer + rangeEndIdx;
-			std::move_backward(rangeBegin, rangeEnd, rangeEnd + 1);
-		}
+		if (const auto rotation = FrameVersioningBase::OnFrameStart())
+			std::rotate(ringBuffer + rotation->first, ringBuffer + rotation->middle, ringBuffer + rotation->last);
 	}
 }
\ No newline at end of file
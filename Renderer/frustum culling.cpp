@@ -25,7 +25,7 @@ FrustumCuller<dimension>::FrustumCuller(const float4x4 &frustumXform) :
 		+ExtractUsedCoords(Column(frustumXform, 0)) - ExtractUsedCoords(Column(frustumXform, 3)),	// +X
 		-ExtractUsedCoords(Column(frustumXform, 1)) - ExtractUsedCoords(Column(frustumXform, 3)),	// -Y
 		+ExtractUsedCoords(Column(frustumXform, 1)) - ExtractUsedCoords(Column(frustumXform, 3)),	// +Y
-		-ExtractUsedCoords(Column(frustumXform, 3))													// -Z
+		-ExtractUsedCoords(Column(frustumXform, 2)),												// -Z
 		+ExtractUsedCoords(Column(frustumXform, 2)) - ExtractUsedCoords(Column(frustumXform, 3))	// +Z
 	},
 	// TODO: implement abs in vector math (with specialization for floating point types using fabs)
@@ -40,5 +40,34 @@ FrustumCuller<dimension>::FrustumCuller(const float4x4 &frustumXform) :
 	}
 {}
 
+// upper bound of |dot(plane.xyz, p) + plane.w| for points within 'bounds'
+template<unsigned int dimension>
+static float PlaneBound(const vector<float, dimension + 1> &plane, const AABB<dimension> &bounds)
+{
+	float bound = fabsf(plane[dimension]);
+	for (unsigned i = 0; i < dimension; i++)
+		bound += fabsf(plane[i]) * fmax(fabsf(bounds.min[i]), fabsf(bounds.max[i]));
+	return bound;
+}
+
+template<unsigned int dimension>
+float FrustumCuller<dimension>::PlanesScale(const AABB<dimension> &bounds) const
+{
+	float scale = 0.f;
+	for (const auto &plane : frustumPlanes)
+		scale = fmax(scale, PlaneBound<dimension>(plane, bounds));
+	return scale;
+}
+
+// plane function is linear so its change is bounded by the same way as plane function itself
+template<unsigned int dimension>
+float FrustumCuller<dimension>::PlanesDelta(const FrustumCuller &left, const FrustumCuller &right, const AABB<dimension> &bounds)
+{
+	float delta = 0.f;
+	for (unsigned plane = 0; plane < size(left.frustumPlanes); plane++)
+		delta = fmax(delta, PlaneBound<dimension>(left.frustumPlanes[plane] - right.frustumPlanes[plane], bounds));
+	return delta;
+}
+
 template class FrustumCuller<2>;
 template class FrustumCuller<3>;
\ No newline at end of file
@@ -6,6 +6,8 @@
 #include "vector math.h"
 #endif
 #include "SIMD.h"
+#include <iterator>
+#include <bit>
 #include <immintrin.h>
 
 namespace Renderer::Impl
@@ -103,6 +105,9 @@ namespace Renderer::Impl
 		Math::VectorMath::vector<float, dimension + 1> frustumPlanes[6];
 		Math::VectorMath::vector<float, dimension> absFrustumPlanes[6];
 
+	public:
+		static constexpr unsigned int allPlanesMask = (1u << std::size(frustumPlanes)) - 1u;
+
 	public:
 		explicit FrustumCuller(const HLSL::float4x4 &frustumXform);
 
@@ -110,9 +115,22 @@ namespace Renderer::Impl
 		// with earlyOut returns true if culled
 		template<bool earlyOut>
 		std::conditional_t<earlyOut, bool, CullResult> Cull(const AABB<dimension> &aabb) const;
+		/*
+			tests only planes from 'planeMask' and clears planes AABB is completely inside of
+			resulting mask is intended for children of hierarchy node which AABB encloses children's ones - they need not to test planes parent is inside of
+			dispatches to kernel specialized for active plane count
+		*/
+		inline CullResult Cull(const AABB<dimension> &aabb, unsigned int &planeMask) const;
+		// distance from AABB to nearest plane in unnormalized plane units, positive if AABB is completely inside
+		inline float InsideMargin(const AABB<dimension> &aabb) const;
+		// upper bounds of plane functions magnitude / their change between frustums for points within 'bounds'
+		float PlanesScale(const AABB<dimension> &bounds) const;
+		static float PlanesDelta(const FrustumCuller &left, const FrustumCuller &right, const AABB<dimension> &bounds);
 
 	private:
 		static Math::VectorMath::vector<float, dimension + 1> ExtractUsedCoords(const HLSL::float4 &src);
+		template<unsigned int planeCount>
+		CullResult CullPlanes(const AABB<dimension> &aabb, unsigned int &planeMask) const;
 	};
 
 	template<unsigned int dimension>
@@ -196,4 +214,66 @@ namespace Renderer::Impl
 			return inside ? CullResult::INSIDE : CullResult::UNDETERMINED;
 		}
 	}
+
+	template<unsigned int dimension>
+	inline CullResult FrustumCuller<dimension>::Cull(const AABB<dimension> &aabb, unsigned int &planeMask) const
+	{
+		assert(!(planeMask & ~allPlanesMask));
+		switch (std::popcount(planeMask))
+		{
+		case 0:
+			return CullResult::INSIDE;
+		case 1:
+			return CullPlanes<1>(aabb, planeMask);
+		case 2:
+			return CullPlanes<2>(aabb, planeMask);
+		case 3:
+			return CullPlanes<3>(aabb, planeMask);
+		case 4:
+			return CullPlanes<4>(aabb, planeMask);
+		case 5:
+			return CullPlanes<5>(aabb, planeMask);
+		default:
+			return CullPlanes<6>(aabb, planeMask);
+		}
+	}
+
+	// constant trip count allows compiler to fully unroll plane loop
+	template<unsigned int dimension>
+	template<unsigned int planeCount>
+	inline CullResult FrustumCuller<dimension>::CullPlanes(const AABB<dimension> &aabb, unsigned int &planeMask) const
+	{
+		const auto aabbCenter = aabb.Center();
+		const auto aaabbExtent = aabb.Size() * .5f;
+
+		unsigned int planes[planeCount];
+		for (unsigned int i = 0, mask = planeMask; i < planeCount; i++, mask &= mask - 1u)
+			planes[i] = std::countr_zero(mask);
+
+		unsigned int insideMask = 0;
+		for (unsigned int i = 0; i < planeCount; i++)
+		{
+			const unsigned int plane = planes[i];
+			const float centerDist = dot(frustumPlanes[plane], aabbCenter) + frustumPlanes[plane][dimension];
+			const float cornerOffset = dot(absFrustumPlanes[plane], aaabbExtent);
+			if (centerDist - cornerOffset > 0.f)
+				return CullResult::OUTSIDE;
+			if (centerDist + cornerOffset <= 0.f)
+				insideMask |= 1u << plane;
+		}
+
+		return (planeMask &= ~insideMask) ? CullResult::UNDETERMINED : CullResult::INSIDE;
+	}
+
+	template<unsigned int dimension>
+	inline float FrustumCuller<dimension>::InsideMargin(const AABB<dimension> &aabb) const
+	{
+		const auto aabbCenter = aabb.Center();
+		const auto aaabbExtent = aabb.Size() * .5f;
+
+		float margin = +INFINITY;
+		for (unsigned plane = 0; plane < std::size(frustumPlanes); plane++)
+			margin = fmin(margin, -(dot(frustumPlanes[plane], aabbCenter) + frustumPlanes[plane][dimension] + dot(absFrustumPlanes[plane], aaabbExtent)));
+		return margin;
+	}
 }
\ No newline at end of file
@@ -6,6 +6,8 @@
 #include "allocator adaptors.h"
 
 struct ID3D12GraphicsCommandList4;
+struct ID3D12Resource;
+struct D3D12_DRAW_INDEXED_ARGUMENTS;
 
 namespace Renderer
 {
@@ -29,6 +31,7 @@ namespace Renderer
 				it is also possible to store index instead of address, it potentially can save storage (4 bytes instead of 8) but probably will not due to alignment
 			*/
 			UINT64 CB_GPU_ptr;
+			unsigned int CB_slot;	// StaticObjectData index in World's instance data buffer
 
 		protected:
 			Instance(std::shared_ptr<class Renderer::World> &&world, Renderer::Object3D &&object, const float (&xform)[4][3], const AABB<3> &worldAABB);
@@ -45,7 +48,16 @@ namespace Renderer
 		protected:
 			static void Setup(ID3D12GraphicsCommandList4 *target, UINT64 frameDataGPUPtr, UINT64 tonemapParamsGPUPtr) { Object3D::Setup(target, frameDataGPUPtr, tonemapParamsGPUPtr); }
 			const auto GetStartPSO() const { return object.GetStartPSO(); }
+			const void *GetGeometryID() const noexcept { return object.GetGeometryID(); }
 			void Render(ID3D12GraphicsCommandList4 *target) const;
+			// render 'instanceCount' copies of the object with xforms taken from 'instancesCB_GPU_ptr' instead of own CB
+			void Render(ID3D12GraphicsCommandList4 *target, UINT64 instancesCB_GPU_ptr, unsigned int instanceCount) const;
+			// draws for all instances sharing the object, instance data CBVs come from indirect args
+			D3D12_DRAW_INDEXED_ARGUMENTS GetDrawArgs(unsigned short int subobjIdx) const;
+			void RenderIndirect(ID3D12GraphicsCommandList4 *target, unsigned int maxInstanceCount, ID3D12Resource *args, UINT64 argsOffset, ID3D12Resource *counters, UINT64 countersOffset) const
+			{
+				object.RenderIndirect(target, maxInstanceCount, args, argsOffset, counters, countersOffset);
+			}
 		};
 	}
 
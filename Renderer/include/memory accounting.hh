@@ -0,0 +1,60 @@
+#pragma once
+
+#include <iosfwd>
+#include <functional>
+
+namespace Renderer::MemoryAccounting
+{
+	enum class Category : unsigned int
+	{
+		RenderTargets,		// render output surfaces, Z buffer history
+		Geometry,			// 3D objects and terrain VB/IB
+		Textures,
+		ConstantBuffers,	// static objects CB, global GPU buffer, per viewport params
+		StreamBuffers,		// per frame GPU stream buffers (occlusion AABBs, instances CB)
+		DMAUpload,			// DMA engine upload chunks
+		OcclusionQueries,	// query heaps, results, xformed AABBs SO buffers
+		Descriptors,
+		GPUCulling,
+		TransientRAM,		// per frame CPU allocations
+		Misc,
+		Count
+	};
+
+	enum class HeapType : unsigned int
+	{
+		Upload,
+		Default,
+		Readback,
+		SysRAM,	// custom heaps in system memory pool and CPU allocations
+		Count
+	};
+
+	struct Counters
+	{
+		unsigned long long int bytes, peakBytes;
+		unsigned long int allocations;	// alive
+	};
+
+	struct Snapshot
+	{
+		Counters counters[unsigned(Category::Count)][unsigned(HeapType::Count)], heapTotals[unsigned(HeapType::Count)];
+
+	public:
+		const Counters &operator ()(Category category, HeapType heapType) const noexcept { return counters[unsigned(category)][unsigned(heapType)]; }
+		const Counters &operator ()(HeapType heapType) const noexcept { return heapTotals[unsigned(heapType)]; }
+	};
+
+	Counters __cdecl Query(Category category, HeapType heapType) noexcept, __cdecl Query(HeapType heapType) noexcept;
+	Snapshot __cdecl TakeSnapshot() noexcept;
+	void __cdecl Dump(const Snapshot &snapshot, std::ostream &dst);
+
+	/*
+		callback invoked on the allocating thread when accounted bytes grow beyond budget, once per crossing
+		budgets can be set either for category within heap or for heap total
+		set budget to ULLONG_MAX to remove it
+	*/
+	typedef std::function<void __cdecl(unsigned long long int bytes, unsigned long long int budget)> BudgetCallback;
+	void __cdecl SetBudget(Category category, HeapType heapType, unsigned long long int budget, BudgetCallback callback = {});
+	void __cdecl SetBudget(HeapType heapType, unsigned long long int budget, BudgetCallback callback = {});
+}
\ No newline at end of file
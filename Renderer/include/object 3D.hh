@@ -8,6 +8,8 @@
 #include <memory>
 #include <string>
 #include <array>
+#include <vector>
+#include <span>
 #include <variant>
 #include <functional>
 #include <future>
@@ -15,6 +17,7 @@
 #include "texture.hh"
 #include "../tracked resource.h"
 #include "../AABB.h"
+#include "../PSO library.h"
 #define DISABLE_MATRIX_SWIZZLES
 #if !__INTELLISENSE__ 
 #include "vector math.h"
@@ -25,6 +28,8 @@ struct ID3D12PipelineState;
 struct ID3D12Resource;
 struct ID3D12CommandAllocator;
 struct ID3D12GraphicsCommandList4;
+struct ID3D12CommandSignature;
+struct D3D12_DRAW_INDEXED_ARGUMENTS;
 
 extern void __cdecl InitRenderer();
 
@@ -51,12 +56,13 @@ namespace Renderer
 			};
 			struct PSOs
 			{
-				WRL::ComPtr<ID3D12PipelineState> flat, tex[2], TV, advanced[ADVANCED_MATERIAL_COUNT];
+				DeferredPSO flat, tex[2], TV, advanced[ADVANCED_MATERIAL_COUNT];
 			};
 
 		private:
 			static WRL::ComPtr<ID3D12RootSignature> rootSig, CreateRootSig();
 			static std::array<PSOs, 2> PSOs, CreatePSOs();
+			static WRL::ComPtr<ID3D12CommandSignature> indirectCmdSignature, CreateIndirectCmdSignature();	// instance data CBV + indexed draw
 
 		public:
 			struct SubobjectDataBase
@@ -130,11 +136,16 @@ namespace Renderer
 			struct Context;
 			struct Subobject;
 			class DescriptorTablePack;
+			struct GeometryLayout
+			{
+				unsigned long int CB_size, VB_size, UVB_size, TGB_size, IB_size;
+			};
 			// is GPU lifetime tracking is necessary for cmd list (or is it enough for cmd allocator only)?
 			std::shared_future<std::pair<Impl::TrackedResource<ID3D12CommandAllocator>, Impl::TrackedResource<ID3D12GraphicsCommandList4>>> bundle;
 			std::shared_ptr<Subobject []> subobjects;
 			std::shared_ptr<DescriptorTablePack> descriptorTablePack;	// serves all subobjects
 			Impl::TrackedResource<ID3D12Resource> GPUBuffer;	// Vertex/Index Buffer, also contain material for Intel workaround
+			GeometryLayout layout;	// GPUBuffer regions, needed to record instanced draws outside of bundle
 			unsigned long int tricount;
 			unsigned short int subobjCount;
 
@@ -147,6 +158,23 @@ namespace Renderer
 				__cdecl(unsigned int subobjIdx)> SubobjectDataCallback;
 			Object3D(unsigned short int subobjCount, const SubobjectDataCallback &getSubobjectData, std::string name);
 
+		public:
+			struct BulkDesc
+			{
+				unsigned short int subobjCount;
+				SubobjectDataCallback getSubobjectData;	// called concurrently during bulk construction
+				std::string name;
+			};
+			// optional worker pool for bulk construction, should run 'task' for every idx in [0, taskCount) and return when all done, parallel STL used if empty
+			typedef std::function<void __cdecl(unsigned int taskCount, const std::function<void __cdecl(unsigned int taskIdx)> &task)> WorkerPool;
+
+		private:
+#ifdef _MSC_VER
+			typedef std::wstring ObjectName;
+#else
+			typedef std::string ObjectName;
+#endif
+
 		protected:
 			Object3D();
 			Object3D(const Object3D &);
@@ -162,15 +190,44 @@ namespace Renderer
 		protected:
 			static void Setup(ID3D12GraphicsCommandList4 *target, UINT64 frameDataGPUPtr, UINT64 tonemapParamsGPUPtr);
 			ID3D12PipelineState *GetStartPSO() const;
+			// copies of the same object share GPU data and can be merged into single instanced draw
+			const void *GetGeometryID() const noexcept { return subobjects.get(); }
 			const void Render(ID3D12GraphicsCommandList4 *target) const;
+			// records draws directly (bypassing bundle), instance data CBV expected to be already set up with 'instanceCount' xforms
+			void Render(ID3D12GraphicsCommandList4 *target, unsigned int instanceCount) const;
+			unsigned short int GetSubobjectCount() const noexcept { return subobjCount; }
+			D3D12_DRAW_INDEXED_ARGUMENTS GetDrawArgs(unsigned short int subobjIdx) const;
+			/*
+				ExecuteIndirect per subobject with cmds produced by GPU culling ("GPU culling.hlsli" layout)
+				subobject's cmds placed at 'argsOffset' + subobjIdx * 'maxInstanceCount' cmds, its count at 'countersOffset' + subobjIdx * 4
+			*/
+			void RenderIndirect(ID3D12GraphicsCommandList4 *target, unsigned int maxInstanceCount, ID3D12Resource *args, UINT64 argsOffset, ID3D12Resource *counters, UINT64 countersOffset) const;
+
+		protected:
+			// size pass for all objects, GPU buffers creation, then parallel fill of disjoint buffer ranges of all subobjects of all objects
+			static void ConstructBulk(Object3D *const targets[], const BulkDesc descs[], unsigned int count, const WorkerPool &workerPool);
 
 		private:
+			static inline ObjectName ConvertName(std::string &&name);
+			std::vector<unsigned long int> Parse(unsigned short int subobjCount, const SubobjectDataCallback &getSubobjectData, const ObjectName &name);
+			// unmaps on destruction, including when fill throws
+			struct GPUBufferUnmapper
+			{
+				ID3D12Resource *GPUBuffer = nullptr;
+
+			public:
+				void operator ()(std::byte *) const;
+			};
+			typedef std::unique_ptr<std::byte, GPUBufferUnmapper> MappedGPUBuffer;
+			MappedGPUBuffer CreateGPUBuffer(const ObjectName &name);
+			void FillSubobject(const SubobjectDataCallback &getSubobjectData, unsigned short int subobjIdx, std::byte *mapped, unsigned long int CB_offset) const;
+			inline void StartBundleCreation(ObjectName &&name);
+			template<typename Draw>
+			static void RecordDraws(ID3D12GraphicsCommandList4 *target, const Subobject *subobjects, unsigned short int subobjCount, const GeometryLayout &layout, Context &ctx, const Draw &draw);
 #ifdef _MSC_VER
-			static std::decay_t<decltype(bundle.get())> CreateBundle(const decltype(subobjects) &subobjects, unsigned short int subobjCount, WRL::ComPtr<ID3D12Resource> GPUBuffer,
-				unsigned long int CB_size, unsigned long int VB_size, unsigned long int UVB_size, unsigned long int TGB_size, unsigned long int IB_size, std::wstring &&objectName);
+			static std::decay_t<decltype(bundle.get())> CreateBundle(const decltype(subobjects) &subobjects, unsigned short int subobjCount, WRL::ComPtr<ID3D12Resource> GPUBuffer, GeometryLayout layout, std::wstring &&objectName);
 #else
-			static std::decay_t<decltype(bundle.get())> CreateBundle(const decltype(subobjects) &subobjects, unsigned short int subobjCount, WRL::ComPtr<ID3D12Resource> GPUBuffer,
-				unsigned long int CB_size, unsigned long int VB_size, unsigned long int UVB_size, unsigned long int TGB_size, unsigned long int IB_size, std::string &&objectName);
+			static std::decay_t<decltype(bundle.get())> CreateBundle(const decltype(subobjects) &subobjects, unsigned short int subobjCount, WRL::ComPtr<ID3D12Resource> GPUBuffer, GeometryLayout layout, std::string &&objectName);
 #endif
 		};
 	}
@@ -182,10 +239,17 @@ namespace Renderer
 	public:
 		using Impl::Object3D::Object3D;
 
+	public:
+		// for level loads, builds objects concurrently
+		static std::vector<Object3D> CreateBulk(std::span<const BulkDesc> descs, const WorkerPool &workerPool = {});
+
 		// hide from protected
 	private:
 		using Impl::Object3D::Setup;
 		using Impl::Object3D::GetStartPSO;
+		using Impl::Object3D::GetGeometryID;
 		using Impl::Object3D::Render;
+		using Impl::Object3D::GetDrawArgs;
+		using Impl::Object3D::RenderIndirect;
 	};
 }
\ No newline at end of file
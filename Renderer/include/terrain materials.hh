@@ -66,7 +66,7 @@ namespace Renderer::TerrainMaterials
 
 		protected:
 			template<typename ExtraArg>
-			TexStuff(float texScale, unsigned textureCount, const char materialName[], const ExtraArg &extraArg, const WRL::ComPtr<ID3D12RootSignature> &rootSig, const WRL::ComPtr<ID3D12PipelineState> &PSO);
+			TexStuff(float texScale, unsigned textureCount, const char materialName[], const ExtraArg &extraArg, const WRL::ComPtr<ID3D12RootSignature> &rootSig, const Renderer::Impl::DeferredPSO &PSO);
 			~TexStuff() = default;
 
 		private:
@@ -86,7 +86,7 @@ namespace Renderer::TerrainMaterials
 	private:
 		friend extern void __cdecl ::InitRenderer();
 		static WRL::ComPtr<ID3D12RootSignature> rootSig, CreateRootSig();
-		static WRL::ComPtr<ID3D12PipelineState> PSO, CreatePSO();
+		static Renderer::Impl::DeferredPSO PSO, CreatePSO();
 
 	private:
 		const float albedo[3];
@@ -100,7 +100,7 @@ namespace Renderer::TerrainMaterials
 		static void FillRootParams(CD3DX12_ROOT_PARAMETER1 dst[]);
 
 	protected:
-		explicit Flat(const float (&albedo)[3], const WRL::ComPtr<ID3D12RootSignature> &rootSig = rootSig, const WRL::ComPtr<ID3D12PipelineState> &PSO = PSO);
+		explicit Flat(const float (&albedo)[3], const WRL::ComPtr<ID3D12RootSignature> &rootSig = rootSig, const Renderer::Impl::DeferredPSO &PSO = PSO);
 		~Flat() = default;
 
 	public:
@@ -119,7 +119,7 @@ namespace Renderer::TerrainMaterials
 	private:
 		friend extern void __cdecl ::InitRenderer();
 		static WRL::ComPtr<ID3D12RootSignature> rootSig, CreateRootSig();
-		static WRL::ComPtr<ID3D12PipelineState> PSO, CreatePSO();
+		static Renderer::Impl::DeferredPSO PSO, CreatePSO();
 
 	private:
 		const Renderer::Impl::TrackedResource<ID3D12Resource> tex;
@@ -140,7 +140,7 @@ namespace Renderer::TerrainMaterials
 	private:
 		friend extern void __cdecl ::InitRenderer();
 		static WRL::ComPtr<ID3D12RootSignature> rootSig, CreateRootSig();
-		static WRL::ComPtr<ID3D12PipelineState> PSO, CreatePSO();
+		static Renderer::Impl::DeferredPSO PSO, CreatePSO();
 
 	private:
 		enum
@@ -180,7 +180,7 @@ namespace Renderer::TerrainMaterials
 	private:
 		friend extern void __cdecl ::InitRenderer();
 		static WRL::ComPtr<ID3D12RootSignature> rootSig, CreateRootSig();
-		static WRL::ComPtr<ID3D12PipelineState> PSO, CreatePSO();
+		static Renderer::Impl::DeferredPSO PSO, CreatePSO();
 
 	private:
 		enum
@@ -8,6 +8,7 @@
 #include "../cmd buffer.h"
 #include "../world view context.h"
 #include "../render pipeline.h"
+#include "../PSO library.h"
 
 struct ID3D12GraphicsCommandList4;
 struct ID3D12RootSignature;
@@ -71,9 +72,9 @@ namespace Renderer
 		private:
 			friend extern void __cdecl ::InitRenderer();
 			static WRL::ComPtr<ID3D12RootSignature> tonemapRootSig, CreateTonemapRootSig();
-			static WRL::ComPtr<ID3D12PipelineState> tonemapTextureReductionPSO, CreateTonemapTextureReductionPSO();
-			static WRL::ComPtr<ID3D12PipelineState> tonemapBufferReductionPSO, CreateTonemapBufferReductionPSO();
-			static WRL::ComPtr<ID3D12PipelineState> tonemapPSO, CreateTonemapPSO();
+			static DeferredPSO tonemapTextureReductionPSO, CreateTonemapTextureReductionPSO();
+			static DeferredPSO tonemapBufferReductionPSO, CreateTonemapBufferReductionPSO();
+			static DeferredPSO tonemapPSO, CreateTonemapPSO();
 
 		private:
 			RenderPipeline::PipelineStage
@@ -90,6 +91,8 @@ namespace Renderer
 		public:
 			void SetViewTransform(const float (&matrix)[4][3]);
 			void SetProjectionTransform(double fovy, double zn, double zf = numeric_limits<double>::infinity());
+			// main passes state changes for last rendered frame before and after render streams sorting, waits for its stage build
+			std::pair<RenderStreamStateChanges, RenderStreamStateChanges> GetRenderStreamStateChanges() const;
 
 		protected:
 			void UpdateAspect(double invAspect);
@@ -3,8 +3,11 @@
 #define NOMINMAX
 
 #include <cstddef>
+#include <utility>
 #include <memory>
 #include <string>
+#include <vector>
+#include <deque>
 #include <list>
 #include <future>
 #include <wrl/client.h>
@@ -53,6 +56,10 @@ namespace Renderer
 			class PipelineROPTargets;
 		}
 		namespace RenderPasses = RenderPipeline::RenderPasses;
+		namespace GPUCulling
+		{
+			class Scene;
+		}
 
 		class World : public std::enable_shared_from_this<Renderer::World>
 		{
@@ -120,8 +127,22 @@ namespace Renderer
 			mutable decltype(bvh)::View bvhView;
 			mutable std::list<Renderer::Instance, AllocatorProxy<Renderer::Instance>> staticObjects;
 			mutable TrackedResource<ID3D12Resource> staticObjectsCB;
+			mutable std::shared_ptr<const GPUCulling::Scene> GPUCullingScene;	// flattened BVH, built on demand
 			struct StaticObjectData;
 			void InvalidateStaticObjects();
+			void BuildGPUCullingScene() const;
+
+		private:
+			/*
+				instance data slots in 'staticObjectsCB'
+				freed slots retired until GPU completes frames which could reference them, only new instances' slots uploaded on flush
+			*/
+			unsigned int staticObjectSlotCount{};
+			std::vector<unsigned int> freeStaticObjectSlots;
+			std::deque<std::pair<UINT64, unsigned int>> retiredStaticObjectSlots;	// frame ID, slot
+			mutable std::vector<Renderer::Instance *> pendingStaticObjectUploads;
+			unsigned int AllocateStaticObjectSlot();
+			void RemoveStaticObject(decltype(staticObjects)::const_iterator location);
 
 		private:
 			mutable size_t queryStreamLenCache{}, renderStreamsLenCache[2]{};
@@ -156,6 +177,10 @@ namespace Renderer
 			std::shared_ptr<Renderer::TerrainVectorLayer> AddTerrainVectorLayer(std::shared_ptr<TerrainMaterials::Interface> layerMaterial, unsigned int layerIdx, std::string layerName);
 			InstancePtr AddStaticObject(Renderer::Object3D object, const float (&xform)[4][3], const AABB<3> &worldAABB);
 			void FlushUpdates() const;	// const to be able to call from Render()
+			// GPU-driven culling of static objects instead of CPU BVH traversal with occlusion queries, checked every frame
+			static void __cdecl EnableGPUCulling(bool enable) noexcept;
+			// compares GPU cull results against CPU reference ('GPUCulling::CullReference()') asynchronously, mismatches reported to stderr
+			static void __cdecl EnableGPUCullingValidation(bool enable) noexcept;
 
 		private:
 			StageExchange ScheduleRenderStage(WorldViewContext &viewCtx, const HLSL::float4x4 &frustumTransform, const HLSL::float4x3 &worldViewTransform, UINT64 tonemapParamsGPUAddress, const RenderPasses::PipelineROPTargets &ROPTargets) const;
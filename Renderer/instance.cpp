@@ -16,4 +16,15 @@ void Impl::Instance::Render(ID3D12GraphicsCommandList4 *cmdList) const
 {
 	cmdList->SetGraphicsRootConstantBufferView(Renderer::Object3D::ROOT_PARAM_INSTANCE_DATA_CBV/*consider callback to root param binding abstraction instead*/, CB_GPU_ptr);
 	object.Render(cmdList);
+}
+
+void Impl::Instance::Render(ID3D12GraphicsCommandList4 *cmdList, UINT64 instancesCB_GPU_ptr, unsigned int instanceCount) const
+{
+	cmdList->SetGraphicsRootConstantBufferView(Renderer::Object3D::ROOT_PARAM_INSTANCE_DATA_CBV, instancesCB_GPU_ptr);
+	object.Render(cmdList, instanceCount);
+}
+
+D3D12_DRAW_INDEXED_ARGUMENTS Impl::Instance::GetDrawArgs(unsigned short int subobjIdx) const
+{
+	return object.GetDrawArgs(subobjIdx);
 }
\ No newline at end of file
@@ -11,6 +11,9 @@
 #include "terrain render stages.h"
 #include "terrain materials.hh"
 #include "object 3D.hh"
+#include "GPU culling.h"
+#include "PSO library.h"
+#include "memory accounting.h"
 #include "tracked resource.inl"
 #include "GPU stream buffer allocator.inl"
 
@@ -25,13 +28,15 @@ using Renderer::Impl::Viewport;
 using Renderer::Impl::World;
 using Renderer::TerrainVectorQuad;
 using Renderer::Impl::Object3D;
+namespace GPUCulling = Renderer::Impl::GPUCulling;
 using Microsoft::WRL::ComPtr;
 namespace TerrainMaterials = Renderer::TerrainMaterials;
 
 static constexpr size_t maxD3D12NameLength = 256;
 
 // set it as default?
-pmr::synchronized_pool_resource globalTransientRAM;
+static Renderer::MemoryAccounting::AccountedMemoryResource transientRAMUpstream(Renderer::MemoryAccounting::Category::TransientRAM);
+pmr::synchronized_pool_resource globalTransientRAM(&transientRAMUpstream);
 
 void NameObject(ID3D12Object *object, LPCWSTR name) noexcept
 {
@@ -317,6 +322,7 @@ static inline Optional TryCreate(const char object[])
 			PrintCreateError(current_exception(), object);
 		}
 	}
+	device.Reset();	// force recreation everything in 'InitRenderer()'
 	return nullopt;
 }
 
@@ -365,8 +371,14 @@ ComPtr<ID3D12RootSignature>
 	World::MainRenderStage::xformAABB_rootSig										= Try(World::MainRenderStage::CreateXformAABB_RootSig, "Xform 3D AABB root signature"),
 	World::MainRenderStage::cullPassRootSig											= Try(World::MainRenderStage::CreateCullPassRootSig, "world objects occlusion query root signature"),
 	World::DebugRenderStage::AABB_rootSig											= Try(World::DebugRenderStage::CreateAABB_RootSig, "world 3D objects AABB visualization root signature"),
-	Object3D::rootSig																= Try(Object3D::CreateRootSig, "object 3D root signature");
-ComPtr<ID3D12PipelineState>
+	Object3D::rootSig																= Try(Object3D::CreateRootSig, "object 3D root signature"),
+	GPUCulling::Scene::rootSig														= Try(GPUCulling::Scene::CreateRootSig, "GPU culling root signature");
+// PSOs compiled asynchronously => should be defined before them in order to be destroyed after pending compilations finish
+namespace Renderer::Impl
+{
+	decltype(globalPSOLibrary) globalPSOLibrary = TryCreate<decltype(globalPSOLibrary)>("PSO library");
+}
+Renderer::Impl::DeferredPSO
 	Viewport::tonemapTextureReductionPSO											= Try(Viewport::CreateTonemapTextureReductionPSO, "tonemap texture reduction PSO"),
 	Viewport::tonemapBufferReductionPSO												= Try(Viewport::CreateTonemapBufferReductionPSO, "tonemap buffer reduction PSO"),
 	Viewport::tonemapPSO															= Try(Viewport::CreateTonemapPSO, "tonemapping PSO"),
@@ -376,10 +388,12 @@ ComPtr<ID3D12PipelineState>
 	TerrainMaterials::Masked::PSO													= Try(TerrainMaterials::Masked::CreatePSO, "terrain masked material PSO"),
 	TerrainMaterials::Standard::PSO													= Try(TerrainMaterials::Standard::CreatePSO, "terrain standard material PSO"),
 	TerrainMaterials::Extended::PSO													= Try(TerrainMaterials::Extended::CreatePSO, "terrain extended material PSO"),
-	World::MainRenderStage::xformAABB_PSO											= Try(World::MainRenderStage::CreateXformAABB_PSO, "Xform 3D AABB PSO");
+	World::MainRenderStage::xformAABB_PSO											= Try(World::MainRenderStage::CreateXformAABB_PSO, "Xform 3D AABB PSO"),
+	GPUCulling::Scene::PSO															= Try(GPUCulling::Scene::CreatePSO, "GPU culling PSO");
 decltype(World::MainRenderStage::cullPassPSOs) World::MainRenderStage::cullPassPSOs	= Try(World::MainRenderStage::CreateCullPassPSOs, "world objects occlusion query passes PSOs");
 decltype(World::DebugRenderStage::AABB_PSOs) World::DebugRenderStage::AABB_PSOs		= Try(World::DebugRenderStage::CreateAABB_PSOs, "world 3D objects AABB visualization PSOs");
 decltype(Object3D::PSOs) Object3D::PSOs												= Try(Object3D::CreatePSOs, "object 3D PSOs");
+ComPtr<ID3D12CommandSignature> Object3D::indirectCmdSignature						= Try(Object3D::CreateIndirectCmdSignature, "object 3D indirect command signature");
 
 // should be defined before globalFrameVersioning in order to be destroyed after waiting in globalFrameVersioning dtor completes
 using Renderer::Impl::World;
@@ -426,9 +440,11 @@ decltype(QueryBatch<OcclusionCulling::TRANSIENT>::resultsPool) QueryBatch<Occlus
 // allocators contains tracked resource (=> after globalFrameVersioning)
 decltype(TerrainVectorQuad::MainRenderStage::GPU_AABB_allocator) TerrainVectorQuad::MainRenderStage::GPU_AABB_allocator = TryCreate<decltype(TerrainVectorQuad::MainRenderStage::GPU_AABB_allocator)>("GPU AABB allocator for terrain vector layers");
 decltype(World::MainRenderStage::GPU_AABB_allocator) World::MainRenderStage::GPU_AABB_allocator = TryCreate<decltype(World::MainRenderStage::GPU_AABB_allocator)>("GPU AABB allocator for world 3D objects");
+decltype(World::MainRenderStage::instancesCB_allocator) World::MainRenderStage::instancesCB_allocator = TryCreate<decltype(World::MainRenderStage::instancesCB_allocator)>("instances CB allocator for world 3D objects");
 decltype(World::MainRenderStage::xformedAABBsStorage) World::MainRenderStage::xformedAABBsStorage;
 
 bool enableDebugDraw;
+atomic<bool> enableGPUCulling, validateGPUCulling;
 
 extern void __cdecl InitRenderer()
 {
@@ -443,6 +459,7 @@ extern void __cdecl InitRenderer()
 		dmaQueue											= CreateDMACommandQueue();
 		TextureSamplers::Impl::heap							= TextureSamplers::Impl::CreateHeap();
 		RenderOutput::tonemapReductionBuffer				= RenderOutput::CreateTonemapReductionBuffer();
+		Renderer::Impl::globalPSOLibrary.emplace();
 		Viewport::tonemapRootSig							= Viewport::CreateTonemapRootSig();
 		Viewport::tonemapTextureReductionPSO				= Viewport::CreateTonemapTextureReductionPSO();
 		Viewport::tonemapBufferReductionPSO					= Viewport::CreateTonemapBufferReductionPSO();
@@ -467,6 +484,9 @@ extern void __cdecl InitRenderer()
 		World::DebugRenderStage::AABB_PSOs					= World::DebugRenderStage::CreateAABB_PSOs();
 		Object3D::rootSig									= Object3D::CreateRootSig();
 		Object3D::PSOs										= Object3D::CreatePSOs();
+		Object3D::indirectCmdSignature						= Object3D::CreateIndirectCmdSignature();
+		GPUCulling::Scene::rootSig							= GPUCulling::Scene::CreateRootSig();
+		GPUCulling::Scene::PSO								= GPUCulling::Scene::CreatePSO();
 		World::globalGPUBuffer								= World::CreateGlobalGPUBuffer();
 #if PERSISTENT_MAPS
 		World::globalGPUBuffer_CPU_ptr						= World::MapGlobalGPUBuffer();
@@ -475,6 +495,7 @@ extern void __cdecl InitRenderer()
 		GPUDescriptorHeap::Impl::heap						= GPUDescriptorHeap::Impl::PreallocateHeap();
 		TerrainVectorQuad::MainRenderStage::GPU_AABB_allocator.emplace();
 		World::MainRenderStage::GPU_AABB_allocator.emplace();
+		World::MainRenderStage::instancesCB_allocator.emplace();
 		DMAEngine::cmdBuffers								= DMAEngine::CreateCmdBuffers();
 		DMAEngine::fence									= DMAEngine::CreateFence();
 	}
@@ -0,0 +1,287 @@
+#include "stdafx.h"
+#include "memory accounting.h"
+
+using namespace std;
+using namespace Renderer;
+using namespace Renderer::MemoryAccounting;
+using Microsoft::WRL::ComPtr;
+
+extern ComPtr<ID3D12Device2> device;
+
+namespace
+{
+	struct AtomicCounters
+	{
+		atomic<unsigned long long int> bytes, peakBytes;
+		atomic<unsigned long int> allocations;
+
+	public:
+		operator Counters() const noexcept
+		{
+			return { bytes.load(memory_order_relaxed), peakBytes.load(memory_order_relaxed), allocations.load(memory_order_relaxed) };
+		}
+	};
+
+	struct Budget
+	{
+		atomic<unsigned long long int> limit = ULLONG_MAX;
+		BudgetCallback callback;	// guarded by 'budgetsMtx'
+	};
+
+	// zero initialized statically, ready for resources created during dynamic init
+	AtomicCounters counters[unsigned(Category::Count)][unsigned(HeapType::Count)], heapTotals[unsigned(HeapType::Count)];
+
+	struct Budgets
+	{
+		mutex mtx;
+		Budget categories[unsigned(Category::Count)][unsigned(HeapType::Count)], heapTotals[unsigned(HeapType::Count)];
+	};
+
+	// function local static to be usable during dynamic init of other TUs
+	Budgets &GetBudgets()
+	{
+		static Budgets budgets;
+		return budgets;
+	}
+
+	constexpr const char *categoryNames[] =
+	{
+		"render targets",
+		"geometry",
+		"textures",
+		"constant buffers",
+		"stream buffers",
+		"DMA upload",
+		"occlusion queries",
+		"descriptors",
+		"GPU culling",
+		"transient RAM",
+		"misc",
+	};
+	static_assert(size(categoryNames) == unsigned(Category::Count));
+
+	constexpr const char *heapTypeNames[] =
+	{
+		"upload",
+		"default",
+		"readback",
+		"sysRAM",
+	};
+	static_assert(size(heapTypeNames) == unsigned(HeapType::Count));
+
+	// {8E3CAD7A-3A54-4B6B-9C1B-6D5A0D8F1E42}
+	constexpr GUID recordGUID = { 0x8e3cad7a, 0x3a54, 0x4b6b, { 0x9c, 0x1b, 0x6d, 0x5a, 0xd, 0x8f, 0x1e, 0x42 } };
+
+	// lives in D3D object private data => gets released with the object (after GPU done with it thanks to resource retirement)
+	class Record final : public IUnknown
+	{
+		atomic<ULONG> refCount = 1;
+		const Category category;
+		const HeapType heapType;
+		const unsigned long long int size;
+
+	public:
+		Record(Category category, HeapType heapType, unsigned long long int size) : category(category), heapType(heapType), size(size)
+		{
+			MemoryAccounting::Allocate(category, heapType, size);
+		}
+
+		~Record()
+		{
+			MemoryAccounting::Free(category, heapType, size);
+		}
+
+	public:
+		HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void **object) override
+		{
+			if (!object)
+				return E_POINTER;
+			if (riid == __uuidof(IUnknown))
+			{
+				AddRef();
+				*object = this;
+				return S_OK;
+			}
+			*object = NULL;
+			return E_NOINTERFACE;
+		}
+
+		ULONG STDMETHODCALLTYPE AddRef() override
+		{
+			return refCount.fetch_add(1, memory_order_relaxed) + 1;
+		}
+
+		ULONG STDMETHODCALLTYPE Release() override
+		{
+			const ULONG left = refCount.fetch_sub(1, memory_order_acq_rel) - 1;
+			if (!left)
+				delete this;
+			return left;
+		}
+	};
+
+	void Attach(ID3D12Object *object, Category category, HeapType heapType, unsigned long long int size)
+	{
+		ComPtr<Record> record;
+		record.Attach(new Record(category, heapType, size));
+		CheckHR(object->SetPrivateDataInterface(recordGUID, record.Get()));
+	}
+
+	template<typename T>
+	void AtomicMax(atomic<T> &dst, T src) noexcept
+	{
+		for (auto stored = dst.load(memory_order_relaxed); stored < src && !dst.compare_exchange_weak(stored, src, memory_order_relaxed););
+	}
+
+	void Account(AtomicCounters &counters, Budget &budget, unsigned long long int size)
+	{
+		const auto bytes = counters.bytes.fetch_add(size, memory_order_relaxed) + size;
+		counters.allocations.fetch_add(1, memory_order_relaxed);
+		AtomicMax(counters.peakBytes, bytes);
+
+		// only the allocation crossing budget triggers callback
+		if (const auto limit = budget.limit.load(memory_order_relaxed); bytes > limit && bytes - size <= limit)
+		{
+			BudgetCallback callback;
+			{
+				lock_guard lck(GetBudgets().mtx);
+				callback = budget.callback;
+			}
+			// invoke outside lock to allow callback to query/adjust budgets
+			if (callback)
+				callback(bytes, limit);
+		}
+	}
+
+	void SetBudget(Budget &budget, unsigned long long int limit, BudgetCallback &&callback)
+	{
+		lock_guard lck(GetBudgets().mtx);
+		budget.callback = move(callback);
+		budget.limit.store(limit, memory_order_relaxed);
+	}
+}
+
+static HeapType ClassifyHeap(const D3D12_HEAP_PROPERTIES &heapProps)
+{
+	switch (heapProps.Type)
+	{
+	case D3D12_HEAP_TYPE_UPLOAD:
+		return HeapType::Upload;
+	case D3D12_HEAP_TYPE_READBACK:
+		return HeapType::Readback;
+	case D3D12_HEAP_TYPE_CUSTOM:
+		return heapProps.MemoryPoolPreference == D3D12_MEMORY_POOL_L0 ? HeapType::SysRAM : HeapType::Default;
+	default:
+		return HeapType::Default;
+	}
+}
+
+#pragma region internal
+void MemoryAccounting::Track(ID3D12Resource *resource, Category category)
+{
+	D3D12_HEAP_PROPERTIES heapProps;
+	CheckHR(resource->GetHeapProperties(&heapProps, NULL));
+	const auto desc = resource->GetDesc();
+	Attach(resource, category, ClassifyHeap(heapProps), device->GetResourceAllocationInfo(0, 1, &desc).SizeInBytes);
+}
+
+void MemoryAccounting::Track(ID3D12DescriptorHeap *heap, Category category)
+{
+	const auto desc = heap->GetDesc();
+	Attach(heap, category, desc.Flags & D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE ? HeapType::Default : HeapType::SysRAM,
+		UINT64(desc.NumDescriptors) * device->GetDescriptorHandleIncrementSize(desc.Type));
+}
+
+// actual query heap size is implementation defined, use resolved results size as estimate
+void MemoryAccounting::Track(ID3D12QueryHeap *heap, const D3D12_QUERY_HEAP_DESC &desc, Category category)
+{
+	Attach(heap, category, HeapType::Default, UINT64(desc.Count) * sizeof(UINT64));
+}
+
+void MemoryAccounting::Allocate(Category category, HeapType heapType, unsigned long long int size)
+{
+	auto &budgets = GetBudgets();
+	Account(counters[unsigned(category)][unsigned(heapType)], budgets.categories[unsigned(category)][unsigned(heapType)], size);
+	Account(heapTotals[unsigned(heapType)], budgets.heapTotals[unsigned(heapType)], size);
+}
+
+void MemoryAccounting::Free(Category category, HeapType heapType, unsigned long long int size) noexcept
+{
+	for (AtomicCounters *counters : { &::counters[unsigned(category)][unsigned(heapType)], &heapTotals[unsigned(heapType)] })
+	{
+		counters->bytes.fetch_sub(size, memory_order_relaxed);
+		counters->allocations.fetch_sub(1, memory_order_relaxed);
+	}
+}
+
+void *MemoryAccounting::AccountedMemoryResource::do_allocate(size_t size, size_t alignment)
+{
+	void *const ptr = pmr::new_delete_resource()->allocate(size, alignment);
+	Allocate(category, HeapType::SysRAM, size);
+	return ptr;
+}
+
+void MemoryAccounting::AccountedMemoryResource::do_deallocate(void *ptr, size_t size, size_t alignment)
+{
+	pmr::new_delete_resource()->deallocate(ptr, size, alignment);
+	Free(category, HeapType::SysRAM, size);
+}
+
+bool MemoryAccounting::AccountedMemoryResource::do_is_equal(const memory_resource &other) const noexcept
+{
+	return this == &other;
+}
+#pragma endregion
+
+#pragma region public
+Counters __cdecl MemoryAccounting::Query(Category category, HeapType heapType) noexcept
+{
+	return counters[unsigned(category)][unsigned(heapType)];
+}
+
+Counters __cdecl MemoryAccounting::Query(HeapType heapType) noexcept
+{
+	return heapTotals[unsigned(heapType)];
+}
+
+// counters read one by one, snapshot is not atomic as a whole
+Snapshot __cdecl MemoryAccounting::TakeSnapshot() noexcept
+{
+	Snapshot snapshot;
+	for (unsigned category = 0; category < unsigned(Category::Count); category++)
+		copy(cbegin(counters[category]), cend(counters[category]), snapshot.counters[category]);
+	copy(cbegin(heapTotals), cend(heapTotals), snapshot.heapTotals);
+	return snapshot;
+}
+
+void __cdecl MemoryAccounting::Dump(const Snapshot &snapshot, ostream &dst)
+{
+	constexpr auto KB = 1024.;
+	const auto print = [&dst](const char *name, const Counters &counters)
+	{
+		dst << "\t" << left << setw(20) << name << right << fixed << setprecision(1)
+			<< setw(12) << counters.bytes / KB << " KB (peak " << setw(12) << counters.peakBytes / KB << " KB), " << counters.allocations << " allocations" << endl;
+	};
+
+	const auto flags = dst.flags();
+	for (unsigned heapType = 0; heapType < unsigned(HeapType::Count); heapType++)
+	{
+		dst << heapTypeNames[heapType] << ":" << endl;
+		for (unsigned category = 0; category < unsigned(Category::Count); category++)
+			if (const auto &counters = snapshot.counters[category][heapType]; counters.peakBytes)
+				print(categoryNames[category], counters);
+		print("total", snapshot.heapTotals[heapType]);
+	}
+	dst.flags(flags);
+}
+
+void __cdecl MemoryAccounting::SetBudget(Category category, HeapType heapType, unsigned long long int budget, BudgetCallback callback)
+{
+	::SetBudget(GetBudgets().categories[unsigned(category)][unsigned(heapType)], budget, move(callback));
+}
+
+void __cdecl MemoryAccounting::SetBudget(HeapType heapType, unsigned long long int budget, BudgetCallback callback)
+{
+	::SetBudget(GetBudgets().heapTotals[unsigned(heapType)], budget, move(callback));
+}
+#pragma endregion
\ No newline at end of file
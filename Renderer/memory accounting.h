@@ -0,0 +1,34 @@
+#pragma once
+
+#include <memory_resource>
+#include "memory accounting.hh"
+
+struct ID3D12Resource;
+struct ID3D12DescriptorHeap;
+struct ID3D12QueryHeap;
+struct D3D12_QUERY_HEAP_DESC;
+
+// renderer internal part
+namespace Renderer::MemoryAccounting
+{
+	// attach accounting record to D3D object, it gets unaccounted on object destruction
+	void Track(ID3D12Resource *resource, Category category);
+	void Track(ID3D12DescriptorHeap *heap, Category category);
+	void Track(ID3D12QueryHeap *heap, const D3D12_QUERY_HEAP_DESC &desc, Category category);
+
+	void Allocate(Category category, HeapType heapType, unsigned long long int size), Free(Category category, HeapType heapType, unsigned long long int size) noexcept;
+
+	// upstream for pmr pools, accounted as SysRAM
+	class AccountedMemoryResource final : public std::pmr::memory_resource
+	{
+		const Category category;
+
+	public:
+		explicit constexpr AccountedMemoryResource(Category category) noexcept : category(category) {}
+
+	private:
+		void *do_allocate(std::size_t size, std::size_t alignment) override;
+		void do_deallocate(void *ptr, std::size_t size, std::size_t alignment) override;
+		bool do_is_equal(const memory_resource &other) const noexcept override;
+	};
+}
\ No newline at end of file
@@ -7,6 +7,8 @@
 #include "fresnel.h"
 #include "shader bytecode.h"
 #include "config.h"
+#include "GPU culling.h"
+#include "memory accounting.h"
 #ifdef _MSC_VER
 #include <codecvt>
 #include <locale>
@@ -383,6 +385,7 @@ ComPtr<ID3D12DescriptorHeap> Impl::Object3D::DescriptorTablePack::CreateBackingS
 		D3D12_DESCRIPTOR_HEAP_FLAG_NONE			// GPU invisible
 	};
 	CheckHR(device->CreateDescriptorHeap(&packDesc, IID_PPV_ARGS(CPUStore.GetAddressOf())));
+	MemoryAccounting::Track(CPUStore.Get(), MemoryAccounting::Category::Descriptors);
 #ifdef _MSC_VER
 	NameObjectF(CPUStore.Get(), L"\"%ls\" descriptor table CPU backing store", objectName.c_str());
 #else
@@ -497,77 +500,114 @@ auto Impl::Object3D::CreatePSOs() -> decltype(PSOs)
 		.Flags					= D3D12_PIPELINE_STATE_FLAG_NONE
 	};
 
-	CheckHR(device->CreateGraphicsPipelineState(&PSO_desc, IID_PPV_ARGS(result[false].flat.GetAddressOf())));
-	NameObject(result[false].flat.Get(), L"object 3D [flat] PSO");
+	result[false].flat = globalPSOLibrary->Compile(PSO_desc, L"object 3D [flat] PSO");
 
 	PSO_desc.RasterizerState.CullMode = D3D12_CULL_MODE_NONE;
-	CheckHR(device->CreateGraphicsPipelineState(&PSO_desc, IID_PPV_ARGS(result[true].flat.GetAddressOf())));
-	NameObject(result[true].flat.Get(), L"object 3D [doublesided][flat] PSO");
+	result[true].flat = globalPSOLibrary->Compile(PSO_desc, L"object 3D [doublesided][flat] PSO");
 
 	PSO_desc.InputLayout.NumElements = VBDECLSIZE_TEX;
 	PSO_desc.VS = ShaderBytecode(Shaders::object3DTex_VS);
 	PSO_desc.PS = ShaderBytecode(Shaders::object3DTex_PS);
 	PSO_desc.RasterizerState.CullMode = D3D12_CULL_MODE_BACK;
-	CheckHR(device->CreateGraphicsPipelineState(&PSO_desc, IID_PPV_ARGS(result[false].tex[false].GetAddressOf())));
-	NameObject(result[false].tex[false].Get(), L"object 3D [textured] PSO");
+	result[false].tex[false] = globalPSOLibrary->Compile(PSO_desc, L"object 3D [textured] PSO");
 
 	PSO_desc.RasterizerState.CullMode = D3D12_CULL_MODE_NONE;
-	CheckHR(device->CreateGraphicsPipelineState(&PSO_desc, IID_PPV_ARGS(result[true].tex[false].GetAddressOf())));
-	NameObject(result[true].tex[false].Get(), L"object 3D [doublesided][textured] PSO");
+	result[true].tex[false] = globalPSOLibrary->Compile(PSO_desc, L"object 3D [doublesided][textured] PSO");
 
 	PSO_desc.PS = ShaderBytecode(Shaders::object3DAlphatest_PS);
 	PSO_desc.RasterizerState.CullMode = D3D12_CULL_MODE_BACK;
-	CheckHR(device->CreateGraphicsPipelineState(&PSO_desc, IID_PPV_ARGS(result[false].tex[true].GetAddressOf())));
-	NameObject(result[false].tex[true].Get(), L"object 3D [alphatest] PSO");
+	result[false].tex[true] = globalPSOLibrary->Compile(PSO_desc, L"object 3D [alphatest] PSO");
 
 	PSO_desc.RasterizerState.CullMode = D3D12_CULL_MODE_NONE;
-	CheckHR(device->CreateGraphicsPipelineState(&PSO_desc, IID_PPV_ARGS(result[true].tex[true].GetAddressOf())));
-	NameObject(result[true].tex[true].Get(), L"object 3D [doublesided][alphatest] PSO");
+	result[true].tex[true] = globalPSOLibrary->Compile(PSO_desc, L"object 3D [doublesided][alphatest] PSO");
 
 	PSO_desc.PS = ShaderBytecode(Shaders::object3DGlass_PS);
 	PSO_desc.RasterizerState.CullMode = D3D12_CULL_MODE_BACK;
-	CheckHR(device->CreateGraphicsPipelineState(&PSO_desc, IID_PPV_ARGS(result[false].advanced[GLASS_MASK_FLAG - 1].GetAddressOf())));
-	NameObject(result[false].advanced[GLASS_MASK_FLAG - 1].Get(), L"object 3D [glass mask] PSO");
+	result[false].advanced[GLASS_MASK_FLAG - 1] = globalPSOLibrary->Compile(PSO_desc, L"object 3D [glass mask] PSO");
 
 	PSO_desc.RasterizerState.CullMode = D3D12_CULL_MODE_NONE;
-	CheckHR(device->CreateGraphicsPipelineState(&PSO_desc, IID_PPV_ARGS(result[true].advanced[GLASS_MASK_FLAG - 1].GetAddressOf())));
-	NameObject(result[true].advanced[GLASS_MASK_FLAG - 1].Get(), L"object 3D [doublesided][glass mask] PSO");
+	result[true].advanced[GLASS_MASK_FLAG - 1] = globalPSOLibrary->Compile(PSO_desc, L"object 3D [doublesided][glass mask] PSO");
 
 	PSO_desc.PS = ShaderBytecode(Shaders::object3DTV_VS);
 	PSO_desc.PS = ShaderBytecode(Shaders::object3DTV_PS);
 	PSO_desc.RasterizerState.CullMode = D3D12_CULL_MODE_BACK;
-	CheckHR(device->CreateGraphicsPipelineState(&PSO_desc, IID_PPV_ARGS(result[false].TV.GetAddressOf())));
-	NameObject(result[false].TV.Get(), L"object 3D [TV] PSO");
+	result[false].TV = globalPSOLibrary->Compile(PSO_desc, L"object 3D [TV] PSO");
 
 	PSO_desc.RasterizerState.CullMode = D3D12_CULL_MODE_NONE;
-	CheckHR(device->CreateGraphicsPipelineState(&PSO_desc, IID_PPV_ARGS(result[true].TV.GetAddressOf())));
-	NameObject(result[true].TV.Get(), L"object 3D [doublesided][TV] PSO");
+	result[true].TV = globalPSOLibrary->Compile(PSO_desc, L"object 3D [doublesided][TV] PSO");
 
 	PSO_desc.InputLayout.NumElements = VBDECLSIZE_FULL;
 	PSO_desc.VS = ShaderBytecode(Shaders::object3DBump_VS);
 	PSO_desc.PS = ShaderBytecode(Shaders::object3DBump_PS);
 	PSO_desc.RasterizerState.CullMode = D3D12_CULL_MODE_BACK;
-	CheckHR(device->CreateGraphicsPipelineState(&PSO_desc, IID_PPV_ARGS(result[false].advanced[NORMAL_MAP_FLAG - 1].GetAddressOf())));
-	NameObject(result[false].advanced[NORMAL_MAP_FLAG - 1].Get(), L"object 3D [normal map] PSO");
+	result[false].advanced[NORMAL_MAP_FLAG - 1] = globalPSOLibrary->Compile(PSO_desc, L"object 3D [normal map] PSO");
 
 	PSO_desc.RasterizerState.CullMode = D3D12_CULL_MODE_NONE;
-	CheckHR(device->CreateGraphicsPipelineState(&PSO_desc, IID_PPV_ARGS(result[true].advanced[NORMAL_MAP_FLAG - 1].GetAddressOf())));
-	NameObject(result[true].advanced[NORMAL_MAP_FLAG - 1].Get(), L"object 3D [doublesided][normal map] PSO");
+	result[true].advanced[NORMAL_MAP_FLAG - 1] = globalPSOLibrary->Compile(PSO_desc, L"object 3D [doublesided][normal map] PSO");
 
 	PSO_desc.PS = ShaderBytecode(Shaders::object3DBumpGlass_PS);
 	PSO_desc.RasterizerState.CullMode = D3D12_CULL_MODE_BACK;
-	CheckHR(device->CreateGraphicsPipelineState(&PSO_desc, IID_PPV_ARGS(result[false].advanced[(NORMAL_MAP_FLAG | GLASS_MASK_FLAG) - 1].GetAddressOf())));
-	NameObject(result[false].advanced[(NORMAL_MAP_FLAG | GLASS_MASK_FLAG) - 1].Get(), L"object 3D [normal map][glass mask] PSO");
+	result[false].advanced[(NORMAL_MAP_FLAG | GLASS_MASK_FLAG) - 1] = globalPSOLibrary->Compile(PSO_desc, L"object 3D [normal map][glass mask] PSO");
 
 	PSO_desc.RasterizerState.CullMode = D3D12_CULL_MODE_NONE;
-	CheckHR(device->CreateGraphicsPipelineState(&PSO_desc, IID_PPV_ARGS(result[true].advanced[(NORMAL_MAP_FLAG | GLASS_MASK_FLAG) - 1].GetAddressOf())));
-	NameObject(result[true].advanced[(NORMAL_MAP_FLAG | GLASS_MASK_FLAG) - 1].Get(), L"object 3D [doublesided][normal map][glass mask] PSO");
+	result[true].advanced[(NORMAL_MAP_FLAG | GLASS_MASK_FLAG) - 1] = globalPSOLibrary->Compile(PSO_desc, L"object 3D [doublesided][normal map][glass mask] PSO");
 
 	return result;
 }
 
+ComPtr<ID3D12CommandSignature> Impl::Object3D::CreateIndirectCmdSignature()
+{
+	ComPtr<ID3D12CommandSignature> result;
+	const D3D12_INDIRECT_ARGUMENT_DESC args[] =
+	{
+		{ .Type = D3D12_INDIRECT_ARGUMENT_TYPE_CONSTANT_BUFFER_VIEW, .ConstantBufferView = { ROOT_PARAM_INSTANCE_DATA_CBV } },
+		{ .Type = D3D12_INDIRECT_ARGUMENT_TYPE_DRAW_INDEXED }
+	};
+	static_assert(sizeof(D3D12_GPU_VIRTUAL_ADDRESS) + sizeof(D3D12_DRAW_INDEXED_ARGUMENTS) == GPUCulling::indirectCmdSize);
+	const D3D12_COMMAND_SIGNATURE_DESC desc =
+	{
+		.ByteStride			= GPUCulling::indirectCmdSize,
+		.NumArgumentDescs	= size(args),
+		.pArgumentDescs		= args
+	};
+	CheckHR(device->CreateCommandSignature(&desc, rootSig.Get(), IID_PPV_ARGS(result.GetAddressOf())));
+	NameObject(result.Get(), L"object 3D indirect command signature");
+	return result;
+}
+
 namespace
 {
+	// exceptions are not allowed to escape parallel STL algorithms (would terminate), first one gets rethrown
+	void ParallelFor(unsigned int taskCount, const function<void __cdecl(unsigned int taskIdx)> &task, const Object3D::WorkerPool &workerPool)
+	{
+		exception_ptr error;
+		atomic_flag errorCaptured;
+		const auto guardedTask = [&](unsigned int taskIdx)
+		{
+			try
+			{
+				task(taskIdx);
+			}
+			catch (...)
+			{
+				if (!errorCaptured.test_and_set())
+					error = current_exception();
+			}
+		};
+
+		if (workerPool)
+			workerPool(taskCount, guardedTask);
+		else
+		{
+			vector<unsigned int> tasks(taskCount);
+			iota(tasks.begin(), tasks.end(), 0u);
+			for_each(execution::par, tasks.cbegin(), tasks.cend(), guardedTask);
+		}
+
+		if (error)
+			rethrow_exception(error);
+	}
+
 	inline const auto &ExtractBase(const Object3D::SubobjectDataCallback::result_type &subobjData)
 	{
 		return visit([](const auto &src) noexcept -> const Object3D::SubobjectDataBase & { return src; }, subobjData);
@@ -594,14 +634,48 @@ namespace
 	};
 }
 
-Impl::Object3D::Object3D(unsigned short int subobjCount, const SubobjectDataCallback &getSubobjectData, string name) :
-	// use C++20 make_shared for arrays
-	subobjects(new Subobject[subobjCount]), tricount(), subobjCount(subobjCount)
+inline auto Impl::Object3D::ConvertName(string &&name) -> ObjectName
+{
+#ifdef _MSC_VER
+	// same workaround as for terrain quad
+#if 0
+	wstring_convert<codecvt_utf8<WCHAR>> converter;
+	return converter.from_bytes(name);
+#else
+	return { name.cbegin(), name.cend() };
+#endif
+#else
+	return move(name);
+#endif
+}
+
+Impl::Object3D::Object3D(unsigned short int subobjCount, const SubobjectDataCallback &getSubobjectData, string name)
+{
+	auto convertedName = ConvertName(move(name));
+	const auto CB_offsets = Parse(subobjCount, getSubobjectData, convertedName);
+
+	// fill GPUBuffer (second pass)
+	auto mapped = CreateGPUBuffer(convertedName);
+	for (unsigned short i = 0; i < subobjCount; i++)
+		FillSubobject(getSubobjectData, i, mapped.get(), CB_offsets[i]);
+	mapped.reset();
+
+	StartBundleCreation(move(convertedName));
+}
+
+// first pass: subobjects setup, GPUBuffer layout, returns material CB offsets
+vector<unsigned long int> Impl::Object3D::Parse(unsigned short int subobjCount, const SubobjectDataCallback &getSubobjectData, const ObjectName &name)
 {
 	if (!subobjCount)
 		throw logic_error("Attempt to create empty 3D object");
 
+	// use C++20 make_shared for arrays
+	subobjects.reset(new Subobject[subobjCount]);
+	tricount = 0;
+	this->subobjCount = subobjCount;
+
 	unsigned long int CB_size = 0, vcount = 0, uvcount = 0, tgcount = 0;
+	vector<unsigned long int> CB_offsets(subobjCount);
 
 	enum
 	{
@@ -613,7 +687,6 @@ Impl::Object3D::Object3D(unsigned short int subobjCount, const SubobjectDataCall
 	vector<TrackedResource<ID3D12Resource>> texs;
 	texs.reserve(subobjCount * TEXTURE_COUNT);
 
-	// first pass
 	for (unsigned short i = 0; i < subobjCount; i++)
 	{
 		const auto curSubobjData = getSubobjectData(i);
@@ -697,29 +770,16 @@ Impl::Object3D::Object3D(unsigned short int subobjCount, const SubobjectDataCall
 
 		vcount += curSubobjDataBase.vcount;
 		tricount += curSubobjDataBase.tricount;
+		CB_offsets[i] = CB_size;
 		CB_size += (subobjects[i] = visit(subobjParser, curSubobjData)).MaterialCBSize();
 	}
 
-#ifdef _MSC_VER
-	// same workaround as for terrain quad
-#if 0
-	wstring_convert<codecvt_utf8<WCHAR>> converter;
-	wstring convertedName = converter.from_bytes(name);
-#else
-	wstring convertedName(name.cbegin(), name.cend());
-#endif
-#endif
-
 	// allocate descriptor table if needed
 	if (!texs.empty())
 	{
 		if (texs.size() > USHRT_MAX)
 			throw out_of_range("3D object material: too many textures.");
-#ifdef _MSC_VER
-		descriptorTablePack = make_shared<DescriptorTablePack>(move(texs), convertedName);
-#else
 		descriptorTablePack = make_shared<DescriptorTablePack>(move(texs), name);
-#endif
 	}
 
 	// rearrange subobjects VBs so that fat ones (with uv and tangents) comes first
@@ -773,71 +833,121 @@ Impl::Object3D::Object3D(unsigned short int subobjCount, const SubobjectDataCall
 		UVB_size = uvcount * sizeof *SubobjectDataUV::uv,
 		TGB_size = tgcount * sizeof *SubobjectData<SubobjectType::Advanced>::tangents,
 		IB_size = tricount * sizeof *SubobjectDataBase::tris;
+	layout = { CB_size, VB_size, UVB_size, TGB_size, IB_size };
+
+	return CB_offsets;
+}
 
-	// create GPUBuffer
+void Impl::Object3D::GPUBufferUnmapper::operator()(std::byte *) const
+{
+	GPUBuffer->Unmap(0, NULL);
+}
+
+// returns mapped GPUBuffer
+auto Impl::Object3D::CreateGPUBuffer(const ObjectName &name) -> MappedGPUBuffer
+{
 	CheckHR(device->CreateCommittedResource(
 		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
 		D3D12_HEAP_FLAG_NONE,
 		&CD3DX12_RESOURCE_DESC::Buffer(
-			CB_size + VB_size * 2/*coord + N*/ + UVB_size + TGB_size + IB_size),
+			layout.CB_size + layout.VB_size * 2/*coord + N*/ + layout.UVB_size + layout.TGB_size + layout.IB_size),
 		D3D12_RESOURCE_STATE_GENERIC_READ,
 		NULL,	// clear value
 		IID_PPV_ARGS(GPUBuffer.GetAddressOf())));
+	MemoryAccounting::Track(GPUBuffer.Get(), MemoryAccounting::Category::Geometry);
 #ifdef _MSC_VER
-	NameObjectF(GPUBuffer.Get(), L"\"%ls\" geometry (contains %hu subobjects)", convertedName.c_str(), subobjCount);
+	NameObjectF(GPUBuffer.Get(), L"\"%ls\" geometry (contains %hu subobjects)", name.c_str(), subobjCount);
 #else
 	NameObjectF(GPUBuffer.Get(), L"\"%s\" geometry (contains %hu subobjects)", name.c_str(), subobjCount);
 #endif
 
-	// fill GPUBuffer (second pass)
-	{
-		volatile void *CB_ptr;
-		CheckHR(GPUBuffer->Map(0, &CD3DX12_RANGE(0, 0), const_cast<void **>(&CB_ptr)));
-		float (*const VB_ptr)[3] = reinterpret_cast<float (*)[3]>(reinterpret_cast<std::byte *>(const_cast<void *>(CB_ptr)) + CB_size);
-		float (*const NB_ptr)[3] = VB_ptr + vcount, (*const UVB_ptr)[2] = reinterpret_cast<float (*)[2]>(NB_ptr + vcount), (*const TGB_ptr)[2][3] = reinterpret_cast<float (*)[2][3]>(UVB_ptr + uvcount);
-		uint16_t (*IB_ptr)[3] = reinterpret_cast<uint16_t (*)[3]>(TGB_ptr + tgcount);
+	void *mapped;
+	CheckHR(GPUBuffer->Map(0, &CD3DX12_RANGE(0, 0), &mapped));
+	return { static_cast<std::byte *>(mapped), { GPUBuffer.Get() } };
+}
 
-		for (unsigned short i = 0; i < subobjCount; i++)
-		{
-			const auto curSubobjData = getSubobjectData(i);
-			const auto &curSubobjDataBase = ExtractBase(curSubobjData);
-			const auto &curSubobj = subobjects[i];
+// subobjects occupy disjoint GPUBuffer ranges => can be filled concurrently
+void Impl::Object3D::FillSubobject(const SubobjectDataCallback &getSubobjectData, unsigned short int subobjIdx, std::byte *mapped, unsigned long int CB_offset) const
+{
+	volatile void *CB_ptr = mapped + CB_offset;
+	float (*const VB_ptr)[3] = reinterpret_cast<float (*)[3]>(mapped + layout.CB_size);
+	float (*const NB_ptr)[3] = reinterpret_cast<float (*)[3]>(reinterpret_cast<std::byte *>(VB_ptr) + layout.VB_size);
+	float (*const UVB_ptr)[2] = reinterpret_cast<float (*)[2]>(reinterpret_cast<std::byte *>(NB_ptr) + layout.VB_size);
+	float (*const TGB_ptr)[2][3] = reinterpret_cast<float (*)[2][3]>(reinterpret_cast<std::byte *>(UVB_ptr) + layout.UVB_size);
+	uint16_t (*const IB_ptr)[3] = reinterpret_cast<uint16_t (*)[3]>(reinterpret_cast<std::byte *>(TGB_ptr) + layout.TGB_size);
+
+	const auto curSubobjData = getSubobjectData(subobjIdx);
+	const auto &curSubobjDataBase = ExtractBase(curSubobjData);
+	const auto &curSubobj = subobjects[subobjIdx];
 
 #if 0
-			// calc AABB if it is not provided
-			if (any(subobjects[i].aabb.Size() < 0.f))
-				for (unsigned idx = 0; idx < curSubobjData.vcount; idx++)
-					subobjects[i].aabb.Refit(curSubobjData.verts[idx]);
+	// calc AABB if it is not provided
+	if (any(subobjects[subobjIdx].aabb.Size() < 0.f))
+		for (unsigned idx = 0; idx < curSubobjData.vcount; idx++)
+			subobjects[subobjIdx].aabb.Refit(curSubobjData.verts[idx]);
 #endif
 
-			curSubobj.FillMaterialCB(CB_ptr);
-			memcpy(VB_ptr + curSubobj.vOffset, curSubobjDataBase.verts, curSubobjDataBase.vcount * sizeof *curSubobjDataBase.verts);
-			memcpy(NB_ptr + curSubobj.vOffset, curSubobjDataBase.normals, curSubobjDataBase.vcount * sizeof *curSubobjDataBase.normals);
-			visit([UVB_ptr, TGB_ptr, &curSubobj]<class DecodedSubobjData>(const DecodedSubobjData &decodedSubobjData)
+	curSubobj.FillMaterialCB(CB_ptr);
+	memcpy(VB_ptr + curSubobj.vOffset, curSubobjDataBase.verts, curSubobjDataBase.vcount * sizeof *curSubobjDataBase.verts);
+	memcpy(NB_ptr + curSubobj.vOffset, curSubobjDataBase.normals, curSubobjDataBase.vcount * sizeof *curSubobjDataBase.normals);
+	visit([UVB_ptr, TGB_ptr, &curSubobj]<class DecodedSubobjData>(const DecodedSubobjData &decodedSubobjData)
+		{
+			if constexpr (is_base_of_v<SubobjectDataUV, DecodedSubobjData>)
+				memcpy(UVB_ptr + curSubobj.vOffset, decodedSubobjData.uv, decodedSubobjData.vcount * sizeof *decodedSubobjData.uv);
+			if constexpr (is_same_v<DecodedSubobjData, SubobjectData<SubobjectType::Advanced>>)
+				if (decodedSubobjData.normalMap)
 				{
-					if constexpr (is_base_of_v<SubobjectDataUV, DecodedSubobjData>)
-						memcpy(UVB_ptr + curSubobj.vOffset, decodedSubobjData.uv, decodedSubobjData.vcount * sizeof *decodedSubobjData.uv);
-					if constexpr (is_same_v<DecodedSubobjData, SubobjectData<SubobjectType::Advanced>>)
-						if (decodedSubobjData.normalMap)
-						{
-							if (!decodedSubobjData.tangents)
-								throw logic_error("Advanced 3D object material provided with normal map but without tangents");
-							memcpy(TGB_ptr + curSubobj.vOffset, decodedSubobjData.tangents, decodedSubobjData.vcount * sizeof *decodedSubobjData.tangents);
-						}
-				}, curSubobjData);
-			memcpy(IB_ptr, curSubobjDataBase.tris, curSubobjDataBase.tricount * sizeof *curSubobjDataBase.tris);
-			IB_ptr += curSubobjDataBase.tricount;
-		}
+					if (!decodedSubobjData.tangents)
+						throw logic_error("Advanced 3D object material provided with normal map but without tangents");
+					memcpy(TGB_ptr + curSubobj.vOffset, decodedSubobjData.tangents, decodedSubobjData.vcount * sizeof *decodedSubobjData.tangents);
+				}
+		}, curSubobjData);
+	memcpy(IB_ptr + curSubobj.triOffset, curSubobjDataBase.tris, curSubobjDataBase.tricount * sizeof *curSubobjDataBase.tris);
+}
+
+inline void Impl::Object3D::StartBundleCreation(ObjectName &&name)
+{
+	bundle = async(CreateBundle, subobjects, subobjCount, ComPtr<ID3D12Resource>(GPUBuffer), layout, move(name));
+}
 
-		GPUBuffer->Unmap(0, NULL);
+void Impl::Object3D::ConstructBulk(Object3D *const targets[], const BulkDesc descs[], unsigned int count, const WorkerPool &workerPool)
+{
+	vector<ObjectName> names(count);
+	vector<vector<unsigned long int>> CB_offsets(count);
+	vector<MappedGPUBuffer> mapped(count);
+
+	// size pass and GPU buffers creation for all objects before any fill
+	ParallelFor(count, [&](unsigned int i)
+	{
+		names[i] = ConvertName(string(descs[i].name));
+		CB_offsets[i] = targets[i]->Parse(descs[i].subobjCount, descs[i].getSubobjectData, names[i]);
+		mapped[i] = targets[i]->CreateGPUBuffer(names[i]);
+	}, workerPool);
+
+	// fill flattened subobjects of all objects
+	vector<unsigned int> subobjectsPrefix(count + 1);
+	transform_inclusive_scan(descs, descs + count, subobjectsPrefix.begin() + 1, plus(), [](const BulkDesc &desc) noexcept { return unsigned(desc.subobjCount); });
+	ParallelFor(subobjectsPrefix.back(), [&](unsigned int taskIdx)
+	{
+		const auto objIdx = prev(upper_bound(subobjectsPrefix.cbegin(), subobjectsPrefix.cend(), taskIdx)) - subobjectsPrefix.cbegin();
+		const unsigned short subobjIdx = taskIdx - subobjectsPrefix[objIdx];
+		targets[objIdx]->FillSubobject(descs[objIdx].getSubobjectData, subobjIdx, mapped[objIdx].get(), CB_offsets[objIdx][subobjIdx]);
+	}, workerPool);
+
+	for (unsigned int i = 0; i < count; i++)
+	{
+		mapped[i].reset();
+		targets[i]->StartBundleCreation(move(names[i]));
 	}
+}
 
-	// start bundle creation
-#ifdef _MSC_VER
-	bundle = async(CreateBundle, subobjects, subobjCount, ComPtr<ID3D12Resource>(GPUBuffer), CB_size, VB_size, UVB_size, TGB_size, IB_size, move(convertedName));
-#else
-	bundle = async(CreateBundle, subobjects, subobjCount, ComPtr<ID3D12Resource>(GPUBuffer), CB_size, VB_size, UVB_size, TGB_size, IB_size, move(name));
-#endif
+vector<Renderer::Object3D> Renderer::Object3D::CreateBulk(span<const BulkDesc> descs, const WorkerPool &workerPool)
+{
+	vector<Object3D> objects(descs.size());
+	vector<Impl::Object3D *> targets(descs.size());
+	transform(objects.begin(), objects.end(), targets.begin(), [](Object3D &object) noexcept -> Impl::Object3D * { return &object; });
+	ConstructBulk(targets.data(), descs.data(), descs.size(), workerPool);
+	return objects;
 }
 
 Impl::Object3D::Object3D() = default;
@@ -849,20 +959,11 @@ Impl::Object3D::~Object3D() = default;
 
 AABB<3> Impl::Object3D::GetXformedAABB(const float4x3 &xform) const
 {
-	AABB<3> result;
-
 	/*
 		transform every individual suboject AABB and then refit
 		it somewhat slower than refitting in object space and transforming once for entire object but may provide tighter AABB
 	*/
-	for (unsigned i = 0; i < subobjCount; i++)
-	{
-		AABB<3> subobjAABB = subobjects[i].aabb;
-		subobjAABB.Transform(xform);
-		result.Refit(subobjAABB);
-	}
-
-	return result;
+	return TransformRefitAABBs(&subobjects[0].aabb, subobjCount, xform, sizeof subobjects[0]);
 }
 
 void Impl::Object3D::Setup(ID3D12GraphicsCommandList4 *cmdList, UINT64 frameDataGPUPtr, UINT64 tonemapParamsGPUPtr)
@@ -889,13 +990,93 @@ const void Impl::Object3D::Render(ID3D12GraphicsCommandList4 *cmdList) const
 	cmdList->ExecuteBundle(bundle.get().second.Get());
 }
 
+void Impl::Object3D::Render(ID3D12GraphicsCommandList4 *cmdList, unsigned int instanceCount) const
+{
+	if (descriptorTablePack)
+		descriptorTablePack->Set(cmdList);
+
+	// PSO left by previous draws is unknown here => force setting it for 1st subobject
+	Context ctx = { NULL, GPUBuffer->GetGPUVirtualAddress() };
+	cmdList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	RecordDraws(cmdList, subobjects.get(), subobjCount, layout, ctx, [instanceCount](ID3D12GraphicsCommandList4 *target, const Subobject &subobj, unsigned)
+	{
+		target->DrawIndexedInstanced(subobj.tricount * 3, instanceCount, subobj.triOffset * 3, subobj.vOffset, 0);
+	});
+}
+
+D3D12_DRAW_INDEXED_ARGUMENTS Impl::Object3D::GetDrawArgs(unsigned short int subobjIdx) const
+{
+	const auto &subobj = subobjects[subobjIdx];
+	return { subobj.tricount * 3U, 1, subobj.triOffset * 3, INT(subobj.vOffset), 0 };
+}
+
+void Impl::Object3D::RenderIndirect(ID3D12GraphicsCommandList4 *cmdList, unsigned int maxInstanceCount, ID3D12Resource *args, UINT64 argsOffset, ID3D12Resource *counters, UINT64 countersOffset) const
+{
+	if (descriptorTablePack)
+		descriptorTablePack->Set(cmdList);
+
+	Context ctx = { NULL, GPUBuffer->GetGPUVirtualAddress() };
+	cmdList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	RecordDraws(cmdList, subobjects.get(), subobjCount, layout, ctx, [=](ID3D12GraphicsCommandList4 *target, const Subobject &, unsigned subobjIdx)
+	{
+		target->ExecuteIndirect(indirectCmdSignature.Get(), maxInstanceCount,
+			args, argsOffset + UINT64(subobjIdx) * maxInstanceCount * GPUCulling::indirectCmdSize,
+			counters, countersOffset + subobjIdx * sizeof(UINT));
+	});
+}
+
+// shared by bundle, direct instanced and indirect rendering
+template<typename Draw>
+void Impl::Object3D::RecordDraws(ID3D12GraphicsCommandList4 *cmdList, const Subobject *subobjects, unsigned short int subobjCount, const GeometryLayout &layout, Context &ctx, const Draw &draw)
+{
+	// setup VB/IB (material CBs placed at GPUBuffer start)
+	{
+		const array<D3D12_VERTEX_BUFFER_VIEW, 4> VB_views =
+		{
+			{
+				{
+					ctx.material_CB_ptr + layout.CB_size,
+					layout.VB_size, sizeof *SubobjectDataBase::verts
+				},
+				{
+					VB_views[0].BufferLocation + VB_views[0].SizeInBytes,
+					layout.VB_size, sizeof *SubobjectDataBase::normals
+				},
+				{
+					VB_views[1].BufferLocation + VB_views[1].SizeInBytes,
+					layout.UVB_size, sizeof *SubobjectDataUV::uv
+				},
+				{
+					VB_views[2].BufferLocation + VB_views[2].SizeInBytes,
+					layout.TGB_size, sizeof *SubobjectData<SubobjectType::Advanced>::tangents
+				}
+			}
+		};
+		const D3D12_INDEX_BUFFER_VIEW IB_view =
+		{
+			VB_views.back().BufferLocation + VB_views.back().SizeInBytes,
+			layout.IB_size,
+			DXGI_FORMAT_R16_UINT
+		};
+		assert(layout.UVB_size || !layout.TGB_size);
+		cmdList->IASetVertexBuffers(0, 2 + bool(layout.UVB_size) + bool(layout.TGB_size)/*set UVB/TGB only if necessary*/, VB_views.data());
+		cmdList->IASetIndexBuffer(&IB_view);
+	}
+
+	for (unsigned i = 0; i < subobjCount; i++)
+	{
+		const auto &curSubobj = subobjects[i];
+
+		curSubobj.Setup(cmdList, ctx);
+		draw(cmdList, curSubobj, i);
+	}
+}
+
 // need to copy subobjects to avoid dangling reference as the function can be executed in another thread
 #ifdef _MSC_VER
-auto Impl::Object3D::CreateBundle(const decltype(subobjects) &subobjects, unsigned short int subobjCount, ComPtr<ID3D12Resource> GPUBuffer,
-	unsigned long int CB_size, unsigned long int VB_size, unsigned long int UVB_size, unsigned long int TGB_size, unsigned long int IB_size, wstring &&objectName) -> decay_t<decltype(bundle.get())>
+auto Impl::Object3D::CreateBundle(const decltype(subobjects) &subobjects, unsigned short int subobjCount, ComPtr<ID3D12Resource> GPUBuffer, GeometryLayout layout, wstring &&objectName) -> decay_t<decltype(bundle.get())>
 #else
-auto Impl::Object3D::CreateBundle(const decltype(subobjects) &subobjects, unsigned short int subobjCount, ComPtr<ID3D12Resource> GPUBuffer,
-	unsigned long int CB_size, unsigned long int VB_size, unsigned long int UVB_size, unsigned long int TGB_size, unsigned long int IB_size, string &&objectName) -> decay_t<decltype(bundle.get())>
+auto Impl::Object3D::CreateBundle(const decltype(subobjects) &subobjects, unsigned short int subobjCount, ComPtr<ID3D12Resource> GPUBuffer, GeometryLayout layout, string &&objectName) -> decay_t<decltype(bundle.get())>
 #endif
 {
 	decay_t<decltype(bundle.get())> bundle;	// to be returned
@@ -923,49 +1104,10 @@ auto Impl::Object3D::CreateBundle(const decltype(subobjects) &subobjects, unsign
 	{
 		bundle.second->SetGraphicsRootSignature(rootSig.Get());
 		bundle.second->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-
-		// setup VB/IB
-		{
-			const array<D3D12_VERTEX_BUFFER_VIEW, 4> VB_views =
-			{
-				{
-					{
-						ctx.material_CB_ptr + CB_size,
-						VB_size, sizeof *SubobjectDataBase::verts
-					},
-					{
-						VB_views[0].BufferLocation + VB_views[0].SizeInBytes,
-						VB_size, sizeof *SubobjectDataBase::normals
-					},
-					{
-						VB_views[1].BufferLocation + VB_views[1].SizeInBytes,
-						UVB_size, sizeof *SubobjectDataUV::uv
-					},
-					{
-						VB_views[2].BufferLocation + VB_views[2].SizeInBytes,
-						TGB_size, sizeof *SubobjectData<SubobjectType::Advanced>::tangents
-					}
-				}
-			};
-			const D3D12_INDEX_BUFFER_VIEW IB_view =
-			{
-				VB_views.back().BufferLocation + VB_views.back().SizeInBytes,
-				IB_size,
-				DXGI_FORMAT_R16_UINT
-			};
-			assert(UVB_size || !TGB_size);
-			bundle.second->IASetVertexBuffers(0, 2 + bool(UVB_size) + bool(TGB_size)/*set UVB/TGB only if necessary*/, VB_views.data());
-			bundle.second->IASetIndexBuffer(&IB_view);
-		}
-
-		for (unsigned i = 0; i < subobjCount; i++)
+		RecordDraws(bundle.second.Get(), subobjects.get(), subobjCount, layout, ctx, [](ID3D12GraphicsCommandList4 *target, const Subobject &subobj, unsigned)
 		{
-			const auto &curSubobj = subobjects[i];
-
-			curSubobj.Setup(bundle.second.Get(), ctx);
-			bundle.second->DrawIndexedInstanced(curSubobj.tricount * 3, 1, curSubobj.triOffset * 3, curSubobj.vOffset, 0);
-		}
-
+			target->DrawIndexedInstanced(subobj.tricount * 3, 1, subobj.triOffset * 3, subobj.vOffset, 0);
+		});
 		CheckHR(bundle.second->Close());
 	}
 
@@ -1,15 +1,19 @@
 #include "per-frame data.hlsli"
 #include "object3D VS 2 PS.hlsli"
 
+// merged instanced draws index xforms array, non-instanced draws bind CB with single xform
 cbuffer InstanceData : register(b1)
 {
-	row_major float4x3 worldXform;
+	row_major float4x3 instanceXforms[1024];	// max CB size
 };
 
+static float4x3 worldXform;
+
 struct SrcVertex
 {
 	float4 pos	: POSITION;
 	float3 N	: NORMAL;
+	uint instanceID	: SV_InstanceID;
 };
 
 // 2 view space
@@ -20,6 +24,7 @@ float3 XformOrthoUniform(float3 vec)
 
 XformedVertex Flat_VS(in SrcVertex input, out float4 xformedPos : SV_POSITION, out float height : SV_ClipDistance)
 {
+	worldXform = instanceXforms[input.instanceID];
 	const float3 worldPos = mul(float4(mul(input.pos, worldXform), 1.f), terrainWorldXform);
 	height = worldPos.z;	// do not render anything under terrain
 	const float3 viewPos = mul(float4(worldPos, 1.f), viewXform);
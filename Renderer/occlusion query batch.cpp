@@ -2,7 +2,9 @@
 #include "occlusion query batch.h"
 #include "tracked resource.inl"
 #include "cmdlist pool.inl"
+#include "frame versioning.h"
 #include "align.h"
+#include "memory accounting.h"
 #ifdef _MSC_VER
 #include <codecvt>
 #include <locale>
@@ -22,61 +24,113 @@ static void AtomicMax(atomic<T> &dst, T src)
 	for (auto stored = dst.load(memory_order_relaxed); stored < src && !dst.compare_exchange_weak(stored, src, memory_order_relaxed););
 }
 
-#pragma region QueryBatchBase
-unsigned long QueryBatchBase::heapPoolSize;
-
-void QueryBatchBase::Setup(unsigned long count)
+#pragma region SharedPool
+template<class Resource>
+template<unsigned long granularity, typename Create>
+Resource *SharedPool<Resource>::Acquire(unsigned long demand, const Create &create)
 {
-	try
+	const UINT64 curFrameID = globalFrameVersioning->GetCurFrameID();
+	shared_lock sharedLock(mtx);
+
+	// frame start and growth handled exclusively, recheck after relock as other thread can shrink pool on its frame start meanwhile
+	while (frameID < curFrameID || demand > size)
 	{
-		if (this->count = count)
+		sharedLock.unlock();
 		{
-			/*
-			try to reduce pool realloc count by accounting for other render stages requests
-			reset every frame is not necessary since currently there is no pool shrinking mechanism, it grows monotonically
-			*/
-			static atomic<unsigned long> globalCountRequest;
-			AtomicMax(globalCountRequest, count);
-
-			static shared_mutex mtx;
-			shared_lock<decltype(mtx)> sharedLock(mtx);
-
-			/*
-			check local request here
-			do not consider global one - use it if actual reallocation is required
-			it would reduce unnecessary pool reallocs
-			*/
-			if (count > heapPoolSize)
+			lock_guard exclusiveLock(mtx);
+			if (frameID < curFrameID)
+				OnFrameStart<granularity>(curFrameID, create);
+			// other thread can have chance to replenish the pool, check again
+			if (demand > size)
 			{
-				sharedLock.unlock();
-				{
-					lock_guard exclusiveLock(mtx);
-					// other thread can have chance to replenish the pool, check again
-					if (count > heapPoolSize)
-					{
-						static_assert(D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT % sizeof(UINT64) == 0);
-						// use global request for actual reallocation
-						const auto newHeapPoolSize = AlignSize<D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT / sizeof(UINT64)>(globalCountRequest.load(memory_order_relaxed));
-
-						static unsigned long version;
-
-						const D3D12_QUERY_HEAP_DESC heapDesk = { D3D12_QUERY_HEAP_TYPE_OCCLUSION, newHeapPoolSize, 0 };
-						CheckHR(device->CreateQueryHeap(&heapDesk, IID_PPV_ARGS(heapPool.ReleaseAndGetAddressOf())));
-						heapPoolSize = newHeapPoolSize;	// after creation for sake of exception safety
-						NameObjectF(heapPool.Get(), L"occlusion query heap [%lu]", version);
-					}
-				}
-				sharedLock.lock();
+				// account for other render stages requests in order to reduce reallocs
+				const auto newSize = AlignSize<granularity>(max(demand, frameDemand.load(memory_order_relaxed)));
+				pool = create(newSize);
+				size = newSize;	// after creation for sake of exception safety
+				growCount++;
 			}
+		}
+		sharedLock.lock();
+	}
 
-			// tracked->untracked copy here is safe since it holds for single frame only\
-			untracked used to eliminate unnecessary overhead of retirement every frame
-			batchHeap = heapPool.Get();
+	AtomicMax(frameDemand, demand);
+	return pool.Get();
+}
+
+template<class Resource>
+template<unsigned long granularity, typename Create>
+void SharedPool<Resource>::OnFrameStart(UINT64 curFrameID, const Create &create)
+{
+	frameID = curFrameID;
+	lastFrameDemand = frameDemand.exchange(0, memory_order_relaxed);
 
-			// setup derived
-			FinalSetup();
+	if (size && lastFrameDemand * shrinkRatio <= size)
+	{
+		lowDemandPeak = max(lowDemandPeak, lastFrameDemand);
+		if (++lowDemandFrames >= shrinkLatency)
+		{
+			if (lowDemandPeak)
+			{
+				const auto newSize = AlignSize<granularity>(lowDemandPeak);
+				pool = create(newSize);
+				size = newSize;
+			}
+			else
+			{
+				pool = nullptr;
+				size = 0;
+			}
+			shrinkCount++;
+			lowDemandFrames = 0;
+			lowDemandPeak = 0;
 		}
 	}
+	else
+	{
+		lowDemandFrames = 0;
+		lowDemandPeak = 0;
+	}
+}
+
+template<class Resource>
+SharedPoolStats SharedPool<Resource>::GetStats() const
+{
+	shared_lock sharedLock(mtx);
+	return { size, frameDemand.load(memory_order_relaxed), lastFrameDemand, lowDemandPeak, lowDemandFrames, growCount, shrinkCount };
+}
+#pragma endregion
+
+#pragma region QueryBatchBase
+SharedPoolStats QueryBatchBase::GetHeapPoolStats()
+{
+	return heapPool.GetStats();
+}
+
+void QueryBatchBase::Setup(unsigned long count)
+{
+	try
+	{
+		/*
+			pool acquired even for empty batch in order to register frame demand, this enables shrinking after sustained low demand
+			tracked->untracked copy here is safe since it holds for single frame only
+			untracked used to eliminate unnecessary overhead of retirement every frame
+		*/
+		static_assert(D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT % sizeof(UINT64) == 0);
+		batchHeap = heapPool.Acquire<D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT / sizeof(UINT64)>(this->count = count, [](unsigned long size)
+		{
+			static unsigned long version;
+
+			ComPtr<ID3D12QueryHeap> heap;
+			const D3D12_QUERY_HEAP_DESC heapDesk = { D3D12_QUERY_HEAP_TYPE_OCCLUSION, size, 0 };
+			CheckHR(device->CreateQueryHeap(&heapDesk, IID_PPV_ARGS(heap.GetAddressOf())));
+			NameObjectF(heap.Get(), L"occlusion query heap [%lu]", version++);
+			MemoryAccounting::Track(heap.Get(), heapDesk, MemoryAccounting::Category::OcclusionQueries);
+			return heap;
+		});
+
+		// setup derived
+		FinalSetup();
+	}
 	catch (...)
 	{
 		// basic exception safety guarantee
@@ -105,43 +159,30 @@ void QueryBatchBase::Set(ID3D12GraphicsCommandList4 *cmdList, unsigned long quer
 #pragma endregion
 
 #pragma region TRANSIENT
+SharedPoolStats QueryBatch<TRANSIENT>::GetResultsPoolStats()
+{
+	return resultsPool.GetStats();
+}
+
 void QueryBatch<TRANSIENT>::FinalSetup()
 {
 	// same approach for pool allocation as for query heap in QueryBatchBase
-	const unsigned long requiredSize = count * sizeof(UINT64);
-	static atomic<unsigned long> globalSizeRequest;
-	AtomicMax(globalSizeRequest, requiredSize);
-
-	static shared_mutex mtx;
-	shared_lock<decltype(mtx)> sharedLock(mtx);
-
-	if (!resultsPool || requiredSize > resultsPool->GetDesc().Width)
+	batchResults = resultsPool.Acquire<D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT>(count * sizeof(UINT64), [](unsigned long size)
 	{
-		sharedLock.unlock();
-		{
-			lock_guard exclusiveLock(mtx);
-			// other thread can have chance to replenish the pool, check again
-			if (!resultsPool || requiredSize > resultsPool->GetDesc().Width)
-			{
-				// use global request for actual reallocation
-				const auto newResultsSize = AlignSize<D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT>(globalSizeRequest.load(memory_order_relaxed));
-
-				static unsigned long version;
-
-				CheckHR(device->CreateCommittedResource(
-					&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
-					D3D12_HEAP_FLAG_NONE,
-					&CD3DX12_RESOURCE_DESC::Buffer(newResultsSize),
-					D3D12_RESOURCE_STATE_COPY_DEST,
-					NULL,	// clear value
-					IID_PPV_ARGS(resultsPool.ReleaseAndGetAddressOf())));
-				NameObjectF(resultsPool.Get(), L"occlusion query results [%lu]", version++);
-			}
-		}
-		sharedLock.lock();
-	}
+		static unsigned long version;
 
-	batchResults = resultsPool.Get();
+		ComPtr<ID3D12Resource> results;
+		CheckHR(device->CreateCommittedResource(
+			&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
+			D3D12_HEAP_FLAG_NONE,
+			&CD3DX12_RESOURCE_DESC::Buffer(size),
+			D3D12_RESOURCE_STATE_COPY_DEST,
+			NULL,	// clear value
+			IID_PPV_ARGS(results.GetAddressOf())));
+		NameObjectF(results.Get(), L"occlusion query results [%lu]", version++);
+		MemoryAccounting::Track(results.Get(), MemoryAccounting::Category::OcclusionQueries);
+		return results;
+	});
 }
 
 // not thread-safe, must be called sequentially in render stage order
@@ -153,9 +194,10 @@ void QueryBatch<TRANSIENT>::Sync() const
 		static const GUID reusedBatchGUID = 
 		{ 0x89d5f2e9, 0x3173, 0x4883, { 0x8c, 0x86, 0x2a, 0xc2, 0xc6, 0x2a, 0x8, 0xc5 } };
 
+		// results pool can be reallocated independently of query heap (e.g. shrunk at different frame) => track freshness on it as it is what initial state matters for
 		UINT size = 0;
-		if (const HRESULT hr = batchHeap->GetPrivateData(reusedBatchGUID, &size, NULL); fresh = hr == DXGI_ERROR_NOT_FOUND)
-			CheckHR(batchHeap->SetPrivateData(reusedBatchGUID, 0, batchHeap));	// pass some non-NULL ptr to register reusedBatchGUID
+		if (const HRESULT hr = batchResults->GetPrivateData(reusedBatchGUID, &size, NULL); fresh = hr == DXGI_ERROR_NOT_FOUND)
+			CheckHR(batchResults->SetPrivateData(reusedBatchGUID, 0, batchResults));	// pass some non-NULL ptr to register reusedBatchGUID
 		else
 			CheckHR(hr);
 	}
@@ -189,7 +231,7 @@ QueryBatch<PERSISTENT>::~QueryBatch() = default;
 
 void QueryBatch<PERSISTENT>::FinalSetup()
 {
-	if (const unsigned long requiredSize = count * sizeof(UINT64); !batchResults || batchResults->GetDesc().Width < requiredSize)
+	if (const unsigned long requiredSize = count * sizeof(UINT64); count && (!batchResults || batchResults->GetDesc().Width < requiredSize))
 	{
 		CheckHR(device->CreateCommittedResource(
 			&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
@@ -198,6 +240,7 @@ void QueryBatch<PERSISTENT>::FinalSetup()
 			D3D12_RESOURCE_STATE_COPY_DEST,
 			NULL,	// clear value
 			IID_PPV_ARGS(batchResults.ReleaseAndGetAddressOf())));
+		MemoryAccounting::Track(batchResults.Get(), MemoryAccounting::Category::OcclusionQueries);
 #ifdef _MSC_VER
 		wstring_convert<codecvt_utf8<WCHAR>> converter;
 		NameObjectF(batchResults.Get(), L"occlusion query results for %ls [%lu] (query batch %p)", converter.from_bytes(name).c_str(), version++, this);
@@ -235,7 +278,7 @@ QueryBatch<DUAL>::~QueryBatch() = default;
 
 void QueryBatch<DUAL>::FinalSetup()
 {
-	if (const unsigned long moietySize = count * sizeof(UINT64), requiredSize = AlignSize(moietySize, alignment) + moietySize; !batchResults || batchResults->GetDesc().Width < requiredSize)
+	if (const unsigned long moietySize = count * sizeof(UINT64), requiredSize = AlignSize(moietySize, alignment) + moietySize; count && (!batchResults || batchResults->GetDesc().Width < requiredSize))
 	{
 		CheckHR(device->CreateCommittedResource(
 			&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
@@ -245,6 +288,7 @@ void QueryBatch<DUAL>::FinalSetup()
 			NULL,	// clear value
 			IID_PPV_ARGS(batchResults.ReleaseAndGetAddressOf())));
 		NameObjectF(batchResults.Get(), L"occlusion query results for %ls [%lu] (query batch %p)", name, version++, this);
+		MemoryAccounting::Track(batchResults.Get(), MemoryAccounting::Category::OcclusionQueries);
 	}
 }
 
@@ -2,6 +2,8 @@
 
 #include <climits>
 #include <string>
+#include <atomic>
+#include <shared_mutex>
 #include "tracked resource.h"
 
 struct ID3D12QueryHeap;
@@ -22,10 +24,44 @@ namespace Renderer::Impl::OcclusionCulling
 		DUAL,
 	};
 
+	struct SharedPoolStats
+	{
+		unsigned long size, curFrameDemand, lastFrameDemand, lowDemandPeak;
+		unsigned int lowDemandFrames, growCount, shrinkCount;
+	};
+
+	/*
+		pool shared by batches, GPU executes render stages sequentially => each batch reuses it from the start, size = max batch demand
+		grows right away on demand, shrinks to low demand peak after demand stays below 1/'shrinkRatio' of size for 'shrinkLatency' frames
+		replaced pool gets retired by tracked resource => recycled after GPU finishes frames which reference it
+	*/
+	template<class Resource>
+	class SharedPool
+	{
+		static constexpr unsigned int shrinkLatency = 120, shrinkRatio = 4;
+
+	private:
+		Impl::TrackedResource<Resource> pool;
+		UINT64 frameID = 0;
+		unsigned long size = 0, lastFrameDemand = 0, lowDemandPeak = 0;
+		unsigned int lowDemandFrames = 0, growCount = 0, shrinkCount = 0;
+		std::atomic<unsigned long> frameDemand = 0;
+		mutable std::shared_mutex mtx;
+
+	public:
+		// 'Create(size)' returns ComPtr to new pool, 'granularity' should be power of 2
+		template<unsigned long granularity, typename Create>
+		Resource *Acquire(unsigned long demand, const Create &create);
+		SharedPoolStats GetStats() const;
+
+	private:
+		template<unsigned long granularity, typename Create>
+		void OnFrameStart(UINT64 curFrameID, const Create &create);
+	};
+
 	class QueryBatchBase
 	{
-		static Impl::TrackedResource<ID3D12QueryHeap> heapPool;
-		static unsigned long heapPoolSize;
+		static SharedPool<ID3D12QueryHeap> heapPool;
 
 	public:
 		static constexpr unsigned long npos = ULONG_MAX;
@@ -45,6 +81,7 @@ namespace Renderer::Impl::OcclusionCulling
 
 	public:
 		void Setup(unsigned long count);
+		static SharedPoolStats GetHeapPoolStats();
 
 	protected:
 		void Set(ID3D12GraphicsCommandList4 *target, unsigned long queryIdx, ID3D12Resource *batchResults, bool visible, unsigned long offset = 0ul) const;
@@ -59,7 +96,7 @@ namespace Renderer::Impl::OcclusionCulling
 	template<>
 	class QueryBatch<TRANSIENT> final : public QueryBatchBase
 	{
-		static Impl::TrackedResource<ID3D12Resource> resultsPool;
+		static SharedPool<ID3D12Resource> resultsPool;
 
 	private:
 		ID3D12Resource *batchResults;
@@ -69,6 +106,7 @@ namespace Renderer::Impl::OcclusionCulling
 		void FinalSetup() override;
 
 	public:
+		static SharedPoolStats GetResultsPoolStats();
 		void Sync() const;
 		void Set(ID3D12GraphicsCommandList4 *target, unsigned long queryIdx, bool visible = true) const { QueryBatchBase::Set(target, queryIdx, batchResults, visible); }
 		void Resolve(CmdListPool::CmdList &target, bool reuse = false) const, Finish(CmdListPool::CmdList &target) const;
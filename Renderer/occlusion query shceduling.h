@@ -30,4 +30,17 @@ namespace Renderer::Impl::OcclusionCulling
 	{
 		return !EarlyOut(triCount) && QueryBenefit<false>(aabbSquare, triCount);
 	}
+
+	// 'occlusionEstimate' [0, 1] (e.g. from OcclusionTree::QueryCoverage()) - query for likely occluded node pays off more often, .5 is neutral
+	template<bool checkEarlyOut>
+	inline bool QueryBenefit(float aabbSquare, unsigned long int triCount, float occlusionEstimate)
+	{
+		// need research
+		constexpr float threshold = minTriCount / .2f;
+
+		if constexpr (checkEarlyOut)
+			if (EarlyOut(triCount))
+				return false;
+		return triCount * (.5f + occlusionEstimate) / sqrt(aabbSquare) >= threshold;
+	}
 }
\ No newline at end of file
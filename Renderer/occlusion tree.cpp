@@ -4,82 +4,198 @@
 using namespace std;
 using namespace Renderer;
 
+extern pmr::synchronized_pool_resource globalTransientRAM;
+
 // occlusion summation: new = old + (1 - old) * increment = old + increment - old * increment
 inline unsigned OcclusionTree::OcclusionDelta(unsigned curOcclusion, unsigned occlusionIncrement) noexcept
 {
 	return occlusionIncrement - curOcclusion * occlusionIncrement / fullOcclusion;
 }
 
-template<size_t ...idx>
-inline OcclusionTree::OcclusionTree(index_sequence<idx...>) : levels{ tiles, tiles + QuadTreeNodeCount(idx)... }
-{}
-
-OcclusionTree::OcclusionTree() : OcclusionTree(make_index_sequence<height>())
+inline auto OcclusionTree::Parent(Tile tile) noexcept -> Tile
 {
-	tiles[0].parent = nullptr;
-	unsigned long tileCount = 4;
-	for (unsigned i = 1, stride = 2; i <= height; i++, stride <<= 1, tileCount <<= 2)
-		for (unsigned long j = 0; j < tileCount; j++)
-		{
-			const auto r = j / stride, c = j % stride;
-			levels[i][j].parent = levels[i - 1] + r / 2 * (stride >> 1) + c / 2;
-		}
+	assert(tile.level);
+	const unsigned long r = tile.idx >> tile.level, c = tile.idx & ((1ul << tile.level) - 1);
+	return { tile.level - 1, r >> 1 << (tile.level - 1) | c >> 1 };
 }
 
-void OcclusionTree::Tile::Insert(unsigned short occlusion, unsigned short occlusionThreshold)
+// merges layer and occlusion from children, ({0, 0} is identity)
+inline void OcclusionTree::Propagate(unsigned short int &dstLayer, unsigned short int &dstOcclusion, unsigned short layer, unsigned short occlusion) noexcept
 {
-	occlusionThreshold = max<unsigned short>(occlusionThreshold, 1);
+	if (dstLayer < layer)
+	{
+		// update layer
+		dstLayer = layer;
+		dstOcclusion = occlusion;
+	}
+	else if (dstLayer == layer)
+		dstOcclusion += OcclusionDelta(dstOcclusion, occlusion);
+}
 
-	// select insertion layer
+// returns top layer over tile (among tile itself, its ancestors and propagated children) and its accumulated occlusion
+inline auto OcclusionTree::SelectLayer(Tile tile) const -> pair<unsigned short int, unsigned>
+{
+	const auto tileIdx = LevelOffset(tile.level) + tile.idx;
+	unsigned short insertLayer = childrenPropagatedLayer[tileIdx];
+	unsigned accumulatedOcclusion = childrenPropagatedOcclusion[tileIdx];
 
-	unsigned short insertLayer = childrenPropagatedLayer;
-	unsigned accumulatedOcclusion = childrenPropagatedOcclusion;
+	assert(tileLayer[tileIdx] <= childrenPropagatedLayer[tileIdx]);
+	__assume(tileLayer[tileIdx] <= childrenPropagatedLayer[tileIdx]);
+	if (tileLayer[tileIdx] == childrenPropagatedLayer[tileIdx])
+		accumulatedOcclusion += OcclusionDelta(accumulatedOcclusion, tileOcclusion[tileIdx]);
 
-	assert(tileLayer <= childrenPropagatedLayer);
-	__assume(tileLayer <= childrenPropagatedLayer);
-	if (tileLayer == childrenPropagatedLayer)
-		accumulatedOcclusion += OcclusionDelta(accumulatedOcclusion, tileOcclusion);
-	
 	// walk up the tree
-	for (const Tile *ancestor = parent; ancestor; ancestor = ancestor->parent)
+	for (Tile ancestor = tile; ancestor.level;)
 	{
-		if (ancestor->tileLayer > insertLayer)
+		ancestor = Parent(ancestor);
+		const auto ancestorIdx = LevelOffset(ancestor.level) + ancestor.idx;
+		if (tileLayer[ancestorIdx] > insertLayer)
 		{
-			insertLayer = ancestor->tileLayer;
-			accumulatedOcclusion = ancestor->tileOcclusion;
+			insertLayer = tileLayer[ancestorIdx];
+			accumulatedOcclusion = tileOcclusion[ancestorIdx];
 		}
-		else if (ancestor->tileLayer == insertLayer)
-			accumulatedOcclusion += OcclusionDelta(accumulatedOcclusion, ancestor->tileOcclusion);
+		else if (tileLayer[ancestorIdx] == insertLayer)
+			accumulatedOcclusion += OcclusionDelta(accumulatedOcclusion, tileOcclusion[ancestorIdx]);
 	}
 
+	return { insertLayer, accumulatedOcclusion };
+}
+
+// updates tile itself, returns insertion layer to be propagated to ancestors
+inline unsigned short int OcclusionTree::InsertTile(Tile tile, unsigned short occlusion, unsigned short occlusionThreshold)
+{
+	occlusionThreshold = max<unsigned short>(occlusionThreshold, 1);
+
+	// select insertion layer
+	auto [insertLayer, accumulatedOcclusion] = SelectLayer(tile);
 	if (accumulatedOcclusion >= occlusionThreshold)
 		insertLayer++;
 
-	if (insertLayer > childrenPropagatedLayer)
+	const auto tileIdx = LevelOffset(tile.level) + tile.idx;
+	if (insertLayer > childrenPropagatedLayer[tileIdx])
 	{
-		tileLayer = childrenPropagatedLayer = insertLayer;	// keep childrenPropagatedLayer at least as tileLayer
-		tileOcclusion = occlusion;
-		childrenPropagatedOcclusion = 0;
+		tileLayer[tileIdx] = childrenPropagatedLayer[tileIdx] = insertLayer;	// keep childrenPropagatedLayer at least as tileLayer
+		tileOcclusion[tileIdx] = occlusion;
+		childrenPropagatedOcclusion[tileIdx] = 0;
 	}
 	else
-		tileOcclusion += OcclusionDelta(tileOcclusion, occlusion);
+		tileOcclusion[tileIdx] += OcclusionDelta(tileOcclusion[tileIdx], occlusion);
+
+	return insertLayer;
+}
+
+void OcclusionTree::Insert(Tile tile, unsigned short occlusion, unsigned short occlusionThreshold)
+{
+	const auto insertLayer = InsertTile(tile, occlusion, occlusionThreshold);
 
 	// propagate layer and occlusion up the tree
-	for (Tile *ancestor = parent; ancestor; ancestor = ancestor->parent)
+	while (tile.level)
 	{
+		tile = Parent(tile);
 		occlusion /= 4;
-		if (ancestor->childrenPropagatedLayer < insertLayer)
+		const auto tileIdx = LevelOffset(tile.level) + tile.idx;
+		Propagate(childrenPropagatedLayer[tileIdx], childrenPropagatedOcclusion[tileIdx], insertLayer, occlusion);
+	}
+}
+
+/*
+	deeper tiles inserted first, insertion into tile reads ancestors' own layer/occlusion only (not affected by propagation from children)
+	and tile's own propagated children state which is complete by the time its level gets processed
+	=> propagation can be deferred and merged per parent tile, each level gets visited once regardless of AABB count
+	pending propagation kept as sparse list (sorted per level) rather than per level array => cost scales with touched tiles, not tree size
+*/
+void OcclusionTree::Insert(span<const AABB<2>> screenSpaceAABBs, unsigned short occlusionThreshold)
+{
+	struct Entry
+	{
+		unsigned long int idx;
+		unsigned short occlusion;
+	};
+	struct Propagation
+	{
+		unsigned long int idx;
+		unsigned short int layer, occlusion;
+	};
+
+	if (screenSpaceAABBs.empty())
+		return;
+
+	// project 4 AABBs at a time, counting sort by level
+	pmr::vector<Tile> tiles(screenSpaceAABBs.size(), &globalTransientRAM);
+	pmr::vector<unsigned short> occlusions(screenSpaceAABBs.size(), &globalTransientRAM);
+	size_t levelEntriesCount[height + 1]{};
+	for (size_t i = 0; i < screenSpaceAABBs.size(); i += 4)
+	{
+		AABB<2> aabbs[4];
+		Tile batchTiles[4];
+		float coverages[4];
+		const auto batchSize = min<size_t>(screenSpaceAABBs.size() - i, 4);
+		copy_n(screenSpaceAABBs.begin() + i, batchSize, aabbs);
+		fill(aabbs + batchSize, end(aabbs), aabbs[0]);
+		FindTilesForAABBProjections(aabbs, batchTiles, coverages);
+		for (size_t j = 0; j < batchSize; j++)
 		{
-			// update layer for ancestor
-			ancestor->childrenPropagatedLayer = insertLayer;
-			ancestor->childrenPropagatedOcclusion = occlusion;
+			tiles[i + j] = batchTiles[j];
+			occlusions[i + j] = static_cast<unsigned short>(coverages[j] * fullOcclusion);
+			levelEntriesCount[batchTiles[j].level]++;
 		}
-		else if (ancestor->childrenPropagatedLayer == insertLayer)
-			ancestor->childrenPropagatedOcclusion += OcclusionDelta(ancestor->childrenPropagatedOcclusion, occlusion);
+	}
+	size_t levelEntriesOffset[height + 2]{};
+	partial_sum(cbegin(levelEntriesCount), cend(levelEntriesCount), levelEntriesOffset + 1);
+	pmr::vector<Entry> entries(screenSpaceAABBs.size(), &globalTransientRAM);
+	{
+		size_t levelEntriesFill[height + 1];
+		copy_n(levelEntriesOffset, height + 1, levelEntriesFill);
+		for (size_t i = 0; i < tiles.size(); i++)
+			entries[levelEntriesFill[tiles[i].level]++] = { tiles[i].idx, occlusions[i] };
+	}
+
+	// propagation pending for current level from children of multiple inserted tiles, merged per tile when the level gets processed
+	pmr::vector<Propagation> incoming(&globalTransientRAM), outgoing(&globalTransientRAM);
+	const auto propagateUp = [&](Tile tile, unsigned short layer, unsigned short occlusion)
+	{
+		outgoing.push_back({ Parent(tile).idx, layer, static_cast<unsigned short>(occlusion / 4) });
+	};
+
+	for (unsigned int level = height + 1; level--;)
+	{
+		outgoing.clear();
+
+		// apply pending propagation to this level and pass it on, stable sort keeps merge order as it was pushed
+		stable_sort(incoming.begin(), incoming.end(), [](const Propagation &left, const Propagation &right) noexcept { return left.idx < right.idx; });
+		for (auto group = incoming.cbegin(); group != incoming.cend();)
+		{
+			const Tile tile{ level, group->idx };
+			unsigned short int layer = 0, occlusion = 0;
+			do
+				Propagate(layer, occlusion, group->layer, group->occlusion);
+			while (++group != incoming.cend() && group->idx == tile.idx);
+			const auto tileIdx = LevelOffset(level) + tile.idx;
+			Propagate(childrenPropagatedLayer[tileIdx], childrenPropagatedOcclusion[tileIdx], layer, occlusion);
+			if (level)
+				propagateUp(tile, layer, occlusion);
+		}
+
+		// insert
+		for (auto entry = entries.cbegin() + levelEntriesOffset[level]; entry != entries.cbegin() + levelEntriesOffset[level + 1]; ++entry)
+		{
+			const Tile tile{ level, entry->idx };
+			const auto insertLayer = InsertTile(tile, entry->occlusion, occlusionThreshold);
+			if (level)
+				propagateUp(tile, insertLayer, entry->occlusion);
+		}
+
+		swap(incoming, outgoing);
 	}
 }
 
-auto OcclusionTree::FindTileForAABBProjection(const AABB<2> &aabb) const -> pair<Tile *, float>
+auto OcclusionTree::QueryCoverage(const AABB<2> &screenRect) const -> Coverage
+{
+	const auto [layer, occlusion] = SelectLayer(FindTileForAABBProjection(screenRect).first);
+	return { layer, fmin(float(occlusion) / fullOcclusion, 1.f) };
+}
+
+auto OcclusionTree::FindTileForAABBProjection(const AABB<2> &aabb) const -> pair<Tile, float>
 {
 	using namespace placeholders;
 
@@ -113,5 +229,45 @@ auto OcclusionTree::FindTileForAABBProjection(const AABB<2> &aabb) const -> pair
 	const float tileSquare = 4.f / (stride * stride);	// sqr(2.f / stride)
 	const float tileCoverage = fmin(size.x * size.y / tileSquare, 1.f);	// AABB normally not larger than tile but huge AABBs which falls into 0 tree level can overlap more than the whole screen => clamp to 1.f
 
-	return { levels[depth] + static_cast<unsigned long>(tilePos.y * stride + tilePos.x), tileCoverage };
+	return { { depth, static_cast<unsigned long>(tilePos.y * stride + tilePos.x) }, tileCoverage };
+}
+
+/*
+	SSE version of 'FindTileForAABBProjection()' for 4 AABBs
+	log2 truncation replaced with exponent extraction, 2^depth constructed directly in exponent bits, nextafter toward 0 for positive float is integer decrement
+*/
+void OcclusionTree::FindTilesForAABBProjections(const AABB<2> (&aabbs)[4], Tile (&tiles)[4], float (&coverages)[4])
+{
+	const __m128 minX = _mm_setr_ps(aabbs[0].min.x, aabbs[1].min.x, aabbs[2].min.x, aabbs[3].min.x);
+	const __m128 minY = _mm_setr_ps(aabbs[0].min.y, aabbs[1].min.y, aabbs[2].min.y, aabbs[3].min.y);
+	const __m128 maxX = _mm_setr_ps(aabbs[0].max.x, aabbs[1].max.x, aabbs[2].max.x, aabbs[3].max.x);
+	const __m128 maxY = _mm_setr_ps(aabbs[0].max.y, aabbs[1].max.y, aabbs[2].max.y, aabbs[3].max.y);
+	const __m128 sizeX = _mm_sub_ps(maxX, minX), sizeY = _mm_sub_ps(maxY, minY);
+
+	// deduce tree level from AABB size: depth = clamp(floor(log2(2 / max size)), 0, height)
+	const __m128 ratio = _mm_div_ps(_mm_set1_ps(2.f), _mm_max_ps(sizeX, sizeY));
+	__m128i depth = _mm_sub_epi32(_mm_srli_epi32(_mm_castps_si128(ratio), 23), _mm_set1_epi32(127));
+	depth = _mm_min_epi32(_mm_max_epi32(depth, _mm_setzero_si128()), _mm_set1_epi32(height));
+	const __m128i strideBits = _mm_slli_epi32(_mm_add_epi32(depth, _mm_set1_epi32(127)), 23);
+	const __m128 stride = _mm_castsi128_ps(strideBits), strideLimit = _mm_castsi128_ps(_mm_sub_epi32(strideBits, _mm_set1_epi32(1)));
+
+	// [-1, +1] -> [0, stride], clamp
+	const __m128 halfStride = _mm_mul_ps(stride, _mm_set1_ps(.5f));
+	const auto tileCoord = [&](__m128 min, __m128 max)
+	{
+		const __m128 center = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(_mm_add_ps(min, max), _mm_set1_ps(.5f)), _mm_set1_ps(1.f)), halfStride);
+		return _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(center, _mm_setzero_ps()), strideLimit));
+	};
+	const __m128i tileX = tileCoord(minX, maxX), tileY = tileCoord(minY, maxY);
+	const __m128i idx = _mm_add_epi32(_mm_mullo_epi32(tileY, _mm_cvttps_epi32(stride)), tileX);
+
+	// tile coverage, clamped to 1 for huge AABBs which falls into 0 tree level
+	const __m128 coverage = _mm_min_ps(_mm_mul_ps(_mm_mul_ps(sizeX, sizeY), _mm_mul_ps(_mm_mul_ps(stride, stride), _mm_set1_ps(.25f))), _mm_set1_ps(1.f));
+
+	alignas(16) int depths[4], idxs[4];
+	_mm_store_si128(reinterpret_cast<__m128i *>(depths), depth);
+	_mm_store_si128(reinterpret_cast<__m128i *>(idxs), idx);
+	_mm_storeu_ps(coverages, coverage);
+	for (unsigned i = 0; i < 4; i++)
+		tiles[i] = { static_cast<unsigned>(depths[i]), static_cast<unsigned long>(idxs[i]) };
 }
\ No newline at end of file
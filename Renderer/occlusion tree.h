@@ -1,6 +1,7 @@
 #pragma once
 
 #include "stdafx.h"
+#include <span>
 #include "AABB.h"
 
 namespace Renderer
@@ -15,36 +16,38 @@ namespace Renderer
 		return result;
 	}
 
-	// screen space loose quadtree for layer distribution for occlusion query scheduling
+	/*
+		screen space loose quadtree for layer distribution for occlusion query scheduling
+		tiles stored flat level-major as SoA, ancestors found arithmetically (no parent pointers)
+		batched insertion projects AABBs 4 at a time with SSE and coalesces ancestors propagation level by level
+	*/
 	class OcclusionTree
 	{
 		static constexpr unsigned int height = 8;
+		static constexpr unsigned long int tileCount = QuadTreeNodeCount(height);
 		static inline unsigned OcclusionDelta(unsigned curOcclusion, unsigned occlusionIncrement) noexcept;
 
 	public:
 		static constexpr unsigned fullOcclusion = UINT_MAX >= 0xffffffff ? 01'00000 : 02'00;	// power of 2 for fast divisions
-		class Tile
-		{
-			friend class OcclusionTree;
 
-		private:
-			Tile *parent;
-			unsigned short int tileLayer = 0, childrenPropagatedLayer = 0;			// keep childrenPropagatedLayer >= tileLayer
-			unsigned short int tileOcclusion = 0, childrenPropagatedOcclusion = 0;	// for current layer only, need to reset when layer is updated
+		struct Tile
+		{
+			unsigned int level;
+			unsigned long int idx;	// within level, row-major
+		};
 
-		public:
-			void Insert(unsigned short occlusion, unsigned short occlusionThreshold = USHRT_MAX);
+		struct Coverage
+		{
+			unsigned short int layer;	// top layer over queried rect
+			float occlusion;			// [0, 1] for top layer only
 		};
-		
-	private:
-		Tile tiles[QuadTreeNodeCount(height)], *const levels[height + 1];
 
 	private:
-		template<size_t ...idx>
-		inline OcclusionTree(std::index_sequence<idx...>);
+		alignas(64) unsigned short int tileLayer[tileCount]{}, childrenPropagatedLayer[tileCount]{};	// keep childrenPropagatedLayer >= tileLayer
+		alignas(64) unsigned short int tileOcclusion[tileCount]{}, childrenPropagatedOcclusion[tileCount]{};	// for current layer only, need to reset when layer is updated
 
 	public:
-		OcclusionTree();
+		OcclusionTree() = default;
 		OcclusionTree(OcclusionTree &&) = default;
 		OcclusionTree &operator =(OcclusionTree &&) = default;
 
@@ -52,6 +55,19 @@ namespace Renderer
 		/*			  tile coverage											[-1, +1]
 							^													^
 							|													|	*/
-		std::pair<Tile *, float> FindTileForAABBProjection(const AABB<2> &screenSpaceAABB) const;
+		std::pair<Tile, float> FindTileForAABBProjection(const AABB<2> &screenSpaceAABB) const;
+		void Insert(Tile tile, unsigned short occlusion, unsigned short occlusionThreshold = USHRT_MAX);
+		// inserts fully opaque AABBs (occlusion = tile coverage), deeper tiles get inserted first
+		void Insert(std::span<const AABB<2>> screenSpaceAABBs, unsigned short occlusionThreshold = USHRT_MAX);
+		// estimated occlusion for screen rect by already inserted AABBs
+		Coverage QueryCoverage(const AABB<2> &screenRect) const;
+
+	private:
+		static constexpr unsigned long int LevelOffset(unsigned int level) noexcept { return level ? QuadTreeNodeCount(level - 1) : 0; }
+		static inline Tile Parent(Tile tile) noexcept;
+		static void FindTilesForAABBProjections(const AABB<2> (&aabbs)[4], Tile (&tiles)[4], float (&coverages)[4]);
+		static inline void Propagate(unsigned short int &dstLayer, unsigned short int &dstOcclusion, unsigned short layer, unsigned short occlusion) noexcept;
+		inline std::pair<unsigned short int, unsigned> SelectLayer(Tile tile) const;
+		inline unsigned short int InsertTile(Tile tile, unsigned short occlusion, unsigned short occlusionThreshold);
 	};
 }
\ No newline at end of file
@@ -4,8 +4,8 @@
 #include "tracked resource.inl"
 #include "tracked ref.inl"
 #include "frame versioning.h"
-#include "cmdlist pool.h"
 #include "GPU descriptor heap.h"
+#include "memory accounting.h"
 #include "config.h"
 #include "tonemapping config.h"
 
@@ -37,6 +37,7 @@ ComPtr<ID3D12Resource> RenderOutput::CreateTonemapReductionBuffer()
 		IID_PPV_ARGS(result.GetAddressOf())
 	));
 	NameObject(result.Get(), L"tonemap reduction buffer");
+	MemoryAccounting::Track(result.Get(), MemoryAccounting::Category::Misc);
 
 	return result;
 }
@@ -81,6 +82,7 @@ RenderOutput::RenderOutput(HWND wnd, bool allowModeSwitch, unsigned int bufferCo
 		};
 
 		CheckHR(device->CreateDescriptorHeap(&desc, IID_PPV_ARGS(rtvHeap.GetAddressOf())));
+		MemoryAccounting::Track(rtvHeap.Get(), MemoryAccounting::Category::Descriptors);
 	}
 
 	// create dsv descriptor heap
@@ -93,6 +95,7 @@ RenderOutput::RenderOutput(HWND wnd, bool allowModeSwitch, unsigned int bufferCo
 		};
 
 		CheckHR(device->CreateDescriptorHeap(&desc, IID_PPV_ARGS(dsvHeap.GetAddressOf())));
+		MemoryAccounting::Track(dsvHeap.Get(), MemoryAccounting::Category::Descriptors);
 	}
 
 	{
@@ -194,7 +197,6 @@ void RenderOutput::NextFrame(bool vsync)
 	CheckHR(swapChain->Present(vsync, 0));
 	globalFrameVersioning->OnFrameFinish();
 	viewport->OnFrameFinish();
-	Impl::CmdListPool::OnFrameFinish();
 	OnFrameFinish();
 }
 
@@ -218,6 +220,7 @@ void RenderOutput::CreateOffscreenSurfaces(UINT width, UINT height)
 		&CD3DX12_CLEAR_VALUE(Config::HDRFormat, backgroundColor),
 		IID_PPV_ARGS(rendertarget.GetAddressOf())
 	));
+	MemoryAccounting::Track(rendertarget.Get(), MemoryAccounting::Category::RenderTargets);
 
 	// fill RTV heap
 	device->CreateRenderTargetView(rendertarget.Get(), NULL, rtvHeap->GetCPUDescriptorHandleForHeapStart());
@@ -231,6 +234,7 @@ void RenderOutput::CreateOffscreenSurfaces(UINT width, UINT height)
 		&CD3DX12_CLEAR_VALUE(Config::ZFormat, 1.f, 0xef),
 		IID_PPV_ARGS(ZBuffer.GetAddressOf())
 	));
+	MemoryAccounting::Track(ZBuffer.Get(), MemoryAccounting::Category::RenderTargets);
 
 	// fill DSV heap
 	device->CreateDepthStencilView(ZBuffer.Get(), NULL, dsvHeap->GetCPUDescriptorHandleForHeapStart());
@@ -244,6 +248,7 @@ void RenderOutput::CreateOffscreenSurfaces(UINT width, UINT height)
 		NULL,
 		IID_PPV_ARGS(HDRSurface.GetAddressOf())
 	));
+	MemoryAccounting::Track(HDRSurface.Get(), MemoryAccounting::Category::RenderTargets);
 
 	// create LDR offscreen surface (D3D12 disallows UAV on swap chain backbuffers)
 	CheckHR(device->CreateCommittedResource(
@@ -254,6 +259,7 @@ void RenderOutput::CreateOffscreenSurfaces(UINT width, UINT height)
 		NULL,
 		IID_PPV_ARGS(LDRSurface.GetAddressOf())
 	));
+	MemoryAccounting::Track(LDRSurface.Get(), MemoryAccounting::Category::RenderTargets);
 
 	// fill tonemap views CPU heap
 	const auto tonemapReductionTexDispatchSize = Tonemapping::TextureReduction::DispatchSize({ width, height });
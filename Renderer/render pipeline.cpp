@@ -6,19 +6,56 @@ using namespace std;
 using namespace Renderer::Impl;
 using namespace RenderPipeline;
 
-static queue<future<PipelineStage>> pipeline;
+static constexpr float statsSmoothing = 1.f / 16;
+
+struct RenderPipeline::StageSlot
+{
+	future<PipelineStage> stage;
+	atomic<bool> ready;
+	chrono::steady_clock::time_point readyTime;	// published by 'ready'
+	const bool async;
+
+public:
+	StageSlot(future<PipelineStage> &&stage, bool async) noexcept : stage(move(stage)), ready(!async), async(async) {}
+};
+
+// deque keeps slot addresses stable on append/pop => builders can refer to their slots
+static deque<StageSlot> pipeline;
 static RenderStage curRenderStage;
+static LatencyStats latencyStats{};
+
+static StageSlot &Append(future<PipelineStage> &&stage, bool async)
+{
+	// new pipeline run
+	if (Empty())
+	{
+		latencyStats.peak = 0;
+		latencyStats.stageCount = 0;
+	}
+	return pipeline.emplace_back(move(stage), async);
+}
 
 // returns std::monostate on stage waiting/pipeline finish, null RenderStageItem on batch overflow
 PipelineItem RenderPipeline::GetNext(unsigned int &length)
 {
-	if (!curRenderStage)
+	for (;;)
 	{
-		if (!pipeline.empty() && pipeline.front().wait_for(0s) != future_status::timeout)
+		if (!curRenderStage)
 		{
+			if (pipeline.empty() || !pipeline.front().ready.load(memory_order_acquire))
+				return PipelineItem{};
+
+			if (const auto &slot = pipeline.front(); slot.async)
+			{
+				const float latency = chrono::duration<float, milli>(chrono::steady_clock::now() - slot.readyTime).count();
+				latencyStats.average += (latency - latencyStats.average) * statsSmoothing;
+				latencyStats.peak = max(latencyStats.peak, latency);
+				latencyStats.stageCount++;
+			}
+
 			// not const to enable move
-			auto stage = pipeline.front().get();
-			pipeline.pop();
+			auto stage = pipeline.front().stage.get();
+			pipeline.pop_front();
 
 			// if pipeline stage is cmd list
 			if (const auto cmdList = get_if<ID3D12GraphicsCommandList4 *>(&stage))
@@ -27,21 +64,39 @@ PipelineItem RenderPipeline::GetNext(unsigned int &length)
 			// else pipeline stage is render stage
 			(curRenderStage = move(get<RenderStage>(stage)))->Sync();
 		}
+
+		// not const to enable move
+		if (auto item = curRenderStage->GetNextWorkItem(length); !holds_alternative<monostate>(item))
+			return item;
+
+		// stage exhausted, proceed to next one
+		curRenderStage = nullptr;
 	}
-	return curRenderStage ? curRenderStage->GetNextWorkItem(length) : PipelineItem{};
 }
 
-void RenderPipeline::TerminateStageTraverse() noexcept
+void RenderPipeline::AppendStage(future<PipelineStage> &&stage)
 {
-	curRenderStage = nullptr;
+	Append(move(stage), false);
 }
 
-void RenderPipeline::AppendStage(future<PipelineStage> &&stage)
+auto RenderPipeline::AppendAsyncStage(future<PipelineStage> &&stage) -> StageSlot &
+{
+	return Append(move(stage), true);
+}
+
+void RenderPipeline::StageReady(StageSlot &slot) noexcept
 {
-	pipeline.push(move(stage));
+	assert(slot.async);
+	slot.readyTime = chrono::steady_clock::now();
+	slot.ready.store(true, memory_order_release);
 }
 
 bool RenderPipeline::Empty() noexcept
 {
 	return !curRenderStage && pipeline.empty();
+}
+
+auto RenderPipeline::GetLatencyStats() noexcept -> const LatencyStats &
+{
+	return latencyStats;
 }
\ No newline at end of file
@@ -11,9 +11,24 @@ namespace Renderer::Impl::RenderPipeline
 {
 	typedef std::shared_ptr<const class IRenderStage> RenderStage;
 	typedef std::variant<ID3D12GraphicsCommandList4 *, RenderStage> PipelineStage;
+	struct StageSlot;
 
-	void AppendStage(std::future<PipelineStage> &&stage);
+	struct LatencyStats
+	{
+		float average;				// ms between async stage build completion and its consumption, moving average
+		float peak;					// ms, max during last pipeline run
+		unsigned int stageCount;	// async stages consumed during last pipeline run
+	};
+
+	/*
+		stages consumed in append order while async ones may complete in any order
+		each slot carries its own ready flag so consumer never polls futures, waking consumer up is builder`s responsibility
+		appends and consumption have to be serialized by caller, 'StageReady' can be called from any thread
+	*/
+	void AppendStage(std::future<PipelineStage> &&stage);	// deferred, built by consumer when reached
+	StageSlot &AppendAsyncStage(std::future<PipelineStage> &&stage);
+	void StageReady(StageSlot &slot) noexcept;				// 'stage' future became ready, slot must not be touched afterwards
 	PipelineItem GetNext(unsigned int &length);
-	void TerminateStageTraverse() noexcept;
 	bool Empty() noexcept;
+	const LatencyStats &GetLatencyStats() noexcept;
 }
\ No newline at end of file
@@ -9,10 +9,6 @@ using namespace Renderer::Impl;
 using namespace RenderPipeline;
 using namespace RenderPasses;
 
-// static definitions
-PipelineItem (IRenderStage::*IRenderStage::phaseSelector)(unsigned int &length) const;
-unsigned long IRenderStage::curRangeBegin;
-
 static void FastForward(CmdListPool::CmdList &cmdList, const optional<PassROPBinding<StageRTBinding>> &RTBinding, const PassROPBinding<StageZBinding> &ZBinding)
 {
 	cmdList.Setup(NULL);
@@ -26,7 +22,7 @@ PipelineItem IRenderStage::IterateRenderPass(unsigned int &length, const signed
 	const function<void ()> &PassFinish, const function<RenderStageItem::Work (unsigned long rangeBegin, unsigned long rangeEnd)> &GetRenderRange) const
 {
 	using namespace placeholders;
-	return IterateRenderPass(length, passLength, PassFinish, bind(GetNext, ref(length)), bind(GetRenderRange, curRangeBegin, _1));
+	return IterateRenderPass(length, passLength, PassFinish, bind(&IRenderStage::GetNextWorkItem, this, ref(length)), bind(GetRenderRange, curRangeBegin, _1));
 }
 
 PipelineItem IRenderStage::IterateRenderPass(unsigned int &length, const signed long int passLength,
@@ -36,7 +32,7 @@ PipelineItem IRenderStage::IterateRenderPass(unsigned int &length, const signed
 	const auto PassExhausted = [&]
 	{
 		using namespace placeholders;
-		return passLength ? GetNext(length) : PipelineItem{ bind(FastForward, _1, RTBinding ? optional(*RTBinding) : nullopt, ZBinding) };
+		return passLength ? GetNextWorkItem(length) : PipelineItem{ bind(FastForward, _1, RTBinding ? optional(*RTBinding) : nullopt, ZBinding) };
 	};
 	const auto GetRenderRangeWrapper = [&](signed long curRangeEnd)
 	{
@@ -10,12 +10,15 @@ namespace Renderer::Impl::RenderPipeline
 	{
 		virtual PipelineItem (IRenderStage::*DoSync(void) const)(unsigned int &length) const = 0;
 
+	/*
+		traversal state kept per stage => different stages can be traversed concurrently (e.g. by different threads)
+		single stage still traversed by one thread at a time, stage object is logically const - mutable state is traversal only
+	*/
 	protected:
-		static PipelineItem (IRenderStage::*phaseSelector)(unsigned int &length) const;
+		mutable PipelineItem (IRenderStage::*phaseSelector)(unsigned int &length) const = nullptr;	// null when traversal finished
 
 	private:
-		// render pipeline traversed sequentially in main thread => can use 'static'
-		static unsigned long curRangeBegin;
+		mutable unsigned long curRangeBegin = 0;
 
 	protected:
 		IRenderStage() = default;
@@ -37,8 +40,13 @@ namespace Renderer::Impl::RenderPipeline
 		inline PipelineItem IterateRenderPass(unsigned int &length, const signed long int passLength,
 			const std::function<void ()> &PassFinish, const PassExhausted &PassExhausted, const GetRenderRange &GetRenderRange) const;
 
+	protected:
+		// next 'GetNextWorkItem()' reports stage exhaustion
+		void FinishTraverse() const noexcept { phaseSelector = nullptr; }
+
 	public:
-		void Sync() const { phaseSelector = DoSync(); }
-		PipelineItem GetNextWorkItem(unsigned int &length) const { return (this->*phaseSelector)(length); }
+		void Sync() const { phaseSelector = DoSync(); curRangeBegin = 0; }
+		// std::monostate once traversal finished
+		PipelineItem GetNextWorkItem(unsigned int &length) const { return phaseSelector ? (this->*phaseSelector)(length) : PipelineItem{}; }
 	};
 }
\ No newline at end of file
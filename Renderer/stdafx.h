@@ -27,17 +27,20 @@
 #include <compare>
 #include <tuple>
 #include <limits>
+#include <bit>
 #include <memory>
 #include <memory_resource>
 #include <iterator>
 #include <initializer_list>
 #include <string>
 #include <array>
+#include <span>
 #include <vector>
 #include <queue>
 #include <deque>
 #include <list>
 #include <forward_list>
+#include <unordered_map>
 #include <algorithm>
 #include <numeric>
 #include <execution>
@@ -52,6 +55,7 @@
 #include <atomic>
 #include <chrono>
 #include <iostream>
+#include <fstream>
 #include <iomanip>
 #include <filesystem>
 #include <exception>
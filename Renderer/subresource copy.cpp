@@ -0,0 +1,168 @@
+#include "stdafx.h"
+#include "subresource copy.h"
+#include <immintrin.h>
+
+using namespace std;
+using namespace Renderer::Impl;
+
+namespace
+{
+	constexpr size_t blockSize = 256 * 1024;				// bytes per row block, stays in L2 while being copied
+	constexpr size_t parallelThreshold = 2 * 1024 * 1024;	// smaller subresources copied inline, threading overhead isn`t worth it
+
+	class Counters
+	{
+		atomic<uint64_t> bytes, time;
+
+	public:
+		void Track(uint64_t size, chrono::steady_clock::duration elapsed) noexcept
+		{
+			bytes.fetch_add(size, memory_order_relaxed);
+			time.fetch_add(chrono::duration_cast<chrono::nanoseconds>(elapsed).count(), memory_order_relaxed);
+		}
+
+		SubresourceCopy::Stats Get() const noexcept
+		{
+			return { bytes.load(memory_order_relaxed), chrono::nanoseconds(time.load(memory_order_relaxed)) };
+		}
+	} copyCounters, writeCounters;
+
+	// rows of BC formats consist of 4x4 blocks
+	constexpr UINT BlockHeight(DXGI_FORMAT format) noexcept
+	{
+		return format >= DXGI_FORMAT_BC1_TYPELESS && format <= DXGI_FORMAT_BC5_SNORM || format >= DXGI_FORMAT_BC6H_TYPELESS && format <= DXGI_FORMAT_BC7_UNORM_SRGB ? 4 : 1;
+	}
+
+	// unaligned loads, aligned streaming stores, caller issues fence
+	void StreamRow(std::byte *dst, const std::byte *src, size_t size) noexcept
+	{
+		const size_t head = min<size_t>(size, -reinterpret_cast<uintptr_t>(dst) & 15u);
+		memcpy(dst, src, head);
+		dst += head, src += head, size -= head;
+
+		for (; size >= 64; dst += 64, src += 64, size -= 64)
+		{
+			const __m128i
+				a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src) + 0),
+				b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src) + 1),
+				c = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src) + 2),
+				d = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src) + 3);
+			_mm_stream_si128(reinterpret_cast<__m128i *>(dst) + 0, a);
+			_mm_stream_si128(reinterpret_cast<__m128i *>(dst) + 1, b);
+			_mm_stream_si128(reinterpret_cast<__m128i *>(dst) + 2, c);
+			_mm_stream_si128(reinterpret_cast<__m128i *>(dst) + 3, d);
+		}
+
+		for (; size >= 16; dst += 16, src += 16, size -= 16)
+			_mm_stream_si128(reinterpret_cast<__m128i *>(dst), _mm_loadu_si128(reinterpret_cast<const __m128i *>(src)));
+
+		memcpy(dst, src, size);
+	}
+
+	// exceptions are not allowed to escape parallel STL algorithms (would terminate), first one gets rethrown
+	template<typename Task>
+	void ForEachBlock(unsigned int blockCount, size_t totalSize, const Task &task)
+	{
+		if (blockCount > 1 && totalSize >= parallelThreshold)
+		{
+			exception_ptr error;
+			atomic_flag errorCaptured;
+			vector<unsigned int> blocks(blockCount);
+			iota(blocks.begin(), blocks.end(), 0u);
+			for_each(execution::par, blocks.cbegin(), blocks.cend(), [&](unsigned int blockIdx)
+			{
+				try
+				{
+					task(blockIdx);
+				}
+				catch (...)
+				{
+					if (!errorCaptured.test_and_set())
+						error = current_exception();
+				}
+			});
+
+			if (error)
+				rethrow_exception(error);
+		}
+		else
+			for (unsigned int blockIdx = 0; blockIdx < blockCount; blockIdx++)
+				task(blockIdx);
+	}
+}
+
+double SubresourceCopy::Stats::Bandwidth() const noexcept
+{
+	return time.count() ? bytes / chrono::duration<double>(time).count() : 0.;
+}
+
+// slices treated as continuation of rows so thin 3D mips still get split
+void SubresourceCopy::Copy(const D3D12_MEMCPY_DEST &dst, const D3D12_SUBRESOURCE_DATA &src, size_t rowSize, unsigned rowCount, unsigned sliceCount, bool nonTemporal)
+{
+	const auto start = chrono::steady_clock::now();
+	const unsigned int blockRows = static_cast<unsigned int>(max<size_t>(blockSize / max<size_t>(rowSize, 1), 1)), totalRows = rowCount * sliceCount;
+	const auto copyBlock = [&](unsigned int blockIdx) noexcept
+	{
+		const unsigned int firstRow = blockIdx * blockRows, lastRow = min(firstRow + blockRows, totalRows);
+		for (unsigned int row = firstRow; row < lastRow; row++)
+		{
+			const unsigned int slice = row / rowCount, y = row % rowCount;
+			const auto dstRow = static_cast<std::byte *>(dst.pData) + slice * dst.SlicePitch + y * dst.RowPitch;
+			const auto srcRow = static_cast<const std::byte *>(src.pData) + slice * src.SlicePitch + y * src.RowPitch;
+			if (nonTemporal)
+				StreamRow(dstRow, srcRow, rowSize);
+			else
+				memcpy(dstRow, srcRow, rowSize);
+		}
+
+		// streaming stores are weakly ordered, make them visible before this worker reports completion
+		if (nonTemporal)
+			_mm_sfence();
+	};
+	const size_t totalSize = rowSize * totalRows;
+	ForEachBlock((totalRows + blockRows - 1) / blockRows, totalSize, copyBlock);
+	copyCounters.Track(totalSize, chrono::steady_clock::now() - start);
+}
+
+void SubresourceCopy::Write(ID3D12Resource *dst, unsigned subresource, const D3D12_SUBRESOURCE_DATA &src)
+{
+	const auto start = chrono::steady_clock::now();
+	const auto desc = dst->GetDesc();
+	const unsigned int mip = subresource % desc.MipLevels;
+	const UINT
+		width = max<UINT>(desc.Width >> mip, 1),
+		height = max(desc.Height >> mip, 1u),
+		depth = desc.Dimension == D3D12_RESOURCE_DIMENSION_TEXTURE3D ? max(desc.DepthOrArraySize >> mip, 1) : 1,
+		blockHeight = BlockHeight(desc.Format),
+		rowCount = (height + blockHeight - 1) / blockHeight,
+		blockRows = UINT(max<size_t>(blockSize / max<LONG_PTR>(src.RowPitch, 1), 1)),
+		blocksPerSlice = (rowCount + blockRows - 1) / blockRows;
+	const size_t totalSize = size_t(src.SlicePitch) * depth;
+
+	// single block written as whole subresource - avoids box alignment restrictions for small BC mips
+	if (blocksPerSlice * depth == 1)
+		CheckHR(dst->WriteToSubresource(subresource, NULL, src.pData, src.RowPitch, src.SlicePitch));
+	else
+	{
+		const auto writeBlock = [&](unsigned int blockIdx)
+		{
+			const UINT slice = blockIdx / blocksPerSlice, firstRow = blockIdx % blocksPerSlice * blockRows, lastRow = min(firstRow + blockRows, rowCount);
+			const D3D12_BOX box{ 0, firstRow * blockHeight, slice, width, min(lastRow * blockHeight, height), slice + 1 };
+			const auto data = static_cast<const std::byte *>(src.pData) + slice * src.SlicePitch + firstRow * src.RowPitch;
+			CheckHR(dst->WriteToSubresource(subresource, &box, data, src.RowPitch, src.SlicePitch));
+		};
+		ForEachBlock(blocksPerSlice * depth, totalSize, writeBlock);
+	}
+
+	writeCounters.Track(totalSize, chrono::steady_clock::now() - start);
+}
+
+auto SubresourceCopy::GetCopyStats() noexcept -> Stats
+{
+	return copyCounters.Get();
+}
+
+auto SubresourceCopy::GetWriteStats() noexcept -> Stats
+{
+	return writeCounters.Get();
+}
\ No newline at end of file
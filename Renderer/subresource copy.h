@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <chrono>
+
+struct ID3D12Resource;
+struct D3D12_SUBRESOURCE_DATA;
+struct D3D12_MEMCPY_DEST;
+
+/*
+	CPU side subresource population split into row blocks sized to stay in cache
+	blocks of large subresources distributed across worker threads (parallel STL), small ones copied inline
+	thread-safe, stats accumulated globally
+*/
+namespace Renderer::Impl::SubresourceCopy
+{
+	struct Stats
+	{
+		uint64_t bytes;
+		std::chrono::nanoseconds time;	// wall time of copy calls, overlapping calls from different threads counted separately
+
+	public:
+		double Bandwidth() const noexcept;	// bytes/s
+	};
+
+	// replacement for d3dx12 'MemcpySubresource', 'nonTemporal' for write-combined destinations (upload heaps) - streaming stores bypass cache
+	void Copy(const D3D12_MEMCPY_DEST &dst, const D3D12_SUBRESOURCE_DATA &src, size_t rowSize, unsigned rowCount, unsigned sliceCount, bool nonTemporal);
+
+	// 'WriteToSubresource' issued per row block box for CPU accessible textures (custom heap, unknown layout), subresource should be mapped
+	void Write(ID3D12Resource *dst, unsigned subresource, const D3D12_SUBRESOURCE_DATA &src);
+
+	Stats GetCopyStats() noexcept, GetWriteStats() noexcept;
+}
\ No newline at end of file
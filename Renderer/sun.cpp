@@ -2760,9 +2760,8 @@ constexpr double spectralIrradianceTable[][2] =
 };
 
 // CIE 1964 supplementary standard colorimetric observer\
-[380-780] nm range, 5 nm step\
-!: consider constexpr ctors (and other stuff) for vector math
-const double3 CIE_colorMatchingTable[] =
+[380-780] nm range, 5 nm step
+constexpr double CIE_colorMatchingTable[][3] =
 {
 	{0.000160, 0.000017, 0.000705},
 	{0.000662, 0.000072, 0.002928},
@@ -2848,94 +2847,66 @@ const double3 CIE_colorMatchingTable[] =
 };
 
 // XYZ -> sRGB D65 transformation matrix from http://www.brucelindbloom.com/index.html?Eqn_RGB_XYZ_Matrix.html
-const double3x3 XYZ_2_RGB
-(
-	+3.2404542, -1.5371385, -0.4985314,
-	-0.9692660, +1.8760108, +0.0415560,
-	+0.0556434, -0.2040259, +1.0572252
-);
-
-template<bool weights>
-using BaseIteratorSelector = iterator<random_access_iterator_tag, conditional_t<weights, VectorMath::vector<double3, 2>, pair<double2, double2>>, make_signed_t<size_t>, void, void>;
-
-template<bool weights>
-class SegmentIterator : public BaseIteratorSelector<weights>
+constexpr double XYZ_2_RGB[3][3] =
 {
-	size_t segIdx;
-	typedef BaseIteratorSelector<weights> iterator;
-
-public:
-	using typename iterator::difference_type;
-	using typename iterator::value_type;
-
-public:
-	constexpr explicit SegmentIterator(size_t segIdx) noexcept : segIdx(segIdx) {}
-
-public:
-	constexpr SegmentIterator &operator ++() noexcept { return ++segIdx, *this; }
-	constexpr SegmentIterator &operator --() noexcept { return --segIdx, *this; }
-	constexpr SegmentIterator operator ++(int) noexcept { return SegmentIterator(segIdx++); }
-	constexpr SegmentIterator operator --(int) noexcept { return SegmentIterator(segIdx--); }
-	constexpr SegmentIterator operator +(difference_type offset) const noexcept { return SegmentIterator(segIdx + offset); }
-	constexpr SegmentIterator operator -(difference_type offset) const noexcept { return SegmentIterator(segIdx - offset); }
-	constexpr difference_type operator -(const SegmentIterator sub) const noexcept { return segIdx - sub.segIdx; }
-
-public:
-	friend constexpr auto operator <=>(const SegmentIterator left, const SegmentIterator right) noexcept { return left.segIdx <=> right.segIdx; }
-	friend constexpr bool operator ==(const SegmentIterator left, const SegmentIterator right) noexcept { return left.segIdx == right.segIdx; }
-	friend constexpr bool operator !=(const SegmentIterator left, const SegmentIterator right) noexcept { return left.segIdx != right.segIdx; }
-
-public:
-	value_type operator *() const;
+	{ +3.2404542, -1.5371385, -0.4985314 },
+	{ -0.9692660, +1.8760108, +0.0415560 },
+	{ +0.0556434, -0.2040259, +1.0572252 }
 };
 
-template<>
-auto SegmentIterator<false>::operator *() const -> value_type
-{
-	return { { spectralIrradianceTable[segIdx][0], spectralIrradianceTable[segIdx + 1][0] }, { spectralIrradianceTable[segIdx][1], spectralIrradianceTable[segIdx + 1][1] } };
-}
-
-template<>
-auto SegmentIterator<true>::operator *() const -> value_type
-{
-	using VectorMath::AsScalar;
-
-	double2 samplePos(spectralIrradianceTable[segIdx][0], spectralIrradianceTable[segIdx + 1][0]);
-
-	// remap λ range
-	samplePos -= spectralIrradianceTable[0][0];
-	samplePos *= (size(CIE_colorMatchingTable) - 1) / ((*prev(end(spectralIrradianceTable)))[0] - (*begin(spectralIrradianceTable))[0]);
-
-	const auto Fetch = [](double samplePos) -> tuple<double3, double3, double>/*left, right, fract*/
-	{
-		using namespace placeholders;
-		const auto Clamp = bind(clamp<make_signed_t<size_t>>, _1, 0, size(CIE_colorMatchingTable) - 1);
-		double dataSegIdx, fract = modf(samplePos, &dataSegIdx);
-		const auto leftIdx = Clamp(dataSegIdx), rightIdx = Clamp(leftIdx + 1);
-		return { CIE_colorMatchingTable[leftIdx], CIE_colorMatchingTable[rightIdx], fract };
-	};
-	const auto left = Fetch(samplePos[0]), right = Fetch(samplePos[1]);
-	return lerp(value_type(AsScalar(get<0>(left)), AsScalar(get<0>(right))), value_type(AsScalar(get<1>(left)), AsScalar(get<1>(right))), double2(get<2>(left), get<2>(right)));
-}
+constexpr double wavelengthBegin = (*begin(spectralIrradianceTable))[0], wavelengthEnd = (*prev(end(spectralIrradianceTable)))[0];
+constexpr size_t CMF_count = size(CIE_colorMatchingTable);
 
-typedef SegmentIterator<false> DataSegmentIterator;
-typedef SegmentIterator<true> WeightsSegmentIterator;
+/*
+	integrated offline by 'IntegrateSunExtraterrestrialIrradianceRGB()' below (too heavy for compile time evaluation within default constexpr step limits)
+	regenerate if any table above changes, debug builds check it against runtime integration
+*/
+constexpr double sunExtraterrestrialIrradianceRGB[3] = { 240.28489908677389, 212.33242557796373, 209.37645027870025 };
 
-const double3 sunExtraterrestrialIrradianceRGB = []
+#ifndef NDEBUG
+static double3 IntegrateSunExtraterrestrialIrradianceRGB() noexcept
 {
-	// TODO: replace with static_assert when C++20 constexpr is_sorted turns up
-	assert(is_sorted(begin(spectralIrradianceTable), end(spectralIrradianceTable), [](const remove_extent_t<decltype(spectralIrradianceTable)> &left, const remove_extent_t<decltype(spectralIrradianceTable)> &right) constexpr noexcept
+	assert(is_sorted(begin(spectralIrradianceTable), end(spectralIrradianceTable), [](const remove_extent_t<decltype(spectralIrradianceTable)> &left, const remove_extent_t<decltype(spectralIrradianceTable)> &right) noexcept
 	{
 		return left[0] < right[0];
 	}));
 
-	const auto EvalSeg = [](const DataSegmentIterator::value_type &data, const WeightsSegmentIterator::value_type &weights)
+	// color matching function linearly interpolated at wavelength
+	const auto CMF = [](double wavelength, unsigned channel) noexcept
 	{
-		return dot(data.second, weights) * (.5/*averaging factor after dot*/ * (data.first[1] - data.first[0])/*dλ*/);
+		// remap λ range
+		const double samplePos = (wavelength - wavelengthBegin) * ((CMF_count - 1) / (wavelengthEnd - wavelengthBegin));
+		const size_t dataSegIdx = samplePos;
+		const double fract = samplePos - dataSegIdx;
+		const size_t leftIdx = min(dataSegIdx, CMF_count - 1), rightIdx = min(leftIdx + 1, CMF_count - 1);
+		return (1 - fract) * CIE_colorMatchingTable[leftIdx][channel] + fract * CIE_colorMatchingTable[rightIdx][channel];
 	};
-	const double3 XYZ = inner_product(DataSegmentIterator(0), DataSegmentIterator(size(spectralIrradianceTable)), WeightsSegmentIterator(0), double3(), plus(), EvalSeg);
-	return mul(XYZ_2_RGB, XYZ);
-}();
+
+	// trapezoidal rule
+	double XYZ[3]{};
+	for (size_t segIdx = 0; segIdx + 1 < size(spectralIrradianceTable); segIdx++)
+	{
+		const auto &left = spectralIrradianceTable[segIdx], &right = spectralIrradianceTable[segIdx + 1];
+		for (unsigned channel = 0; channel < 3; channel++)
+			XYZ[channel] += (left[1] * CMF(left[0], channel) + right[1] * CMF(right[0], channel)) * (.5/*averaging factor*/ * (right[0] - left[0])/*dλ*/);
+	}
+
+	double RGB[3]{};
+	for (unsigned row = 0; row < 3; row++)
+		for (unsigned column = 0; column < 3; column++)
+			RGB[row] += XYZ_2_RGB[row][column] * XYZ[column];
+	return double3(RGB[0], RGB[1], RGB[2]);
+}
+
+static bool ValidateSunExtraterrestrialIrradianceRGB() noexcept
+{
+	const double3 integrated = IntegrateSunExtraterrestrialIrradianceRGB();
+	for (unsigned channel = 0; channel < 3; channel++)
+		if (fabs(integrated[channel] - sunExtraterrestrialIrradianceRGB[channel]) > sunExtraterrestrialIrradianceRGB[channel] * 1e-9)
+			return false;
+	return true;
+}
+#endif
 
 float3 Sun::Dir(float zenith, float azimuth)
 {
@@ -2955,5 +2926,36 @@ float3 Sun::Irradiance(float zenith, float cosZenith)
 	// Rayleigh scattering
 	using namespace std::placeholders;
 	static const double3 RayleighFactor = -.008735 * RGB_primaries.apply(bind(powl/*to eliminate ambiguity of pow*/, _1, -4.08));
-	return sunExtraterrestrialIrradianceRGB * (RayleighFactor / m_rcp).apply(exp);
+	static const double3 extraterrestrialIrradiance = []
+	{
+		assert(ValidateSunExtraterrestrialIrradianceRGB());
+		return double3(sunExtraterrestrialIrradianceRGB[0], sunExtraterrestrialIrradianceRGB[1], sunExtraterrestrialIrradianceRGB[2]);
+	}();
+	return extraterrestrialIrradiance * (RayleighFactor / m_rcp).apply(exp);
+}
+
+// function local static rather than global one as it can be accessed during static init from another TU
+auto Sun::IrradianceLUT() -> const IrradianceTable &
+{
+	static const IrradianceTable LUT = []
+	{
+		IrradianceTable LUT;
+		for (unsigned int i = 0; i < LUT.size(); i++)
+		{
+			// [0..size-1]->[0..pi/2]
+			const double zenith = M_PI_2 * i / (LUT.size() - 1);
+			LUT[i] = Irradiance(zenith, cos(zenith));
+		}
+		return LUT;
+	}();
+	return LUT;
+}
+
+float3 Sun::Irradiance(float zenith)
+{
+	const auto &LUT = IrradianceLUT();
+	// [0..pi/2]->[0..size-1]
+	const float samplePos = fmin(fabs(zenith) * float(M_2_PI * (LUT.size() - 1)), float(LUT.size() - 1));
+	const unsigned int leftIdx = min<unsigned int>(samplePos, LUT.size() - 2);
+	return lerp(LUT[leftIdx], LUT[leftIdx + 1], samplePos - leftIdx);
 }
\ No newline at end of file
@@ -7,5 +7,15 @@ namespace Renderer::Sun
 	namespace HLSL = Math::VectorMath::HLSL;
 
 	HLSL::float3 Dir(float zenith, float azimuth);
+
+	// exact evaluation
 	HLSL::float3 Irradiance(float zenith, float cosZenith);
+
+	// [0..pi/2] zenith range sampled uniformly, built once
+	constexpr unsigned int irradianceLUTSize = 256;
+	typedef std::array<HLSL::float3, irradianceLUTSize> IrradianceTable;
+	const IrradianceTable &IrradianceLUT();
+
+	// LUT lookup with linear interpolation
+	HLSL::float3 Irradiance(float zenith);
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <wrl/client.h>
+#include "PSO library.h"
 #define DISABLE_MATRIX_SWIZZLES
 #if !__INTELLISENSE__ 
 #include "vector math.h"
@@ -23,7 +24,7 @@ namespace Renderer::TerrainMaterials
 			const WRL::ComPtr<ID3D12RootSignature> rootSig;
 
 		protected:
-			const WRL::ComPtr<ID3D12PipelineState> PSO;
+			const Renderer::Impl::DeferredPSO PSO;
 			const UINT color;	// for PIX
 
 		protected:
@@ -36,7 +37,7 @@ namespace Renderer::TerrainMaterials
 			static void FillRootParams(CD3DX12_ROOT_PARAMETER1 dst[]);
 
 		protected:
-			Interface(UINT color, const WRL::ComPtr<ID3D12RootSignature> &rootSig, const WRL::ComPtr<ID3D12PipelineState> &PSO);
+			Interface(UINT color, const WRL::ComPtr<ID3D12RootSignature> &rootSig, const Renderer::Impl::DeferredPSO &PSO);
 			~Interface();
 
 		public:
@@ -2,6 +2,7 @@
 #include "terrain materials.hh"
 #include "texture.hh"
 #include "GPU texture sampler tables.h"
+#include "memory accounting.h"
 #include "fresnel.h"
 #include "shader bytecode.h"
 #include "config.h"
@@ -24,6 +25,7 @@ namespace Shaders
 using namespace std;
 using namespace Renderer::TerrainMaterials;
 using WRL::ComPtr;
+using Renderer::Impl::globalPSOLibrary;
 using Misc::AllocatorProxy;
 
 extern ComPtr<ID3D12Device2> device;
@@ -39,7 +41,7 @@ inline void Impl::Interface::FillRootParams(CD3DX12_ROOT_PARAMETER1 rootParams[]
 	rootParams[ROOT_PARAM_TONEMAP_PARAMS_CBV].InitAsConstantBufferView(0, 1, D3D12_ROOT_DESCRIPTOR_FLAG_NONE, D3D12_SHADER_VISIBILITY_PIXEL);
 }
 
-Impl::Interface::Interface(UINT color, const ComPtr<ID3D12RootSignature> &rootSig, const ComPtr<ID3D12PipelineState> &PSO) :
+Impl::Interface::Interface(UINT color, const ComPtr<ID3D12RootSignature> &rootSig, const Renderer::Impl::DeferredPSO &PSO) :
 	rootSig(rootSig), PSO(PSO), color(color)
 {
 }
@@ -65,6 +67,7 @@ Impl::DescriptorTable::DescriptorTable(unsigned size, const char materialName[])
 		D3D12_DESCRIPTOR_HEAP_FLAG_NONE				// GPU invisible
 	};
 	CheckHR(device->CreateDescriptorHeap(&desc, IID_PPV_ARGS(stage.GetAddressOf())));
+	Renderer::MemoryAccounting::Track(stage.Get(), Renderer::MemoryAccounting::Category::Descriptors);
 #ifdef _MSC_VER
 	// same workaround as for terrain layer
 	wstring_convert<codecvt_utf8<WCHAR>> converter;
@@ -120,7 +123,7 @@ inline void Impl::TexStuff<Base>::FinishSetup(ID3D12GraphicsCommandList4 *cmdLis
 
 template<class Base>
 template<typename ExtraArg>
-inline Impl::TexStuff<Base>::TexStuff(float texScale, unsigned textureCount, const char materialName[], const ExtraArg &extraArg, const WRL::ComPtr<ID3D12RootSignature> &rootSig, const WRL::ComPtr<ID3D12PipelineState> &PSO) :
+inline Impl::TexStuff<Base>::TexStuff(float texScale, unsigned textureCount, const char materialName[], const ExtraArg &extraArg, const WRL::ComPtr<ID3D12RootSignature> &rootSig, const Renderer::Impl::DeferredPSO &PSO) :
 	DescriptorTable(textureCount, materialName),
 	Base(extraArg, rootSig, PSO),
 	texScale(texScale)
@@ -137,7 +140,7 @@ ComPtr<ID3D12RootSignature> Flat::CreateRootSig()
 	return CreateRootSignature(sigDesc, L"terrain flat material root signature");
 }
 
-ComPtr<ID3D12PipelineState> Flat::CreatePSO()
+Renderer::Impl::DeferredPSO Flat::CreatePSO()
 {
 	const CD3DX12_RASTERIZER_DESC rasterDesc
 	(
@@ -190,10 +193,7 @@ ComPtr<ID3D12PipelineState> Flat::CreatePSO()
 		.Flags					= D3D12_PIPELINE_STATE_FLAG_NONE
 	};
 
-	ComPtr<ID3D12PipelineState> result;
-	CheckHR(device->CreateGraphicsPipelineState(&PSO_desc, IID_PPV_ARGS(result.GetAddressOf())));
-	NameObject(result.Get(), L"terrain flat material PSO");
-	return result;
+	return globalPSOLibrary->Compile(PSO_desc, L"terrain flat material PSO");
 }
 
 inline void Flat::FillRootParams(CD3DX12_ROOT_PARAMETER1 rootParams[])
@@ -207,7 +207,7 @@ static inline BYTE float2BYTE(float val) noexcept
 	return val * numeric_limits<BYTE>::max();
 };
 
-Flat::Flat(const float (&albedo)[3], const ComPtr<ID3D12RootSignature> &rootSig, const ComPtr<ID3D12PipelineState> &PSO) :
+Flat::Flat(const float (&albedo)[3], const ComPtr<ID3D12RootSignature> &rootSig, const Renderer::Impl::DeferredPSO &PSO) :
 	Interface(PIX_COLOR(float2BYTE(albedo[0]), float2BYTE(albedo[1]), float2BYTE(albedo[2])), rootSig, PSO),
 	albedo{ albedo[0], albedo[1], albedo[2] }
 {
@@ -241,7 +241,7 @@ ComPtr<ID3D12RootSignature> Masked::CreateRootSig()
 	return CreateRootSignature(sigDesc, L"terrain masked material root signature");
 }
 
-ComPtr<ID3D12PipelineState> Masked::CreatePSO()
+Renderer::Impl::DeferredPSO Masked::CreatePSO()
 {
 	const CD3DX12_RASTERIZER_DESC rasterDesc
 	(
@@ -294,10 +294,7 @@ ComPtr<ID3D12PipelineState> Masked::CreatePSO()
 		.Flags					= D3D12_PIPELINE_STATE_FLAG_NONE
 	};
 
-	ComPtr<ID3D12PipelineState> result;
-	CheckHR(device->CreateGraphicsPipelineState(&PSO_desc, IID_PPV_ARGS(result.GetAddressOf())));
-	NameObject(result.Get(), L"terrain masked material PSO");
-	return result;
+	return globalPSOLibrary->Compile(PSO_desc, L"terrain masked material PSO");
 }
 
 // 1 call site
@@ -342,7 +339,7 @@ ComPtr<ID3D12RootSignature> Standard::CreateRootSig()
 	return CreateRootSignature(sigDesc, L"terrain standard material root signature");
 }
 
-ComPtr<ID3D12PipelineState> Standard::CreatePSO()
+Renderer::Impl::DeferredPSO Standard::CreatePSO()
 {
 	const CD3DX12_RASTERIZER_DESC rasterDesc
 	(
@@ -395,10 +392,7 @@ ComPtr<ID3D12PipelineState> Standard::CreatePSO()
 		.Flags					= D3D12_PIPELINE_STATE_FLAG_NONE
 	};
 
-	ComPtr<ID3D12PipelineState> result;
-	CheckHR(device->CreateGraphicsPipelineState(&PSO_desc, IID_PPV_ARGS(result.GetAddressOf())));
-	NameObject(result.Get(), L"terrain standard material PSO");
-	return result;
+	return globalPSOLibrary->Compile(PSO_desc, L"terrain standard material PSO");
 }
 
 // 1 call site
@@ -460,7 +454,7 @@ ComPtr<ID3D12RootSignature> Extended::CreateRootSig()
 	return CreateRootSignature(sigDesc, L"terrain extended material root signature");
 }
 
-ComPtr<ID3D12PipelineState> Extended::CreatePSO()
+Renderer::Impl::DeferredPSO Extended::CreatePSO()
 {
 	const CD3DX12_RASTERIZER_DESC rasterDesc
 	(
@@ -513,10 +507,7 @@ ComPtr<ID3D12PipelineState> Extended::CreatePSO()
 		.Flags					= D3D12_PIPELINE_STATE_FLAG_NONE
 	};
 
-	ComPtr<ID3D12PipelineState> result;
-	CheckHR(device->CreateGraphicsPipelineState(&PSO_desc, IID_PPV_ARGS(result.GetAddressOf())));
-	NameObject(result.Get(), L"terrain extended material PSO");
-	return result;
+	return globalPSOLibrary->Compile(PSO_desc, L"terrain extended material PSO");
 }
 
 // 1 call site
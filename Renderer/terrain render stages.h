@@ -8,6 +8,7 @@
 #include "render passes.h"
 #include "render pipeline.h"
 #include "occlusion query batch.h"
+#include "PSO library.h"
 
 extern std::pmr::synchronized_pool_resource globalTransientRAM;
 
@@ -44,7 +45,7 @@ private:
 #pragma region occlusion query pass
 private:
 	static WRL::ComPtr<ID3D12RootSignature> cullPassRootSig, CreateCullPassRootSig();
-	static WRL::ComPtr<ID3D12PipelineState> cullPassPSO, CreateCullPassPSO();
+	static Impl::DeferredPSO cullPassPSO, CreateCullPassPSO();
 
 private:
 	const std::shared_ptr<OcclusionQueryPass> queryPass;
@@ -139,7 +140,7 @@ private:
 #pragma region visualize occlusion pass
 private:
 	static WRL::ComPtr<ID3D12RootSignature> AABB_rootSig, CreateAABB_RootSig();
-	static WRL::ComPtr<ID3D12PipelineState> AABB_PSO, CreateAABB_PSO();
+	static Impl::DeferredPSO AABB_PSO, CreateAABB_PSO();
 
 private:
 	std::shared_ptr<const OcclusionQueryPass> queryPass;
@@ -16,6 +16,7 @@
 #include "global GPU buffer data.h"
 #include "shader bytecode.h"
 #include "config.h"
+#include "memory accounting.h"
 #include "PIX events.h"
 #ifdef _MSC_VER
 #include <codecvt>
@@ -42,6 +43,7 @@ using namespace Renderer;
 using namespace HLSL;
 using pmr::polymorphic_allocator;
 using WRL::ComPtr;
+using Impl::globalPSOLibrary;
 namespace OcclusionCulling = Impl::OcclusionCulling;
 namespace CmdListPool = Impl::CmdListPool;
 namespace RenderPipeline = Impl::RenderPipeline;
@@ -164,7 +166,7 @@ ComPtr<ID3D12RootSignature> TerrainVectorQuad::MainRenderStage::CreateCullPassRo
 	return CreateRootSignature(sigDesc, L"terrain occlusion query root signature");
 }
 
-ComPtr<ID3D12PipelineState> TerrainVectorQuad::MainRenderStage::CreateCullPassPSO()
+Impl::DeferredPSO TerrainVectorQuad::MainRenderStage::CreateCullPassPSO()
 {
 	const D3D12_BLEND_DESC blendDesc
 	{
@@ -233,10 +235,7 @@ ComPtr<ID3D12PipelineState> TerrainVectorQuad::MainRenderStage::CreateCullPassPS
 		.Flags					= D3D12_PIPELINE_STATE_FLAG_NONE
 	};
 
-	ComPtr<ID3D12PipelineState> result;
-	CheckHR(device->CreateGraphicsPipelineState(&PSO_desc, IID_PPV_ARGS(result.GetAddressOf())));
-	NameObject(result.Get(), L"terrain occlusion query PSO");
-	return result;
+	return globalPSOLibrary->Compile(PSO_desc, L"terrain occlusion query PSO");
 }
 
 void TerrainVectorQuad::MainRenderStage::CullPassPre(CmdListPool::CmdList &cmdList) const
@@ -480,7 +479,7 @@ auto TerrainVectorQuad::MainRenderStage::GetCullPassRange(unsigned int &length)
 {
 	using namespace placeholders;
 	return IterateRenderPass(length, queryPass->queryStream.size(), nullptr, { stageZBinding, true, false }, stageOutput,
-		[] { phaseSelector = static_cast<decltype(phaseSelector)>(&MainRenderStage::GetCullPass2MainPass); },
+		[this] { phaseSelector = static_cast<decltype(phaseSelector)>(&MainRenderStage::GetCullPass2MainPass); },
 		[this](unsigned long rangeBegin, unsigned long rangeEnd, const RenderPasses::RenderPass &renderPass) { return bind(&MainRenderStage::CullPassRange, shared_from_this(), _1, rangeBegin, rangeEnd, move(renderPass)); });
 }
 
@@ -496,14 +495,14 @@ auto TerrainVectorQuad::MainRenderStage::GetMainPassRange(unsigned int &length)
 	using namespace placeholders;
 	RenderPasses::PassROPBinding<RenderPasses::StageRTBinding> RTBinding{ stageRTBinding, true, true };
 	return IterateRenderPass(length, renderStream.size(), &RTBinding, { stageZBinding, false, true }, stageOutput,
-		[] { phaseSelector = static_cast<decltype(phaseSelector)>(&MainRenderStage::GetStagePost); },
+		[this] { phaseSelector = static_cast<decltype(phaseSelector)>(&MainRenderStage::GetStagePost); },
 		[this](unsigned long rangeBegin, unsigned long rangeEnd, const RenderPasses::RenderPass &renderPass) { return bind(&MainRenderStage::MainPassRange, shared_from_this(), _1, rangeBegin, rangeEnd, move(renderPass)); });
 }
 
 auto TerrainVectorQuad::MainRenderStage::GetStagePost(unsigned int &) const -> RenderPipeline::PipelineItem
 {
 	using namespace placeholders;
-	RenderPipeline::TerminateStageTraverse();
+	FinishTraverse();
 	return RenderPipeline::PipelineItem{ bind(&MainRenderStage::StagePost, shared_from_this(), _1) };
 }
 
@@ -634,7 +633,7 @@ ComPtr<ID3D12RootSignature> TerrainVectorQuad::DebugRenderStage::CreateAABB_Root
 	return CreateRootSignature(sigDesc, L"terrain AABB visualization root signature");
 }
 
-ComPtr<ID3D12PipelineState> TerrainVectorQuad::DebugRenderStage::CreateAABB_PSO()
+Impl::DeferredPSO TerrainVectorQuad::DebugRenderStage::CreateAABB_PSO()
 {
 	const CD3DX12_RASTERIZER_DESC rasterDesc
 	(
@@ -688,10 +687,7 @@ ComPtr<ID3D12PipelineState> TerrainVectorQuad::DebugRenderStage::CreateAABB_PSO(
 		.Flags					= D3D12_PIPELINE_STATE_FLAG_NONE
 	};
 
-	ComPtr<ID3D12PipelineState> result;
-	CheckHR(device->CreateGraphicsPipelineState(&PSO_desc, IID_PPV_ARGS(result.GetAddressOf())));
-	NameObject(result.Get(), L"terrain AABB visualization PSO");
-	return result;
+	return globalPSOLibrary->Compile(PSO_desc, L"terrain AABB visualization PSO");
 }
 
 void TerrainVectorQuad::DebugRenderStage::AABBPassPre(CmdListPool::CmdList &cmdList) const
@@ -757,7 +753,7 @@ auto TerrainVectorQuad::DebugRenderStage::GetVisiblePassRange(unsigned int &leng
 	using namespace placeholders;
 	RenderPasses::PassROPBinding<RenderPasses::StageRTBinding> RTBinding{ stageRTBinding, true, false };
 	return IterateRenderPass(length, queryPass->queryStream.size(), &RTBinding, { stageZBinding, true, false }, stageOutput,
-		[] { phaseSelector = static_cast<decltype(phaseSelector)>(&DebugRenderStage::GetCulledPassRange); },
+		[this] { phaseSelector = static_cast<decltype(phaseSelector)>(&DebugRenderStage::GetCulledPassRange); },
 		[this](unsigned long rangeBegin, unsigned long rangeEnd, const RenderPasses::RenderPass &renderPass) { return bind(&DebugRenderStage::AABBPassRange, shared_from_this(), _1, rangeBegin, rangeEnd, move(renderPass), cref(OcclusionCulling::DebugColors::Terrain::visible), true); });
 }
 
@@ -766,7 +762,7 @@ auto TerrainVectorQuad::DebugRenderStage::GetCulledPassRange(unsigned int &lengt
 	using namespace placeholders;
 	RenderPasses::PassROPBinding<RenderPasses::StageRTBinding> RTBinding{ stageRTBinding, false, true };
 	return IterateRenderPass(length, queryPass->queryStream.size(), &RTBinding, { stageZBinding, false, true }, stageOutput,
-		[] { RenderPipeline::TerminateStageTraverse(); },
+		[this] { FinishTraverse(); },
 		[this](unsigned long rangeBegin, unsigned long rangeEnd, const RenderPasses::RenderPass &renderPass) { return bind(&DebugRenderStage::AABBPassRange, shared_from_this(), _1, rangeBegin, rangeEnd, move(renderPass), cref(OcclusionCulling::DebugColors::Terrain::culled), false); });
 }
 
@@ -804,6 +800,7 @@ TerrainVectorQuad::TerrainVectorQuad(shared_ptr<TerrainVectorLayer> &&layer, uns
 			D3D12_RESOURCE_STATE_GENERIC_READ,
 			NULL,	// clear value
 			IID_PPV_ARGS(&VIB)));
+		MemoryAccounting::Track(VIB.Get(), MemoryAccounting::Category::Geometry);
 		const auto &aabb = subtree.GetAABB();
 		// explicitly convert to floats since .x/.y are swizzles which can not be passed to variadic function
 #ifdef _MSC_VER
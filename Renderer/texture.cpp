@@ -3,6 +3,8 @@
 #include "DMA engine.h"
 #include "system.h"
 #include "DDSTextureLoader12.h"
+#include "memory accounting.h"
+#include "subresource copy.h"
 
 #define FORCE_PARALLEL_IO 0
 
@@ -47,6 +49,20 @@ static inline DirectX::DDS_LOADER_FLAGS DecodeTextureUsage(TextureUsage usage)
 	}
 }
 
+// effective CPU side bandwidth of texture data population, accumulated over all loads so far
+static void ReportCopyStats()
+{
+	using namespace Impl::SubresourceCopy;
+	const auto print = [](const char title[], const Stats &stats)
+	{
+		if (stats.bytes)
+			wclog << title << ": " << stats.bytes / (1024. * 1024.) << " MB in " << chrono::duration<double, milli>(stats.time).count() << " ms (" << stats.Bandwidth() / (1024. * 1024. * 1024.) << " GB/s)" << endl;
+	};
+	System::WideIOGuard IOGuard(stderr);
+	print("Texture upload copy", GetCopyStats());
+	print("Texture sys RAM write", GetWriteStats());
+}
+
 // 1 call site
 static inline void ValidateTexture(const D3D12_RESOURCE_DESC &desc, TextureUsage usage)
 {
@@ -158,26 +174,53 @@ Impl::Texture::Texture(const filesystem::path &fileName, TextureUsage usage, boo
 		reinterpret_cast<underlying_type_t<DDS_LOADER_FLAGS> &>(loadFlags) |= DDS_LOADER_THROTTLE_IO;
 #endif
 
-	// load from file & create texture
+	// read header & create texture, texture data keeps streaming from file meanwhile
 	unique_ptr<uint8_t []> data;
 	vector<D3D12_SUBRESOURCE_DATA> subresources;
-	CheckHR(LoadDDSTextureFromFileEx(device.Get(), fileName.c_str(), 0, D3D12_RESOURCE_FLAG_NONE, loadFlags, useSysRAM ? DDS_CPU_ACCESS_INDIRECT : DDS_CPU_ACCESS_DENY, tex.GetAddressOf(), data, subresources));
-	ValidateTexture(tex->GetDesc(), usage);
+	unique_ptr<DDSFileStream> stream;	// declared after 'data' => destroyed (pending reads canceled) before the buffer they target
+	CheckHR(LoadDDSTextureFromFileStreamed(device.Get(), fileName.c_str(), 0, D3D12_RESOURCE_FLAG_NONE, loadFlags, useSysRAM ? DDS_CPU_ACCESS_INDIRECT : DDS_CPU_ACCESS_DENY, tex.GetAddressOf(), data, subresources, stream));
+	const auto desc = tex->GetDesc();
+	ValidateTexture(desc, usage);
+	MemoryAccounting::Track(tex.Get(), MemoryAccounting::Category::Textures);
+
+	// subresources laid out in file order (mip 0 first) => copying can start as soon as leading chunks arrive
+	const auto SubresourceEnd = [&](unsigned idx) noexcept
+	{
+		const auto &src = subresources[idx];
+		const UINT depth = desc.Dimension == D3D12_RESOURCE_DIMENSION_TEXTURE3D ? max(desc.DepthOrArraySize >> idx, 1) : 1;
+		return static_cast<const uint8_t *>(src.pData) + src.SlicePitch * depth;
+	};
+
+	// I/O error recorded rather than thrown (called from within copying), reported after texture data written
+	HRESULT ioResult = S_OK;
+	const auto waitForSubresource = [&](unsigned idx) noexcept
+	{
+		if (SUCCEEDED(ioResult) && FAILED(ioResult = stream->WaitFor(SubresourceEnd(idx))))
+		{
+			// drain pending reads before touching their target, then zero the rest instead of copying garbage
+			stream.reset();
+			const auto begin = static_cast<const uint8_t *>(subresources[idx].pData), end = SubresourceEnd(size(subresources) - 1);
+			fill(data.get() + (begin - data.get()), data.get() + (end - data.get()), 0);
+		}
+	};
 
 	// write texture data
 	if (useSysRAM)
 	{
-		//TODO: implement loop tiling optimization for cache-friendly access pattern (https://docs.microsoft.com/en-us/windows/desktop/api/d3d12/nf-d3d12-id3d12resource-writetosubresource#remarks)
+		// loop tiling for cache-friendly access pattern (https://docs.microsoft.com/en-us/windows/desktop/api/d3d12/nf-d3d12-id3d12resource-writetosubresource#remarks)
 		for (unsigned mip = 0; mip < size(subresources); mip++)
 		{
+			waitForSubresource(mip);
 			CheckHR(tex->Map(mip, &CD3DX12_RANGE(0, 0), NULL));
-			const auto &curMipData = subresources[mip];
-			CheckHR(tex->WriteToSubresource(mip, NULL, curMipData.pData, curMipData.RowPitch, curMipData.SlicePitch));
+			SubresourceCopy::Write(tex.Get(), mip, subresources[mip]);
 			tex->Unmap(mip, NULL);
 		}
 	}
 	else
-		DMA::Upload2VRAM(tex, subresources, fileName.filename().c_str());
+		DMA::Upload2VRAM(tex, subresources, fileName.filename().c_str(), waitForSubresource);
+
+	CheckHR(ioResult);
+	CheckHR(stream->WaitForAll());	// trailing data not covered by subresources (if any)
 }
 
 // not thread-safe
@@ -201,13 +244,22 @@ Impl::Texture::operator bool() const noexcept
 
 void Impl::Texture::WaitForPendingLoads()
 {
-	for_each(pendingLoads.begin(), pendingLoads.end(), mem_fn(&decltype(pendingLoads)::value_type::wait));
-	pendingLoads.clear();
+	if (!pendingLoads.empty())
+	{
+		for_each(pendingLoads.begin(), pendingLoads.end(), mem_fn(&decltype(pendingLoads)::value_type::wait));
+		pendingLoads.clear();
+		ReportCopyStats();
+	}
 }
 
 bool Impl::Texture::PendingLoadsCompleted()
 {
 	// NOTE: consider self-deletion upon async finishing, it somewhat more complicated and require additional syncs
-	pendingLoads.remove_if([](decltype(pendingLoads)::const_reference load) { return load.wait_for(0s) == future_status::ready; });
+	if (!pendingLoads.empty())
+	{
+		pendingLoads.remove_if([](decltype(pendingLoads)::const_reference load) { return load.wait_for(0s) == future_status::ready; });
+		if (pendingLoads.empty())
+			ReportCopyStats();
+	}
 	return pendingLoads.empty();
 }
\ No newline at end of file
@@ -1,5 +1,6 @@
 #include "stdafx.h"
 #include "tonemap resource views stage.h"
+#include "memory accounting.h"
 
 using namespace Renderer::Impl::Descriptors;
 using WRL::ComPtr;
@@ -18,6 +19,7 @@ TonemapResourceViewsStage::TonemapResourceViewsStage()
 	};
 	CheckHR(device->CreateDescriptorHeap(&heapDesc, IID_PPV_ARGS(allocation.GetAddressOf())));
 	NameObjectF(allocation.Get(), L"CPU descriptor stage for tonemap reduction resources (D3D object: %p, heap start CPU address: %p)", allocation.Get(), allocation->GetCPUDescriptorHandleForHeapStart());
+	MemoryAccounting::Track(allocation.Get(), MemoryAccounting::Category::Descriptors);
 }
 
 void TonemapResourceViewsStage::Fill(ID3D12Resource *src, ID3D12Resource *dst, ID3D12Resource *reductionBuffer, UINT reductionBufferLength)
@@ -7,6 +7,7 @@
 #include "shader bytecode.h"
 #include "CB register.h"
 #include "DMA engine.h"
+#include "memory accounting.h"
 #include "config.h"
 #include "PIX events.h"
 #include "tonemapping config.h"
@@ -105,7 +106,7 @@ ComPtr<ID3D12RootSignature> Impl::Viewport::CreateTonemapRootSig()
 	return CreateRootSignature(sigDesc, L"tonemapping root signature");
 }
 
-ComPtr<ID3D12PipelineState> Impl::Viewport::CreateTonemapTextureReductionPSO()
+Impl::DeferredPSO Impl::Viewport::CreateTonemapTextureReductionPSO()
 {
 	const D3D12_COMPUTE_PIPELINE_STATE_DESC PSO_desc =
 	{
@@ -116,13 +117,10 @@ ComPtr<ID3D12PipelineState> Impl::Viewport::CreateTonemapTextureReductionPSO()
 		D3D12_PIPELINE_STATE_FLAG_NONE						// flags
 	};
 
-	ComPtr<ID3D12PipelineState> PSO;
-	CheckHR(device->CreateComputePipelineState(&PSO_desc, IID_PPV_ARGS(PSO.GetAddressOf())));
-	NameObject(PSO.Get(), L"tonemap texture reduction PSO");
-	return PSO;
+	return globalPSOLibrary->Compile(PSO_desc, L"tonemap texture reduction PSO");
 }
 
-ComPtr<ID3D12PipelineState> Impl::Viewport::CreateTonemapBufferReductionPSO()
+Impl::DeferredPSO Impl::Viewport::CreateTonemapBufferReductionPSO()
 {
 	const D3D12_COMPUTE_PIPELINE_STATE_DESC PSO_desc =
 	{
@@ -133,13 +131,10 @@ ComPtr<ID3D12PipelineState> Impl::Viewport::CreateTonemapBufferReductionPSO()
 		D3D12_PIPELINE_STATE_FLAG_NONE						// flags
 	};
 
-	ComPtr<ID3D12PipelineState> PSO;
-	CheckHR(device->CreateComputePipelineState(&PSO_desc, IID_PPV_ARGS(PSO.GetAddressOf())));
-	NameObject(PSO.Get(), L"tonemap buffer reduction PSO");
-	return PSO;
+	return globalPSOLibrary->Compile(PSO_desc, L"tonemap buffer reduction PSO");
 }
 
-ComPtr<ID3D12PipelineState> Impl::Viewport::CreateTonemapPSO()
+Impl::DeferredPSO Impl::Viewport::CreateTonemapPSO()
 {
 	const D3D12_COMPUTE_PIPELINE_STATE_DESC PSO_desc =
 	{
@@ -150,10 +145,7 @@ ComPtr<ID3D12PipelineState> Impl::Viewport::CreateTonemapPSO()
 		D3D12_PIPELINE_STATE_FLAG_NONE						// flags
 	};
 
-	ComPtr<ID3D12PipelineState> PSO;
-	CheckHR(device->CreateComputePipelineState(&PSO_desc, IID_PPV_ARGS(PSO.GetAddressOf())));
-	NameObject(PSO.Get(), L"tonemapping PSO");
-	return PSO;
+	return globalPSOLibrary->Compile(PSO_desc, L"tonemapping PSO");
 }
 #pragma endregion
 
@@ -286,6 +278,14 @@ Impl::Viewport::Viewport(shared_ptr<const Renderer::World> world) : world(move(w
 		IID_PPV_ARGS(tonemapParamsBuffer.GetAddressOf())
 	));
 	NameObjectF(tonemapParamsBuffer.Get(), L"tonemap params buffer for viewport %p", static_cast<Renderer::Viewport *>(this));
+	MemoryAccounting::Track(tonemapParamsBuffer.Get(), MemoryAccounting::Category::ConstantBuffers);
+}
+
+auto Impl::Viewport::GetRenderStreamStateChanges() const -> pair<RenderStreamStateChanges, RenderStreamStateChanges>
+{
+	if (ctx.renderStreamsStateChanges.valid())
+		return ctx.renderStreamsStateChanges.get();
+	return {};
 }
 
 void Impl::Viewport::SetViewTransform(const float (&matrix)[4][3])
@@ -6,6 +6,7 @@
 #include <utility>
 #include <type_traits>
 #include <memory>
+#include <array>
 #include <vector>
 #include <wrl/client.h>
 #define DISABLE_MATRIX_SWIZZLES
@@ -111,6 +112,17 @@ namespace Renderer::Impl::Hierarchy
 	template<TreeStructure treeStructure, class Object, class ...CustomNodeData>
 	class View;
 
+	// per view params for shared multi-view schedule
+	template<class View, class Allocator>
+	struct ViewScheduleDesc
+	{
+		View &view;
+		Allocator &GPU_AABB_allocator;
+		const typename View::Culler &frustumCuller;
+		const HLSL::float4x4 &frustumXform;
+		const HLSL::float4x3 *depthSortXform;
+	};
+
 	// currently for static geometry only
 	template<TreeStructure treeStructure, class Object, class ...CustomNodeData>
 	class BVH
@@ -164,9 +176,18 @@ namespace Renderer::Impl::Hierarchy
 		private:
 			template<typename ...Args, typename NodeHandler, typename ReorderProvider>
 			void Traverse(NodeHandler &nodeHandler, ReorderProvider reorderProvider, Args ...args);
-			template<bool enableEarlyOut, class Allocator>
-			std::pair<unsigned long int, bool> Schedule(View &view, Allocator &GPU_AABB_allocator, const FrustumCuller<decltype(aabb.Center())::dimension> &frustumCuller, const HLSL::float4x4 &frustumXform, const HLSL::float4x3 *depthSortXform,
-				bool parentInsideFrustum = false, float parentOcclusionCulledProjLength = INFINITY, float parentOcclusion = 0);
+			// state passed down the tree for each view
+			struct ScheduleViewState
+			{
+				bool parentInsideFrustum = false, parentCoherent = false;
+				unsigned int parentCullPlanes = View::Culler::allPlanesMask;	// frustum planes parent straddles (all initially), children test only them
+				struct
+				{
+					float parentOcclusionCulledProjLength = INFINITY, parentOcclusion = 0;
+				} occlusion;
+			};
+			template<bool enableEarlyOut, class Allocator, size_t viewCount>
+			std::array<std::pair<unsigned long int, bool>, viewCount> Schedule(const ViewScheduleDesc<View, Allocator> (&views)[viewCount], unsigned int viewMask, std::array<ScheduleViewState, viewCount> state);
 			template<bool enableEarlyOut>
 			std::pair<unsigned long int, float> CollectOcclusionQueryBoxes(const View &view, const Node **boxesBegin, const Node **boxesEnd);
 		};
@@ -237,6 +258,10 @@ namespace Renderer::Impl::Hierarchy
 				ForceComposite	= 0b0010,
 			} occlusionCullDomain{};	// can be overridden by parent during tree traverse; need to init in order to eliminate possible UB due to uninit read in OverrideOcclusionCullDomain()
 			OcclusionQueryGeometry occlusionQueryGeometry;
+			// temporal coherence
+			unsigned long int coherenceGeneration{};	// matches View's one if node is inside its reference frustum shrunk by coherence margin
+			bool stable{};								// whole subtree visible without occlusion queries as of last schedule
+			bool coherent{};							// subtree schedule skipped in current frame, previous results reused
 
 		public:
 			Node();
@@ -262,19 +287,47 @@ namespace Renderer::Impl::Hierarchy
 		const BVH *bvh;
 		std::unique_ptr<Node []> nodes;
 
+	public:
+		typedef FrustumCuller<decltype(std::declval<Object>().GetAABB().Center())::dimension> Culler;
+
+	private:
+		/*
+			temporal coherence mode
+			reference frustum kept until camera moves so much that frustum planes change over BVH bounds exceeds coherence margin
+			nodes inside reference frustum shrunk by the margin are then guaranteed to be inside current frustum and skip frustum test,
+			stable subtrees among them skip schedule altogether and get issued as single objects span
+		*/
+		static constexpr float coherenceShrink = .02f;	// margin relative to frustum planes magnitude over BVH bounds
+		bool temporalCoherence = false;
+		enum class Coherence : unsigned char
+		{
+			Off,
+			Rebuild,
+			Reuse,
+		} coherence = Coherence::Off;
+		std::shared_ptr<Culler> coherenceFrustum;	// incomplete here
+		float coherenceMargin = 0.f;
+		unsigned long int coherenceGeneration{};
+
 	public:
 		View() = default;
-		explicit View(const BVH &bvh);
+		explicit View(const BVH &bvh, bool temporalCoherence = false);
 		View(View &&) = default;
 		View &operator =(View &&) = default;
 
 	private:
 		template<typename ...Args, typename F>
 		void Traverse(F &nodeHandler, const Args &...args) const;
+		void SetupCoherence(const Culler &frustumCuller);
 
 	public:
 		template<bool enableEarlyOut, class Allocator>
-		void Schedule(Allocator &GPU_AABB_allocator, const FrustumCuller<decltype(std::declval<Object>().GetAABB().Center())::dimension> &frustumCuller, const HLSL::float4x4 &frustumXform, const HLSL::float4x3 *depthSortXform = nullptr);
+		void Schedule(Allocator &GPU_AABB_allocator, const Culler &frustumCuller, const HLSL::float4x4 &frustumXform, const HLSL::float4x3 *depthSortXform = nullptr);
+		// single tree walk for several views of the same BVH (shadow cascades, split screen, reflections), each node tested against frustums of views still visiting it
+		// produces the same per view results as separate Schedule() calls, Issue() then emits render stream for each view
+		template<bool enableEarlyOut, class Allocator, size_t viewCount>
+		static void Schedule(const ViewScheduleDesc<View, Allocator> (&views)[viewCount]);
+		// issueObjects(node, coarse occlusion, fine occlusion, visibility, subtree), 'subtree' - issue whole subtree objects and stop traverse (coherent subtree)
 		template<typename IssueOcclusion, typename IssueObjects>
 		void Issue(const IssueOcclusion &issueOcclusion, const IssueObjects &issueObjects, std::remove_const_t<decltype(OcclusionCulling::QueryBatchBase::npos)> &occlusionProvider) const;
 		void Reset();
@@ -268,174 +268,277 @@ namespace Renderer::Impl::Hierarchy
 		}
 	}
 
+	// views for which node is completely outside frustum get masked out for whole subtree, returns <culled tris, child query canceled> for each view
 	template<TreeStructure treeStructure, class Object, class ...CustomNodeData>
-	template<bool enableEarlyOut, class Allocator>
-	std::pair<unsigned long int, bool> BVH<treeStructure, Object, CustomNodeData...>::Node::Schedule(View &view, Allocator &GPU_AABB_allocator, const FrustumCuller<decltype(aabb.Center())::dimension> &frustumCuller, const HLSL::float4x4 &frustumXform, const HLSL::float4x3 *depthSortXform,
-		bool parentInsideFrustum, float parentOcclusionCulledProjLength, float parentOcclusion)
+	template<bool enableEarlyOut, class Allocator, size_t viewCount>
+	auto BVH<treeStructure, Object, CustomNodeData...>::Node::Schedule(const ViewScheduleDesc<View, Allocator> (&views)[viewCount], unsigned int viewMask, std::array<ScheduleViewState, viewCount> state)
+		-> std::array<std::pair<unsigned long int, bool>, viewCount>
 	{
 		using namespace std;
 
 		typedef View::Node::Visibility Visibility;
-		auto &viewData = view.nodes[idx];
 
-		viewData.occlusionQueryGeometry = nullptr;
+		const auto forEachView = [](unsigned int viewMask, const auto &action)
+		{
+			for (unsigned int viewIdx = 0; viewIdx < viewCount; viewIdx++)
+				if (viewMask & 1u << viewIdx)
+					action(viewIdx);
+		};
+
+		array<pair<unsigned long int, bool>, viewCount> results{};
 
 		// cull if necessary
-		if (!parentInsideFrustum)
+		forEachView(viewMask, [&](unsigned int viewIdx)
 		{
-			switch (frustumCuller.Cull<false>(aabb))
+			const View &view = views[viewIdx].view;
+			auto &viewData = view.nodes[idx];
+			auto &viewState = state[viewIdx];
+
+			viewData.occlusionQueryGeometry = nullptr;
+			viewData.coherent = false;
+
+			// inside shrunk reference frustum => inside current one
+			if (view.coherence == View::Coherence::Reuse && viewData.coherenceGeneration == view.coherenceGeneration)
 			{
-			case CullResult::OUTSIDE:
-				viewData.visibility = Visibility::Culled;
-				return { GetInclusiveTriCount(), false };
-			case CullResult::INSIDE:
-				parentInsideFrustum = true;
-				break;
+				// reuse whole subtree schedule results (Atomic visibility, no queries) from previous frames
+				if (viewData.stable)
+				{
+					assert(viewData.visibility == Visibility::Atomic);
+					viewData.coherent = true;
+					viewMask &= ~(1u << viewIdx);
+					return;
+				}
+				viewState.parentInsideFrustum = true;
 			}
-		}
 
-		unsigned long int childrenCulledTris = 0;
-		bool childQueryCanceled = false;
+			// stability gets evaluated during children traverse
+			viewData.stable = false;
+
+			if (!viewState.parentInsideFrustum)
+			{
+				switch (views[viewIdx].frustumCuller.Cull(aabb, viewState.parentCullPlanes))
+				{
+				case CullResult::OUTSIDE:
+					viewData.visibility = Visibility::Culled;
+					results[viewIdx] = { GetInclusiveTriCount(), false };
+					viewMask &= ~(1u << viewIdx);
+					return;
+				case CullResult::INSIDE:
+					viewState.parentInsideFrustum = true;
+					break;
+				}
+			}
+
+			// children AABBs contained in this node's one => inherit coherence
+			if (view.coherence == View::Coherence::Rebuild && viewState.parentInsideFrustum)
+			{
+				if (!viewState.parentCoherent)
+					viewState.parentCoherent = views[viewIdx].frustumCuller.InsideMargin(aabb) >= view.coherenceMargin;
+				if (viewState.parentCoherent)
+					viewData.coherenceGeneration = view.coherenceGeneration;
+			}
+		});
 
-		const auto traverseChildren = [&]
+		if (!viewMask)
+			return results;
+
+		// carried from pre to post
+		struct
+		{
+			float aabbProjSquare;
+			bool scheduleOcclusionQuery, cancelQueryDueToParent;
+		} occlusionQueryStates[viewCount];
+
+		const auto traverseChildren = [&](unsigned int traverseMask)
 		{
 			if (childrenCount)
 			{
+				array<pair<unsigned long int, bool>, viewCount> childrenResults[extent_v<decltype(children)>];
 #if MULTITHREADED_TREE_TRAVERSE == 0 || MULTITHREADED_TREE_TRAVERSE == 2
-				for_each_n(
+				// gather into per child slots rather than accumulate from several threads
+				transform(
 #if MULTITHREADED_TREE_TRAVERSE
 					execution::par,
 #endif
-					cbegin(children),
-#if defined _MSC_VER && _MSC_VER <= 1923 && MULTITHREADED_TREE_TRAVERSE == 2
-					(unsigned int)
-#endif
-					childrenCount,
-					[&, depthSortXform, parentInsideFrustum, parentOcclusionCulledProjLength, parentOcclusion](const remove_extent_t<decltype(children)> &child)
+					cbegin(children), next(cbegin(children), childrenCount), childrenResults, [&views, traverseMask, &state](const remove_extent_t<decltype(children)> &child)
 				{
-					const auto childResult = child->Schedule<enableEarlyOut>(/*nodeHandler, */view, GPU_AABB_allocator, frustumCuller, frustumXform, depthSortXform, parentInsideFrustum, parentOcclusionCulledProjLength, parentOcclusion);
-					childrenCulledTris += childResult.first;
-					childQueryCanceled |= childResult.second;
+					return child->Schedule<enableEarlyOut>(views, traverseMask, state);
 				});
 #elif MULTITHREADED_TREE_TRAVERSE == 1
 				// consider using thread pool instead of async
-				future<pair<unsigned long int, bool>> childrenResults[extent_v<decltype(children)>];
+				future<remove_extent_t<decltype(childrenResults)>> childrenFutures[extent_v<decltype(children)>];
 				// launch
-				transform(next(cbegin(children)), next(cbegin(children), childrenCount), begin(childrenResults), [=, /*&nodeHandler, */&frustumCuller, &frustumXform](const remove_extent_t<decltype(children)> &child)
+				transform(next(cbegin(children)), next(cbegin(children), childrenCount), begin(childrenFutures), [&views, traverseMask, &state](const remove_extent_t<decltype(children)> &child)
 				{
-					return async(&Node::Schedule<enableEarlyOut>, child.get(), /*cref(nodeHandler), */ref(view), ref(GPU_AABB_allocator), cref(frustumCuller), cref(frustumXform), depthSortXform, parentInsideFrustum, parentOcclusionCulledProjLength, parentOcclusion);
+					return async(&Node::Schedule<enableEarlyOut, Allocator, viewCount>, child.get(), cref(views), traverseMask, state);
 				});
 
 				// traverse first child in this thread
-				tie(childrenCulledTris, childQueryCanceled) = children[0]->Schedule<enableEarlyOut>(/*nodeHandler, */GPU_AABB_allocator, frustumCuller, frustumXform, depthSortXform, parentInsideFrustum, parentOcclusionCulledProjLength, parentOcclusion);
+				childrenResults[0] = children[0]->Schedule<enableEarlyOut>(views, traverseMask, state);
 #else
 #error invalid MULTITHREADED_TREE_TRAVERSE value
 #endif
 
 				// sort if necessary
-				if (depthSortXform)
+				forEachView(traverseMask, [&](unsigned int viewIdx)
 				{
-					// xform AABB Z to view space
-					float viewSpaceZ[extent_v<decltype(children)>];
-					transform(cbegin(children), next(cbegin(children), childrenCount), viewSpaceZ, [depthSortXform](const remove_extent_t<decltype(children)> &child) -> float
+					if (const HLSL::float4x3 *const depthSortXform = views[viewIdx].depthSortXform)
 					{
+						auto &childrenOrder = views[viewIdx].view.nodes[idx].childrenOrder;
+
+						// xform AABB Z to view space
+						float viewSpaceZ[extent_v<decltype(children)>];
+						transform(cbegin(children), next(cbegin(children), childrenCount), viewSpaceZ, [depthSortXform](const remove_extent_t<decltype(children)> &child) -> float
+						{
 #if SORT_AABB_NEAR_Z
 
-						return TransformAABB(child->aabb, *depthSortXform).min.z;
+							return TransformAABB(child->aabb, *depthSortXform).min.z;
 #else
-						return mul(child->aabb.Center(), *depthSortXform).z;
+							return mul(child->aabb.Center(), *depthSortXform).z;
 #endif
-					});
+						});
 
-					// sort by view space Z
-					sort(begin(viewData.childrenOrder), next(begin(viewData.childrenOrder), childrenCount), [&viewSpaceZ](remove_extent_t<decltype(viewData.childrenOrder)> left, remove_extent_t<decltype(viewData.childrenOrder)> right) -> bool
-					{
-						return viewSpaceZ[left] < viewSpaceZ[right];
-					});
-				}
+						// sort by view space Z
+						sort(begin(childrenOrder), next(begin(childrenOrder), childrenCount), [&viewSpaceZ](remove_reference_t<decltype(childrenOrder[0])> left, remove_reference_t<decltype(childrenOrder[0])> right) -> bool
+						{
+							return viewSpaceZ[left] < viewSpaceZ[right];
+						});
+					}
+				});
 
 #if MULTITHREADED_TREE_TRAVERSE == 1
-				for_each_n(begin(childrenResults), childrenCount - 1, [&childrenCulledTris, &childQueryCanceled](remove_extent_t<decltype(childrenResults)> &childResult)
+				transform(begin(childrenFutures), next(begin(childrenFutures), childrenCount - 1), next(begin(childrenResults)), [](remove_extent_t<decltype(childrenFutures)> &childResult)
 				{
-					const auto resolvedResult = childResult.get();
-					childrenCulledTris += resolvedResult.first;
-					childQueryCanceled |= resolvedResult.second;
+					return childResult.get();
 				});
 #endif
+
+				forEachView(traverseMask, [&](unsigned int viewIdx)
+				{
+					auto &[childrenCulledTris, childQueryCanceled] = results[viewIdx];
+					for_each_n(cbegin(childrenResults), childrenCount, [&childrenCulledTris = childrenCulledTris, &childQueryCanceled = childQueryCanceled, viewIdx](const remove_extent_t<decltype(childrenResults)> &childResults)
+					{
+						childrenCulledTris += childResults[viewIdx].first;
+						childQueryCanceled |= childResults[viewIdx].second;
+					});
+				});
 			}
 
-			viewData.visibility = childrenCulledTris ? Visibility::Composite : Visibility::Atomic;
+			forEachView(traverseMask, [&](unsigned int viewIdx)
+			{
+				const View &view = views[viewIdx].view;
+				auto &viewData = view.nodes[idx];
+				viewData.visibility = results[viewIdx].first ? Visibility::Composite : Visibility::Atomic;
+				viewData.stable = all_of(cbegin(children), next(cbegin(children), childrenCount), [&view](const remove_extent_t<decltype(children)> &child)
+				{
+					return view.nodes[child->idx].stable;
+				});
+			});
 		};
 
 		if (OcclusionCulling::EarlyOut(GetInclusiveTriCount()))
 		{
+			unsigned int traverseMask = viewMask;
+
 			// parentInsideFrustum now relates to this node
-			if (enableEarlyOut && parentInsideFrustum)
-				viewData.visibility = Visibility::Atomic;
-			else
-				traverseChildren();
+			if constexpr (enableEarlyOut)
+			{
+				forEachView(viewMask, [&](unsigned int viewIdx)
+				{
+					if (state[viewIdx].parentInsideFrustum)
+					{
+						views[viewIdx].view.nodes[idx].visibility = Visibility::Atomic;
+						traverseMask &= ~(1u << viewIdx);
+					}
+				});
+			}
+
+			if (traverseMask)
+				traverseChildren(traverseMask);
 		}
 		else
 		{
 			// pre
-			const ClipSpaceAABB clipSpaceAABB(frustumXform, aabb);
-			const AABB<3> NDCSpaceAABB(clipSpaceAABB);
-			const HLSL::float2 aabbProjSize = NDCSpaceAABB.Size();
-			const float aabbProjSquare = aabbProjSize.x * aabbProjSize.y;
-			const float aabbProjLength = fmax(aabbProjSize.x, aabbProjSize.y);
-			// TODO: replace 'z >= 0 && w > 0' with 'w >= znear' and use 2D NDC space AABB
-			bool cancelQueryDueToParent = false, scheduleOcclusionQuery = NDCSpaceAABB.min.z >= 0.f && clipSpaceAABB.MinW() > 0.f && OcclusionCulling::QueryBenefit<false>(aabbProjSquare, GetInclusiveTriCount()) &&
-				!(cancelQueryDueToParent = (parentOcclusionCulledProjLength <= OcclusionCulling::nodeProjLengthThreshold || aabbProjLength / parentOcclusionCulledProjLength >= OcclusionCulling::nestedNodeProjLengthShrinkThreshold) && parentOcclusion < OcclusionCulling::parentOcclusionThreshold);
-			if (scheduleOcclusionQuery)
+			forEachView(viewMask, [&](unsigned int viewIdx)
 			{
-				parentOcclusionCulledProjLength = aabbProjLength;
-				parentOcclusion = GetOcclusion();
-			}
-			else
-				parentOcclusion += GetOcclusion() - parentOcclusion * GetOcclusion();
+				auto &[parentOcclusionCulledProjLength, parentOcclusion] = state[viewIdx].occlusion;
+				auto &[aabbProjSquare, scheduleOcclusionQuery, cancelQueryDueToParent] = occlusionQueryStates[viewIdx];
+
+				const ClipSpaceAABB clipSpaceAABB(views[viewIdx].frustumXform, aabb);
+				const AABB<3> NDCSpaceAABB(clipSpaceAABB);
+				const HLSL::float2 aabbProjSize = NDCSpaceAABB.Size();
+				aabbProjSquare = aabbProjSize.x * aabbProjSize.y;
+				const float aabbProjLength = fmax(aabbProjSize.x, aabbProjSize.y);
+				// TODO: replace 'z >= 0 && w > 0' with 'w >= znear' and use 2D NDC space AABB
+				cancelQueryDueToParent = false;
+				scheduleOcclusionQuery = NDCSpaceAABB.min.z >= 0.f && clipSpaceAABB.MinW() > 0.f && OcclusionCulling::QueryBenefit<false>(aabbProjSquare, GetInclusiveTriCount()) &&
+					!(cancelQueryDueToParent = (parentOcclusionCulledProjLength <= OcclusionCulling::nodeProjLengthThreshold || aabbProjLength / parentOcclusionCulledProjLength >= OcclusionCulling::nestedNodeProjLengthShrinkThreshold) && parentOcclusion < OcclusionCulling::parentOcclusionThreshold);
+				if (scheduleOcclusionQuery)
+				{
+					parentOcclusionCulledProjLength = aabbProjLength;
+					parentOcclusion = GetOcclusion();
+				}
+				else
+					parentOcclusion += GetOcclusion() - parentOcclusion * GetOcclusion();
+			});
 
-			traverseChildren();
+			traverseChildren(viewMask);
 
 			// post
-			assert(!(scheduleOcclusionQuery && cancelQueryDueToParent));
-			__assume(!(scheduleOcclusionQuery && cancelQueryDueToParent));
-			/*
-			scheduleOcclusionQuery == true (=> cancelQueryDueToParent == false)									|	reevaluate scheduleOcclusionQuery if childQueryCanceled == false, otherwise keep scheduled unconditionally
-			cancelQueryDueToParent == true (=> scheduleOcclusionQuery == false) && childQueryCanceled == false	|	reevaluate cancelQueryDueToParent and propagate it as childQueryCanceled
-			scheduleOcclusionQuery == false && childQueryCanceled == true										|	propagate childQueryCanceled == true unconditionally
-			*/
-			if (scheduleOcclusionQuery || cancelQueryDueToParent && !childQueryCanceled)
+			forEachView(viewMask, [&](unsigned int viewIdx)
 			{
-				const unsigned long int restTris = GetInclusiveTriCount() - childrenCulledTris;
-				bool queryNeeded = childQueryCanceled || OcclusionCulling::QueryBenefit<true>(aabbProjSquare, restTris);
-				if (queryNeeded)
+				View &view = views[viewIdx].view;
+				auto &viewData = view.nodes[idx];
+				auto &[childrenCulledTris, childQueryCanceled] = results[viewIdx];
+				const auto &[aabbProjSquare, scheduleOcclusionQuery, cancelQueryDueToParent] = occlusionQueryStates[viewIdx];
+
+				assert(!(scheduleOcclusionQuery && cancelQueryDueToParent));
+				__assume(!(scheduleOcclusionQuery && cancelQueryDueToParent));
+				/*
+				scheduleOcclusionQuery == true (=> cancelQueryDueToParent == false)									|	reevaluate scheduleOcclusionQuery if childQueryCanceled == false, otherwise keep scheduled unconditionally
+				cancelQueryDueToParent == true (=> scheduleOcclusionQuery == false) && childQueryCanceled == false	|	reevaluate cancelQueryDueToParent and propagate it as childQueryCanceled
+				scheduleOcclusionQuery == false && childQueryCanceled == true										|	propagate childQueryCanceled == true unconditionally
+				*/
+				if (scheduleOcclusionQuery || cancelQueryDueToParent && !childQueryCanceled)
 				{
-					const Node *boxes[OcclusionCulling::maxOcclusionQueryBoxes];
-					const unsigned long int exludedTris = CollectOcclusionQueryBoxes<enableEarlyOut>(view, begin(boxes), end(boxes)).first;
-					// reevaluate query benefit after excluding cheap objects during box collection
-					if (queryNeeded = childQueryCanceled || OcclusionCulling::QueryBenefit<true>(aabbProjSquare, restTris - exludedTris))
+					const unsigned long int restTris = GetInclusiveTriCount() - childrenCulledTris;
+					bool queryNeeded = childQueryCanceled || OcclusionCulling::QueryBenefit<true>(aabbProjSquare, restTris);
+					if (queryNeeded)
 					{
-						childQueryCanceled = cancelQueryDueToParent;	// propagate if 'cancelQueryDueToParent == true', reset to false otherwise (scheduleOcclusionQuery == true)
-						if (scheduleOcclusionQuery)
+						const Node *boxes[OcclusionCulling::maxOcclusionQueryBoxes];
+						const unsigned long int exludedTris = CollectOcclusionQueryBoxes<enableEarlyOut>(view, begin(boxes), end(boxes)).first;
+						// reevaluate query benefit after excluding cheap objects during box collection
+						if (queryNeeded = childQueryCanceled || OcclusionCulling::QueryBenefit<true>(aabbProjSquare, restTris - exludedTris))
 						{
-							childrenCulledTris = GetInclusiveTriCount();	// ' - exludedTris' ?
-							const auto boxesEnd = remove(begin(boxes), end(boxes), nullptr);
-							tie(viewData.occlusionQueryGeometry.VB, viewData.occlusionQueryGeometry.startIdx) = GPU_AABB_allocator.Allocate(viewData.occlusionQueryGeometry.count = distance(begin(boxes), boxesEnd));
-							// TODO: use persistent maps for release builds as optimization
-							CD3DX12_RANGE range(viewData.occlusionQueryGeometry.startIdx * sizeof aabb, viewData.occlusionQueryGeometry.startIdx * sizeof aabb);
-							// volatile requires corresponding overloads for AABB and vector math classes assignment
-							/*volatile*/ decltype(aabb) *VB_CPU_ptr;
-							CheckHR(viewData.occlusionQueryGeometry.VB->Map(0, &range, reinterpret_cast<void **>(/*const_cast<decltype(aabb) **>*/(&VB_CPU_ptr))));
-							transform(begin(boxes), boxesEnd, VB_CPU_ptr + viewData.occlusionQueryGeometry.startIdx, [](remove_extent_t<decltype(boxes)> box) noexcept { return box->aabb; });
-							range.End += viewData.occlusionQueryGeometry.count * sizeof aabb;
-							viewData.occlusionQueryGeometry.VB->Unmap(0, &range);	// exception safety (RAII) is not critical for Unmap as it used for tools and debug layer and Maps are ref-counted
+							childQueryCanceled = cancelQueryDueToParent;	// propagate if 'cancelQueryDueToParent == true', reset to false otherwise (scheduleOcclusionQuery == true)
+							if (scheduleOcclusionQuery)
+							{
+								childrenCulledTris = GetInclusiveTriCount();	// ' - exludedTris' ?
+								const auto boxesEnd = remove(begin(boxes), end(boxes), nullptr);
+								tie(viewData.occlusionQueryGeometry.VB, viewData.occlusionQueryGeometry.startIdx) = views[viewIdx].GPU_AABB_allocator.Allocate(viewData.occlusionQueryGeometry.count = distance(begin(boxes), boxesEnd));
+								// TODO: use persistent maps for release builds as optimization
+								CD3DX12_RANGE range(viewData.occlusionQueryGeometry.startIdx * sizeof aabb, viewData.occlusionQueryGeometry.startIdx * sizeof aabb);
+								// volatile requires corresponding overloads for AABB and vector math classes assignment
+								/*volatile*/ decltype(aabb) *VB_CPU_ptr;
+								CheckHR(viewData.occlusionQueryGeometry.VB->Map(0, &range, reinterpret_cast<void **>(/*const_cast<decltype(aabb) **>*/(&VB_CPU_ptr))));
+								transform(begin(boxes), boxesEnd, VB_CPU_ptr + viewData.occlusionQueryGeometry.startIdx, [](remove_extent_t<decltype(boxes)> box) noexcept { return box->aabb; });
+								range.End += viewData.occlusionQueryGeometry.count * sizeof aabb;
+								viewData.occlusionQueryGeometry.VB->Unmap(0, &range);	// exception safety (RAII) is not critical for Unmap as it used for tools and debug layer and Maps are ref-counted
+							}
 						}
 					}
 				}
-			}
+			});
 		}
 
-		return { childrenCulledTris, childQueryCanceled };
+		// fully visible subtree without queries can be skipped in subsequent frames in temporal coherence mode
+		forEachView(viewMask, [&](unsigned int viewIdx)
+		{
+			auto &viewData = views[viewIdx].view.nodes[idx];
+			viewData.stable &= !results[viewIdx].first && !results[viewIdx].second && !viewData.occlusionQueryGeometry;
+		});
+
+		return results;
 	}
 
 	// returns <exluded tris, accumulated AABB measure>
@@ -598,6 +701,14 @@ namespace Renderer::Impl::Hierarchy
 		std::remove_const_t<decltype(OcclusionCulling::QueryBatchBase::npos)> &fineOcclusion,
 		OcclusionCullDomain &occlusionCullDomainOverriden) const
 	{
+		// no enclosing query => whole subtree issued with the same (none) occlusion as its contiguous objects span
+		if (coherent && fineOcclusion == OcclusionCulling::QueryBatchBase::npos)
+		{
+			assert(coarseOcclusion == OcclusionCulling::QueryBatchBase::npos);
+			issueObjects(bvhNode, coarseOcclusion, fineOcclusion, visibility, true);
+			return false;
+		}
+
 		if (occlusionQueryGeometry)
 		{
 			occlusionCullDomainOverriden = occlusionCullDomain;
@@ -608,12 +719,12 @@ namespace Renderer::Impl::Hierarchy
 			OverrideOcclusionCullDomain(occlusionCullDomainOverriden);
 		if (occlusionCullDomainOverriden == OcclusionCullDomain::WholeNode)
 			coarseOcclusion = fineOcclusion;
-		return issueObjects(bvhNode, coarseOcclusion, fineOcclusion, GetVisibility(occlusionCullDomainOverriden));
+		return issueObjects(bvhNode, coarseOcclusion, fineOcclusion, GetVisibility(occlusionCullDomainOverriden), false);
 	}
 
 	template<TreeStructure treeStructure, class Object, class ...CustomNodeData>
-	View<treeStructure, Object, CustomNodeData...>::View(const BVH &bvh) :
-		bvh(&bvh), nodes(std::make_unique<Node []>(bvh.nodeCount))
+	View<treeStructure, Object, CustomNodeData...>::View(const BVH &bvh, bool temporalCoherence) :
+		bvh(&bvh), nodes(std::make_unique<Node []>(bvh.nodeCount)), temporalCoherence(temporalCoherence)
 	{}
 
 	template<TreeStructure treeStructure, class Object, class ...CustomNodeData>
@@ -632,12 +743,48 @@ namespace Renderer::Impl::Hierarchy
 		bvh->root->Traverse(nodeHandlerWrapper, reodredProvider, args...);
 	}
 
+	template<TreeStructure treeStructure, class Object, class ...CustomNodeData>
+	void View<treeStructure, Object, CustomNodeData...>::SetupCoherence(const Culler &frustumCuller)
+	{
+		using namespace std;
+
+		const auto &bounds = bvh->root->GetAABB();
+		if (!temporalCoherence)
+			coherence = Coherence::Off;
+		else if (coherenceFrustum && Culler::PlanesDelta(*coherenceFrustum, frustumCuller, bounds) < coherenceMargin)
+			coherence = Coherence::Reuse;
+		else
+		{
+			// new reference frustum, invalidates nodes marked for previous one
+			coherence = Coherence::Rebuild;
+			if (coherenceFrustum)
+				*coherenceFrustum = frustumCuller;
+			else
+				coherenceFrustum = make_shared<Culler>(frustumCuller);
+			coherenceMargin = frustumCuller.PlanesScale(bounds) * coherenceShrink;
+			coherenceGeneration++;
+		}
+	}
+
 	template<TreeStructure treeStructure, class Object, class ...CustomNodeData>
 	template<bool enableEarlyOut, class Allocator>
-	inline void View<treeStructure, Object, CustomNodeData...>::Schedule(Allocator &GPU_AABB_allocator, const FrustumCuller<decltype(std::declval<Object>().GetAABB().Center())::dimension> &frustumCuller, const HLSL::float4x4 &frustumXform, const HLSL::float4x3 *depthSortXform)
+	inline void View<treeStructure, Object, CustomNodeData...>::Schedule(Allocator &GPU_AABB_allocator, const Culler &frustumCuller, const HLSL::float4x4 &frustumXform, const HLSL::float4x3 *depthSortXform)
 	{
-		assert(nodes);
-		bvh->root->Schedule<enableEarlyOut>(*this, GPU_AABB_allocator, frustumCuller, frustumXform, depthSortXform);
+		const ViewScheduleDesc<View, Allocator> views[] = { { *this, GPU_AABB_allocator, frustumCuller, frustumXform, depthSortXform } };
+		Schedule<enableEarlyOut>(views);
+	}
+
+	template<TreeStructure treeStructure, class Object, class ...CustomNodeData>
+	template<bool enableEarlyOut, class Allocator, size_t viewCount>
+	void View<treeStructure, Object, CustomNodeData...>::Schedule(const ViewScheduleDesc<View, Allocator> (&views)[viewCount])
+	{
+		using namespace std;
+
+		static_assert(viewCount > 0 && viewCount <= numeric_limits<unsigned int>::digits, "view count exceeds view mask capacity");
+		assert(all_of(cbegin(views), cend(views), [bvh = views[0].view.bvh](const ViewScheduleDesc<View, Allocator> &desc) { return desc.view.nodes && desc.view.bvh == bvh; }));
+		for (const auto &desc : views)
+			desc.view.SetupCoherence(desc.frustumCuller);
+		views[0].view.bvh->root->Schedule<enableEarlyOut>(views, ~0u >> numeric_limits<unsigned int>::digits - viewCount, {});
 	}
 
 	template<TreeStructure treeStructure, class Object, class ...CustomNodeData>
@@ -655,6 +802,8 @@ namespace Renderer::Impl::Hierarchy
 	inline void View<treeStructure, Object, CustomNodeData...>::Reset()
 	{
 		nodes.reset();
+		coherenceFrustum.reset();
+		coherence = Coherence::Off;
 	}
 }
 
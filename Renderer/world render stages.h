@@ -9,6 +9,8 @@
 #include "render pipeline.h"
 #include "SO buffer.h"
 #include "occlusion query batch.h"
+#include "PSO library.h"
+#include "world view context.h"
 
 extern std::pmr::synchronized_pool_resource globalTransientRAM;
 
@@ -43,13 +45,14 @@ private:
 	const RenderPasses::StageZBinding stageZPrecullBinding, stageZBinding;
 	const RenderPasses::StageOutput stageOutput;
 	std::promise<std::shared_ptr<const OcclusionQueryPasses>> queryPassesPromise{ std::allocator_arg, std::pmr::polymorphic_allocator<decltype(queryPassesPromise)>(&globalTransientRAM) };
+	std::promise<std::pair<RenderStreamStateChanges, RenderStreamStateChanges>> stateChangesPromise;	// build result delivered to view context
 
 #pragma region occlusion query passes
 private:
 	static WRL::ComPtr<ID3D12RootSignature> xformAABB_rootSig, CreateXformAABB_RootSig();
-	static WRL::ComPtr<ID3D12PipelineState> xformAABB_PSO, CreateXformAABB_PSO();
+	static DeferredPSO xformAABB_PSO, CreateXformAABB_PSO();
 	static WRL::ComPtr<ID3D12RootSignature> cullPassRootSig, CreateCullPassRootSig();
-	static std::array<WRL::ComPtr<ID3D12PipelineState>, 2> cullPassPSOs, CreateCullPassPSOs();
+	static std::array<DeferredPSO, 2> cullPassPSOs, CreateCullPassPSOs();
 
 private:
 	const std::shared_ptr<OcclusionQueryPasses> queryPasses;
@@ -64,24 +67,47 @@ private:
 	inline void UpdateCullPassCache();
 #pragma endregion
 
+#pragma region GPU culling
+private:
+	// replaces occlusion query and main passes if set
+	const std::shared_ptr<const GPUCulling::Scene> GPUCullingScene;
+	HLSL::float4x4 GPUCullXform;
+
+private:
+	void GPUCullPass(CmdListPool::CmdList &target) const, GPUSecondCullPass(CmdListPool::CmdList &target) const;
+	void GPUMainPassRange(CmdListPool::CmdList &target, unsigned long rangeBegin, unsigned long rangeEnd, const RenderPasses::RenderPass &renderPass) const;
+#pragma endregion
+
 #pragma region main passes
 private:
 	struct RenderData
 	{
 		const Renderer::Instance *instance;
 		decltype(OcclusionCulling::QueryBatchBase::npos) occlusion;
+		unsigned int instanceCount = 1;			// > 1 for merged group headed by 'instance'
+		D3D12_GPU_VIRTUAL_ADDRESS instancesCB{};	// group xforms, instance own CB used for single instance
 	};
 	std::pmr::vector<RenderData> renderStreams[2]{ std::remove_extent_t<decltype(renderStreams)>{&globalTransientRAM}, std::remove_extent_t<decltype(renderStreams)>{&globalTransientRAM} };
 
+private:
+	// keep in sync with 'instanceXforms' array in object3DFlat_VS.hlsl (float4x3 occupies 4 CB registers)
+	static constexpr unsigned int maxInstancesPerDraw = D3D12_REQ_CONSTANT_BUFFER_ELEMENT_COUNT / 4, xformsPerInstancesCBSlot = D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT / (sizeof(float[4]) * 4);
+	static constexpr const WCHAR instancesCB_name[] = L"3D objects instances xforms";
+	static std::optional<GPUStreamBuffer::Allocator<D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT, instancesCB_name>> instancesCB_allocator;
+
 private:
 	void MainPassPre(CmdListPool::CmdList &target) const, MainPassPost(CmdListPool::CmdList &target) const;
 	void MainPassRange(CmdListPool::CmdList &target, unsigned long rangeBegin, unsigned long rangeEnd, const RenderPasses::RenderPass &renderPass, bool final) const;
 
 private:
 	inline void SetupMainPass();
-	void IssueObjects(const decltype(bvh)::Node &node, decltype(OcclusionCulling::QueryBatchBase::npos) occlusion);
-	bool IssueNodeObjects(const decltype(bvh)::Node &node, decltype(OcclusionCulling::QueryBatchBase::npos) occlusion, decltype(OcclusionCulling::QueryBatchBase::npos), decltype(bvhView)::Node::Visibility visibility);
+	void IssueObjects(const decltype(bvh)::Node &node, decltype(OcclusionCulling::QueryBatchBase::npos) occlusion, bool subtree);
+	bool IssueNodeObjects(const decltype(bvh)::Node &node, decltype(OcclusionCulling::QueryBatchBase::npos) occlusion, decltype(OcclusionCulling::QueryBatchBase::npos), decltype(bvhView)::Node::Visibility visibility, bool subtree);
 	inline void UpdateMainPassCache();
+	static void MergeInstances(std::remove_extent_t<decltype(renderStreams)> &renderStream);
+	static RenderStreamStateChanges CountStateChanges(const std::remove_extent_t<decltype(renderStreams)> &renderStream) noexcept;
+	static void SortRenderStream(std::remove_extent_t<decltype(renderStreams)> &renderStream);
+	std::pair<RenderStreamStateChanges, RenderStreamStateChanges> SortRenderStreams();
 #pragma endregion
 
 private:
@@ -99,7 +125,8 @@ private:
 		GetFirstCullPassRange(unsigned int &length) const, GetSecondCullPassRange(unsigned int &length) const,
 		GetFirstMainPassRange(unsigned int &length) const, GetSecondMainPassRange(unsigned int &length) const,
 		GetXformAABBPass2FirstCullPass(unsigned int &length) const, GetFirstCullPass2FirstMainPass(unsigned int &length) const, GetFirstMainPass2SecondCullPass(unsigned int &length) const, GetSecondCullPass2SecondMainPass(unsigned int &length) const,
-		GetMainPassPre(unsigned int &length) const, GetMainPassRange(unsigned int &length) const, GetMainPassPost(unsigned int &length) const;
+		GetMainPassPre(unsigned int &length) const, GetMainPassRange(unsigned int &length) const, GetMainPassPost(unsigned int &length) const,
+		GetGPUFirstMainPassRange(unsigned int &length) const, GetGPUFirstMainPass2SecondCullPass(unsigned int &length) const, GetGPUSecondMainPassRange(unsigned int &length) const;
 
 private:
 	inline void Setup(), SetupOcclusionQueryBatch(decltype(OcclusionCulling::QueryBatchBase::npos) maxOcclusion);
@@ -138,7 +165,7 @@ private:
 #pragma region visualize occlusion pass
 private:
 	static WRL::ComPtr<ID3D12RootSignature> AABB_rootSig, CreateAABB_RootSig();
-	static std::array<WRL::ComPtr<ID3D12PipelineState>, 2> AABB_PSOs, CreateAABB_PSOs();
+	static std::array<DeferredPSO, 2> AABB_PSOs, CreateAABB_PSOs();
 
 private:
 	std::shared_ptr<const OcclusionQueryPasses> queryPasses;
@@ -1,14 +1,22 @@
 #pragma once
 
+#include <utility>
+#include <future>
 #include "../tracked resource.h"
 
 struct ID3D12Resource;
 
 namespace Renderer::Impl
 {
+	struct RenderStreamStateChanges
+	{
+		unsigned long int PSO, material, occlusion;
+	};
+
 	struct WorldViewContext
 	{
 		friend class World;
+		friend class Viewport;
 
 	private:
 		/*
@@ -17,5 +25,6 @@ namespace Renderer::Impl
 		*/
 		TrackedResource<ID3D12Resource> ZBufferHistory;	// from previous frame
 		unsigned long ZBufferHistoryVersion = 0;
+		std::shared_future<std::pair<RenderStreamStateChanges, RenderStreamStateChanges>> renderStreamsStateChanges;	// unsorted/sorted, fulfilled by main render stage build
 	};
 }
\ No newline at end of file
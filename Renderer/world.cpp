@@ -19,9 +19,12 @@
 #include "sun.h"
 #include "world view context.h"
 #include "frustum culling.h"
+#include "GPU culling.h"
+#include "memory accounting.h"
 #include "frame versioning.h"
 #include "global GPU buffer data.h"
 #include "static objects data.h"
+#include "DMA engine.h"
 #include "shader bytecode.h"
 #include "config.h"
 
@@ -58,7 +61,7 @@ ComPtr<ID3D12RootSignature> Impl::World::MainRenderStage::CreateXformAABB_RootSi
 	return CreateRootSignature(*rootSigProvider->GetUnconvertedRootSignatureDesc(), L"Xform 3D AABB root signature");
 }
 
-ComPtr<ID3D12PipelineState> Impl::World::MainRenderStage::CreateXformAABB_PSO()
+Impl::DeferredPSO Impl::World::MainRenderStage::CreateXformAABB_PSO()
 {
 	const D3D12_INPUT_ELEMENT_DESC VB_decl[] =
 	{
@@ -98,10 +101,7 @@ ComPtr<ID3D12PipelineState> Impl::World::MainRenderStage::CreateXformAABB_PSO()
 		.Flags					= D3D12_PIPELINE_STATE_FLAG_NONE
 	};
 
-	ComPtr<ID3D12PipelineState> result;
-	CheckHR(device->CreateGraphicsPipelineState(&PSO_desc, IID_PPV_ARGS(result.GetAddressOf())));
-	NameObject(result.Get(), L"Xform 3D AABB PSO");
-	return result;
+	return globalPSOLibrary->Compile(PSO_desc, L"Xform 3D AABB PSO");
 }
 
 ComPtr<ID3D12RootSignature> Impl::World::MainRenderStage::CreateCullPassRootSig()
@@ -201,13 +201,11 @@ auto Impl::World::MainRenderStage::CreateCullPassPSOs() -> decltype(cullPassPSOs
 
 	decltype(cullPassPSOs) result;
 	
-	CheckHR(device->CreateGraphicsPipelineState(&PSO_desc, IID_PPV_ARGS(result[0].GetAddressOf())));
-	NameObject(result[0].Get(), L"world objects first occlusion query pass PSO");
+	result[0] = globalPSOLibrary->Compile(PSO_desc, L"world objects first occlusion query pass PSO");
 
 	PSO_desc.DepthStencilState = dsDescs[1];
 
-	CheckHR(device->CreateGraphicsPipelineState(&PSO_desc, IID_PPV_ARGS(result[1].GetAddressOf())));
-	NameObject(result[1].Get(), L"world objects second occlusion query pass PSO");
+	result[1] = globalPSOLibrary->Compile(PSO_desc, L"world objects second occlusion query pass PSO");
 
 	return result;
 }
@@ -312,6 +310,110 @@ void Impl::World::MainRenderStage::UpdateCullPassCache()
 }
 #pragma endregion impl
 
+#pragma region GPU culling
+void Impl::World::MainRenderStage::GPUCullPass(CmdListPool::CmdList &cmdList) const
+{
+	// specify NULL to reset possible predication
+	cmdList.Setup(NULL);
+
+	// Z history transitions mirror 'StagePre()' so that 'StagePost()' finds it in expected state
+	ID3D12Resource *ZBufferHistory = NULL;
+	if (viewCtx.ZBufferHistory)
+	{
+		if (const auto targetZDesc = stageZBinding.GetZBuffer()->GetDesc(), historyZDesc = viewCtx.ZBufferHistory->GetDesc(); targetZDesc.Width == historyZDesc.Width && targetZDesc.Height == historyZDesc.Height)
+		{
+			ZBufferHistory = viewCtx.ZBufferHistory.Get();
+			cmdList.ResourceBarrier(CD3DX12_RESOURCE_BARRIER::Transition(ZBufferHistory, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES, D3D12_RESOURCE_BARRIER_FLAG_END_ONLY));
+			cmdList.FlushBarriers<true>();
+			cmdList.ResourceBarrier(CD3DX12_RESOURCE_BARRIER::Transition(ZBufferHistory, D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE));
+			cmdList.FlushBarriers<true>();
+		}
+	}
+
+	GPUCullingScene->Cull(cmdList, GPUCullXform, ZBufferHistory, false);
+
+	if (ZBufferHistory)
+	{
+		cmdList.ResourceBarrier(CD3DX12_RESOURCE_BARRIER::Transition(ZBufferHistory, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_COPY_SOURCE));
+		cmdList.FlushBarriers<true>();
+		cmdList.ResourceBarrier(CD3DX12_RESOURCE_BARRIER::Transition(ZBufferHistory, D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES, D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY));
+	}
+
+	// before main pass "action"
+	cmdList.FlushBarriers();
+}
+
+void Impl::World::MainRenderStage::GPUSecondCullPass(CmdListPool::CmdList &cmdList) const
+{
+	// specify NULL to reset possible predication
+	cmdList.Setup(NULL);
+
+	/*
+		Z history (if compatible) reused as scratch for current Z copy, 'StagePost()' overwrites it anyway
+		transitions leave it in the same state as 'GPUCullPass()' did
+		no Z history => 1st phase did no occlusion culling => nothing to retest, dispatch still needed to reset counters
+	*/
+	ID3D12Resource *ZBufferCopy = NULL;
+	if (viewCtx.ZBufferHistory)
+	{
+		if (const auto targetZDesc = stageZBinding.GetZBuffer()->GetDesc(), historyZDesc = viewCtx.ZBufferHistory->GetDesc(); targetZDesc.Width == historyZDesc.Width && targetZDesc.Height == historyZDesc.Height)
+		{
+			ZBufferCopy = viewCtx.ZBufferHistory.Get();
+			{
+				initializer_list<D3D12_RESOURCE_BARRIER> barriers
+				{
+					CD3DX12_RESOURCE_BARRIER::Transition(stageZBinding.GetZBuffer(), D3D12_RESOURCE_STATE_DEPTH_WRITE, D3D12_RESOURCE_STATE_COPY_SOURCE),
+					CD3DX12_RESOURCE_BARRIER::Transition(ZBufferCopy, D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES, D3D12_RESOURCE_BARRIER_FLAG_END_ONLY)
+				};
+				cmdList.ResourceBarrier(barriers);
+				cmdList.FlushBarriers<true>();
+			}
+			cmdList->CopyResource(ZBufferCopy, stageZBinding.GetZBuffer());
+			{
+				initializer_list<D3D12_RESOURCE_BARRIER> barriers
+				{
+					CD3DX12_RESOURCE_BARRIER::Transition(stageZBinding.GetZBuffer(), D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_STATE_DEPTH_WRITE),
+					CD3DX12_RESOURCE_BARRIER::Transition(ZBufferCopy, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE)
+				};
+				cmdList.ResourceBarrier(barriers);
+				cmdList.FlushBarriers<true>();
+			}
+		}
+	}
+
+	GPUCullingScene->Cull(cmdList, GPUCullXform, ZBufferCopy, true);
+
+	if (ZBufferCopy)
+	{
+		cmdList.ResourceBarrier(CD3DX12_RESOURCE_BARRIER::Transition(ZBufferCopy, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_COPY_SOURCE));
+		cmdList.FlushBarriers<true>();
+		cmdList.ResourceBarrier(CD3DX12_RESOURCE_BARRIER::Transition(ZBufferCopy, D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES, D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY));
+	}
+
+	// before main pass "action"
+	cmdList.FlushBarriers();
+}
+
+void Impl::World::MainRenderStage::GPUMainPassRange(CmdListPool::CmdList &cmdList, unsigned long rangeBegin, unsigned long rangeEnd, const RenderPasses::RenderPass &renderPass) const
+{
+	assert(rangeBegin < rangeEnd);
+
+	const auto &buckets = GPUCullingScene->GetBuckets();
+
+	cmdList.Setup(buckets[rangeBegin].instance->GetStartPSO());
+
+	decltype(parent->staticObjects)::value_type::Setup(cmdList, GetCurFrameGPUDataPtr(), tonemapParamsGPUAddress);
+
+	RenderPasses::RenderPassScope renderPassScope(cmdList, renderPass);
+
+	// draw counts produced by 'GPUCullPass()' / 'GPUSecondCullPass()'
+	for_each(next(buckets.cbegin(), rangeBegin), next(buckets.cbegin(), rangeEnd), [&](const GPUCulling::Scene::Bucket &bucket)
+	{
+		bucket.instance->RenderIndirect(cmdList, bucket.maxInstanceCount, GPUCullingScene->GetArgs(), bucket.argsOffset, GPUCullingScene->GetCounters(), bucket.countersOffset);
+	});
+}
+#pragma endregion
+
 #pragma region main passes
 //void Impl::World::MainRenderStage::MainPassPre(CmdListPool::CmdList &cmdList) const
 //{
@@ -343,7 +445,10 @@ void Impl::World::MainRenderStage::MainPassRange(CmdListPool::CmdList &cmdList,
 			else
 				get<OcclusionCulling::QueryBatch<OcclusionCulling::DUAL>>(queryPasses->occlusionQueryBatch).Set(cmdList, curOcclusionQueryIdx, final);
 		}
-		renderData.instance->Render(cmdList);
+		if (renderData.instanceCount > 1)
+			renderData.instance->Render(cmdList, renderData.instancesCB, renderData.instanceCount);
+		else
+			renderData.instance->Render(cmdList);
 	});
 }
 
@@ -354,9 +459,9 @@ void Impl::World::MainRenderStage::SetupMainPass()
 }
 
 // 1 call site
-inline void Impl::World::MainRenderStage::IssueObjects(const decltype(bvh)::Node &node, decltype(OcclusionCulling::QueryBatchBase::npos) occlusion)
+inline void Impl::World::MainRenderStage::IssueObjects(const decltype(bvh)::Node &node, decltype(OcclusionCulling::QueryBatchBase::npos) occlusion, bool subtree)
 {
-	const auto issue2stream = [range = node.GetExclusiveObjectsRange(), occlusion](remove_extent_t<decltype(renderStreams)> &renderStream)
+	const auto issue2stream = [range = subtree ? node.GetInclusiveObjectsRange() : node.GetExclusiveObjectsRange(), occlusion](remove_extent_t<decltype(renderStreams)> &renderStream)
 	{
 		transform(range.first, range.second, back_inserter(renderStream), [occlusion](const Renderer::Instance *instance) noexcept -> typename/*MSVC 1921/1922*/ remove_reference_t<decltype(renderStream)>::value_type { return { instance, occlusion }; });
 	};
@@ -368,12 +473,13 @@ inline void Impl::World::MainRenderStage::IssueObjects(const decltype(bvh)::Node
 		issue2stream(renderStreams[1]);
 }
 
-bool Impl::World::MainRenderStage::IssueNodeObjects(const decltype(bvh)::Node &node, decltype(OcclusionCulling::QueryBatchBase::npos) occlusion, decltype(OcclusionCulling::QueryBatchBase::npos), decltype(bvhView)::Node::Visibility visibility)
+// 'subtree' - coherent subtree issued at once from its objects span, no need to traverse further
+bool Impl::World::MainRenderStage::IssueNodeObjects(const decltype(bvh)::Node &node, decltype(OcclusionCulling::QueryBatchBase::npos) occlusion, decltype(OcclusionCulling::QueryBatchBase::npos), decltype(bvhView)::Node::Visibility visibility, bool subtree)
 {
 	if (visibility != decltype(visibility)::Culled)
 	{
-		IssueObjects(node, occlusion);
-		return true;
+		IssueObjects(node, occlusion, subtree);
+		return !subtree;
 	}
 	return false;
 }
@@ -383,6 +489,183 @@ void Impl::World::MainRenderStage::UpdateMainPassCache()
 	for (unsigned i = 0; i < size(parent->renderStreamsLenCache); i++)
 		parent->renderStreamsLenCache[i] = max(parent->renderStreamsLenCache[i], renderStreams[i].size());
 }
+
+/*
+	collapses instances of the same object into single instanced draw
+	merging is limited to runs of consecutive objects sharing occlusion query as predication is applied per draw
+	groups are placed at the location of their 1st instance so that front-to-back order within run is roughly preserved
+	group xforms are packed into per-frame instances CB, single instance groups keep using own static CB
+*/
+void Impl::World::MainRenderStage::MergeInstances(remove_extent_t<decltype(renderStreams)> &renderStream)
+{
+	typedef CBRegister::AlignedRow<3> Xform[4];
+	static_assert(sizeof(Xform) * xformsPerInstancesCBSlot == D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT);
+
+	struct Group
+	{
+		RenderData head;
+		unsigned long int xformsCursor = 0;	// in instances CB
+	};
+	pmr::vector<Group> groups(&globalTransientRAM);
+	pmr::vector<unsigned long int> entryGroups(&globalTransientRAM);
+	pmr::unordered_map<const void *, unsigned long int> runGroups(&globalTransientRAM);
+	entryGroups.reserve(renderStream.size());
+
+	// assign entries to groups
+	for (auto entry = renderStream.cbegin(); entry != renderStream.cend(); ++entry)
+	{
+		if (entry != renderStream.cbegin() && entry->occlusion != prev(entry)->occlusion)
+			runGroups.clear();
+		const auto [runGroup, inserted] = runGroups.try_emplace(entry->instance->GetGeometryID(), groups.size());
+		auto &group = inserted ? groups.emplace_back(Group{ *entry }) : groups[runGroup->second];
+		if (!inserted)
+			group.head.instanceCount++;
+		entryGroups.push_back(runGroup->second);
+		if (group.head.instanceCount == maxInstancesPerDraw)
+			runGroups.erase(runGroup);	// full, start new group on next occurrence
+	}
+
+	if (groups.size() == renderStream.size())
+		return;
+
+	// allocate instances CB space for multi-instance groups (each group starts at CB placement boundary)
+	unsigned long int instancesCBSlots = 0;
+	for (auto &group : groups)
+		if (group.head.instanceCount > 1)
+		{
+			group.xformsCursor = instancesCBSlots * xformsPerInstancesCBSlot;
+			instancesCBSlots += (group.head.instanceCount + xformsPerInstancesCBSlot - 1) / xformsPerInstancesCBSlot;
+		}
+	const auto [instancesCB, instancesCBStartSlot] = instancesCB_allocator->Allocate(instancesCBSlots);
+
+	// fill xforms
+	{
+		CD3DX12_RANGE range(instancesCBStartSlot * D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT, instancesCBStartSlot * D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT);
+		volatile Xform *mapped;
+		CheckHR(instancesCB->Map(0, &range, const_cast<void **>(reinterpret_cast<volatile void **>(&mapped))));
+		mapped += instancesCBStartSlot * xformsPerInstancesCBSlot;
+		for (auto entryGroup = entryGroups.cbegin(); const auto &entry : renderStream)
+			if (auto &group = groups[*entryGroup++]; group.head.instanceCount > 1)
+				copy_n(entry.instance->GetWorldXform(), size(entry.instance->GetWorldXform()), mapped[group.xformsCursor++]);
+		range.End += instancesCBSlots * D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT;
+		instancesCB->Unmap(0, &range);
+	}
+
+	// replace stream with groups, cursors point past group xforms now
+	const auto instancesCB_GPU_ptr = instancesCB->GetGPUVirtualAddress() + instancesCBStartSlot * D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT;
+	renderStream.clear();
+	for (const auto &group : groups)
+	{
+		auto &merged = renderStream.emplace_back(group.head);
+		if (merged.instanceCount > 1)
+			merged.instancesCB = instancesCB_GPU_ptr + (group.xformsCursor - merged.instanceCount) * sizeof(Xform);
+	}
+}
+
+auto Impl::World::MainRenderStage::CountStateChanges(const remove_extent_t<decltype(renderStreams)> &renderStream) noexcept -> RenderStreamStateChanges
+{
+	RenderStreamStateChanges changes{};
+	for (auto cur = renderStream.cbegin(); cur != renderStream.cend() && next(cur) != renderStream.cend(); ++cur)
+	{
+		const auto &left = *cur, &right = *next(cur);
+		changes.PSO += left.instance->GetStartPSO() != right.instance->GetStartPSO();
+		changes.material += left.instance->GetGeometryID() != right.instance->GetGeometryID();
+		changes.occlusion += left.occlusion != right.occlusion;
+	}
+	return changes;
+}
+
+/*
+	stable LSD radix sort by (occlusion run, start PSO, material) key
+	occlusion run is the most significant part => predication grouping and front-to-back order between runs preserved
+	stability keeps issue order (front-to-back from BVH traversal) for equal keys which serves as depth part of the key
+	root signature is shared by all 3D objects and does not participate in key
+	PSOs and materials (descriptor tables and CBs are owned by object) replaced by dense ranks to keep key short
+*/
+void Impl::World::MainRenderStage::SortRenderStream(remove_extent_t<decltype(renderStreams)> &renderStream)
+{
+	if (renderStream.size() < 2)
+		return;
+
+	const auto MakeRanks = [&renderStream](auto getKey)
+	{
+		pmr::vector<const void *> ranks(&globalTransientRAM);
+		ranks.reserve(renderStream.size());
+		transform(renderStream.cbegin(), renderStream.cend(), back_inserter(ranks), getKey);
+		sort(ranks.begin(), ranks.end());
+		ranks.erase(unique(ranks.begin(), ranks.end()), ranks.end());
+		return ranks;
+	};
+	const auto RankOf = [](const pmr::vector<const void *> &ranks, const void *key) noexcept
+	{
+		return UINT64(distance(ranks.cbegin(), lower_bound(ranks.cbegin(), ranks.cend(), key)));
+	};
+	const auto PSOs = MakeRanks([](const RenderData &renderData) noexcept -> const void * { return renderData.instance->GetStartPSO(); });
+	const auto materials = MakeRanks([](const RenderData &renderData) noexcept { return renderData.instance->GetGeometryID(); });
+	const unsigned int PSOBits = bit_width(PSOs.size() - 1), materialBits = bit_width(materials.size() - 1);
+	if (!(PSOBits | materialBits))
+		return;
+
+	// build keys
+	pmr::vector<UINT64> keys(&globalTransientRAM), keysTemp(renderStream.size(), &globalTransientRAM);
+	pmr::vector<unsigned long int> order(renderStream.size(), &globalTransientRAM), orderTemp(renderStream.size(), &globalTransientRAM);
+	keys.reserve(renderStream.size());
+	UINT64 run = 0;
+	for (auto entry = renderStream.cbegin(); entry != renderStream.cend(); ++entry)
+	{
+		if (entry != renderStream.cbegin() && entry->occlusion != prev(entry)->occlusion)
+			run++;
+		keys.push_back(run << (PSOBits + materialBits) | RankOf(PSOs, entry->instance->GetStartPSO()) << materialBits | RankOf(materials, entry->instance->GetGeometryID()));
+	}
+	iota(order.begin(), order.end(), 0ul);
+
+	// sort, 8 bit digits, skip passes where all keys share the same digit
+	const unsigned int keyBits = bit_width(run) + PSOBits + materialBits;
+	assert(keyBits <= numeric_limits<UINT64>::digits);
+	for (unsigned int shift = 0; shift < keyBits; shift += 8)
+	{
+		array<unsigned long int, 256> offsets{};
+		for (const auto key : keys)
+			offsets[key >> shift & 0xffu]++;
+		if (find(offsets.cbegin(), offsets.cend(), keys.size()) != offsets.cend())
+			continue;
+		exclusive_scan(offsets.cbegin(), offsets.cend(), offsets.begin(), 0ul);
+		for (size_t i = 0; i < keys.size(); i++)
+		{
+			const auto dst = offsets[keys[i] >> shift & 0xffu]++;
+			keysTemp[dst] = keys[i];
+			orderTemp[dst] = order[i];
+		}
+		keys.swap(keysTemp);
+		order.swap(orderTemp);
+	}
+
+	// permute
+	remove_reference_t<decltype(renderStream)> sorted(&globalTransientRAM);
+	sorted.reserve(renderStream.size());
+	transform(order.cbegin(), order.cend(), back_inserter(sorted), [&renderStream](unsigned long int idx) noexcept { return renderStream[idx]; });
+	renderStream.swap(sorted);
+}
+
+auto Impl::World::MainRenderStage::SortRenderStreams() -> pair<RenderStreamStateChanges, RenderStreamStateChanges>
+{
+	const auto Accumulate = [](RenderStreamStateChanges &dst, const RenderStreamStateChanges &src) noexcept
+	{
+		dst.PSO += src.PSO;
+		dst.material += src.material;
+		dst.occlusion += src.occlusion;
+	};
+
+	RenderStreamStateChanges unsorted{}, sorted{};
+	for (auto &renderStream : renderStreams)
+	{
+		Accumulate(unsorted, CountStateChanges(renderStream));
+		SortRenderStream(renderStream);
+		Accumulate(sorted, CountStateChanges(renderStream));
+	}
+	return { unsorted, sorted };
+}
+
 #pragma endregion impl
 
 void Impl::World::MainRenderStage::StagePre(CmdListPool::CmdList &cmdList) const
@@ -478,15 +761,21 @@ void Impl::World::MainRenderStage::StagePost(CmdListPool::CmdList &cmdList) cons
 		cmdList.ResourceBarrier(CD3DX12_RESOURCE_BARRIER::Transition(viewCtx.ZBufferHistory.Get(), D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES, D3D12_RESOURCE_BARRIER_FLAG_END_ONLY));
 	else
 	{
+		// typeless to be readable by GPU culling
+		static_assert(Config::ZFormat == DXGI_FORMAT_D24_UNORM_S8_UINT);
+		auto historyZDesc = targetZDesc;
+		historyZDesc.Format = DXGI_FORMAT_R24G8_TYPELESS;
+		historyZDesc.Flags &= ~D3D12_RESOURCE_FLAG_DENY_SHADER_RESOURCE;
 		CheckHR(device->CreateCommittedResource(
 			&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
 			D3D12_HEAP_FLAG_NONE,
-			&targetZDesc,
+			&historyZDesc,
 			D3D12_RESOURCE_STATE_COPY_DEST,
 			NULL,
 			IID_PPV_ARGS(viewCtx.ZBufferHistory.ReleaseAndGetAddressOf())
 		));
 		NameObjectF(viewCtx.ZBufferHistory.Get(), L"Z buffer history (world view context %p) [%lu]", &viewCtx, viewCtx.ZBufferHistoryVersion++);
+		MemoryAccounting::Track(viewCtx.ZBufferHistory.Get(), MemoryAccounting::Category::RenderTargets);
 	}
 
 	cmdList.FlushBarriers<true>();
@@ -514,6 +803,11 @@ Impl::RenderPipeline::PipelineItem (Impl::RenderPipeline::IRenderStage::*Impl::W
 auto Impl::World::MainRenderStage::GetStagePre(unsigned int &) const -> RenderPipeline::PipelineItem
 {
 	using namespace placeholders;
+	if (GPUCullingScene)
+	{
+		phaseSelector = static_cast<decltype(phaseSelector)>(&MainRenderStage::GetGPUFirstMainPassRange);
+		return RenderPipeline::PipelineItem{ bind(&MainRenderStage::GPUCullPass, shared_from_this(), _1) };
+	}
 	phaseSelector = static_cast<decltype(phaseSelector)>(&MainRenderStage::GetXformAABBPassRange);
 	return RenderPipeline::PipelineItem{ bind(&MainRenderStage::StagePre, shared_from_this(), _1) };
 }
@@ -521,7 +815,7 @@ auto Impl::World::MainRenderStage::GetStagePre(unsigned int &) const -> RenderPi
 auto Impl::World::MainRenderStage::GetXformAABBPassRange(unsigned int &length) const -> RenderPipeline::PipelineItem
 {
 	using namespace placeholders;
-	return IterateRenderPass(length, queryPasses->queryStream.size(), [] { phaseSelector = static_cast<decltype(phaseSelector)>(&MainRenderStage::GetXformAABBPass2FirstCullPass); },
+	return IterateRenderPass(length, queryPasses->queryStream.size(), [this] { phaseSelector = static_cast<decltype(phaseSelector)>(&MainRenderStage::GetXformAABBPass2FirstCullPass); },
 		[this](unsigned long rangeBegin, unsigned long rangeEnd) { return bind(&MainRenderStage::XformAABBPassRange, shared_from_this(), _1, rangeBegin, rangeEnd); });
 }
 
@@ -536,7 +830,7 @@ auto Impl::World::MainRenderStage::GetFirstCullPassRange(unsigned int &length) c
 {
 	using namespace placeholders;
 	return IterateRenderPass(length, queryPasses->queryStream.size(), nullptr, { stageZPrecullBinding, true, true }, stageOutput,
-		[] { phaseSelector = static_cast<decltype(phaseSelector)>(&MainRenderStage::GetFirstCullPass2FirstMainPass); },
+		[this] { phaseSelector = static_cast<decltype(phaseSelector)>(&MainRenderStage::GetFirstCullPass2FirstMainPass); },
 		[this](unsigned long rangeBegin, unsigned long rangeEnd, const RenderPasses::RenderPass &renderPass) { return bind(&MainRenderStage::CullPassRange, shared_from_this(), _1, rangeBegin, rangeEnd, move(renderPass), false); });
 }
 
@@ -552,7 +846,7 @@ auto Impl::World::MainRenderStage::GetFirstMainPassRange(unsigned int &length) c
 	using namespace placeholders;
 	RenderPasses::PassROPBinding<RenderPasses::StageRTBinding> RTBinding{ stageRTBinding, true, false };
 	return IterateRenderPass(length, renderStreams[0].size(), &RTBinding, { stageZBinding, true, false }, stageOutput,
-		[] { phaseSelector = static_cast<decltype(phaseSelector)>(&MainRenderStage::/*GetFirstMainPass2SecondCullPass*/GetSecondCullPassRange); },
+		[this] { phaseSelector = static_cast<decltype(phaseSelector)>(&MainRenderStage::/*GetFirstMainPass2SecondCullPass*/GetSecondCullPassRange); },
 		[this](unsigned long rangeBegin, unsigned long rangeEnd, const RenderPasses::RenderPass &renderPass) { return bind(&MainRenderStage::MainPassRange, shared_from_this(), _1, rangeBegin, rangeEnd, move(renderPass), false); });
 }
 
@@ -567,7 +861,7 @@ auto Impl::World::MainRenderStage::GetSecondCullPassRange(unsigned int &length)
 {
 	using namespace placeholders;
 	return IterateRenderPass(length, queryPasses->queryStream.size(), nullptr, { stageZBinding, false, false }, stageOutput,
-		[] { phaseSelector = static_cast<decltype(phaseSelector)>(&MainRenderStage::GetSecondCullPass2SecondMainPass); },
+		[this] { phaseSelector = static_cast<decltype(phaseSelector)>(&MainRenderStage::GetSecondCullPass2SecondMainPass); },
 		[this](unsigned long rangeBegin, unsigned long rangeEnd, const RenderPasses::RenderPass &renderPass) { return bind(&MainRenderStage::CullPassRange, shared_from_this(), _1, rangeBegin, rangeEnd, move(renderPass), true); });
 }
 
@@ -583,14 +877,39 @@ auto Impl::World::MainRenderStage::GetSecondMainPassRange(unsigned int &length)
 	using namespace placeholders;
 	RenderPasses::PassROPBinding<RenderPasses::StageRTBinding> RTBinding{ stageRTBinding, false, true };
 	return IterateRenderPass(length, renderStreams[1].size(), &RTBinding, { stageZBinding, false, true }, stageOutput,
-		[] { phaseSelector = static_cast<decltype(phaseSelector)>(&MainRenderStage::GetStagePost); },
+		[this] { phaseSelector = static_cast<decltype(phaseSelector)>(&MainRenderStage::GetStagePost); },
 		[this](unsigned long rangeBegin, unsigned long rangeEnd, const RenderPasses::RenderPass &renderPass) { return bind(&MainRenderStage::MainPassRange, shared_from_this(), _1, rangeBegin, rangeEnd, move(renderPass), true); });
 }
 
+auto Impl::World::MainRenderStage::GetGPUFirstMainPassRange(unsigned int &length) const -> RenderPipeline::PipelineItem
+{
+	using namespace placeholders;
+	RenderPasses::PassROPBinding<RenderPasses::StageRTBinding> RTBinding{ stageRTBinding, true, false };
+	return IterateRenderPass(length, GPUCullingScene->GetBuckets().size(), &RTBinding, { stageZBinding, true, false }, stageOutput,
+		[this] { phaseSelector = static_cast<decltype(phaseSelector)>(&MainRenderStage::GetGPUFirstMainPass2SecondCullPass); },
+		[this](unsigned long rangeBegin, unsigned long rangeEnd, const RenderPasses::RenderPass &renderPass) { return bind(&MainRenderStage::GPUMainPassRange, shared_from_this(), _1, rangeBegin, rangeEnd, move(renderPass)); });
+}
+
+auto Impl::World::MainRenderStage::GetGPUFirstMainPass2SecondCullPass(unsigned int &) const -> RenderPipeline::PipelineItem
+{
+	using namespace placeholders;
+	phaseSelector = static_cast<decltype(phaseSelector)>(&MainRenderStage::GetGPUSecondMainPassRange);
+	return RenderPipeline::PipelineItem{ bind(&MainRenderStage::GPUSecondCullPass, shared_from_this(), _1) };
+}
+
+auto Impl::World::MainRenderStage::GetGPUSecondMainPassRange(unsigned int &length) const -> RenderPipeline::PipelineItem
+{
+	using namespace placeholders;
+	RenderPasses::PassROPBinding<RenderPasses::StageRTBinding> RTBinding{ stageRTBinding, false, true };
+	return IterateRenderPass(length, GPUCullingScene->GetBuckets().size(), &RTBinding, { stageZBinding, false, true }, stageOutput,
+		[this] { phaseSelector = static_cast<decltype(phaseSelector)>(&MainRenderStage::GetStagePost); },
+		[this](unsigned long rangeBegin, unsigned long rangeEnd, const RenderPasses::RenderPass &renderPass) { return bind(&MainRenderStage::GPUMainPassRange, shared_from_this(), _1, rangeBegin, rangeEnd, move(renderPass)); });
+}
+
 auto Impl::World::MainRenderStage::GetStagePost(unsigned int &) const -> RenderPipeline::PipelineItem
 {
 	using namespace placeholders;
-	RenderPipeline::TerminateStageTraverse();
+	FinishTraverse();
 	return RenderPipeline::PipelineItem{ bind(&MainRenderStage::StagePost, shared_from_this(), _1) };
 }
 
@@ -604,14 +923,14 @@ auto Impl::World::MainRenderStage::GetStagePost(unsigned int &) const -> RenderP
 //auto Impl::World::MainRenderStage::GetMainPassRange(unsigned int &length) const -> RenderPipeline::PipelineItem
 //{
 //	using namespace placeholders;
-//	return IterateRenderPass(length, renderStream.size(), [] { RenderPipeline::TerminateStageTraverse();/*phaseSelector = &MainRenderStage::GetMainPassPost;*/ },
+//	return IterateRenderPass(length, renderStream.size(), [this] { FinishTraverse();/*phaseSelector = &MainRenderStage::GetMainPassPost;*/ },
 //		[this](unsigned long rangeBegin, unsigned long rangeEnd) { return bind(&MainRenderStage::MainPassRange, shared_from_this(), _1, rangeBegin, rangeEnd); });
 //}
 
 //auto Impl::World::MainRenderStage::GetMainPassPost(unsigned int &) const -> RenderPipeline::PipelineItem
 //{
 //	using namespace placeholders;
-//	RenderPipeline::TerminateStageTraverse();
+//	FinishTraverse();
 //	return bind(&MainRenderStage::MainPassPost, shared_from_this(), _1);
 //}
 
@@ -647,7 +966,9 @@ auto Impl::World::MainRenderStage::Build(const float4x4 &frustumXform, const flo
 	auto occlusionProvider = OcclusionCulling::QueryBatchBase::npos;
 	unsigned long int AABBCount = 0;
 
-	if (parent->bvh)
+	if (GPUCullingScene)
+		GPUCullXform = frustumXform;
+	else if (parent->bvh)
 	{
 		// schedule
 		parent->bvhView.Schedule<false>(*GPU_AABB_allocator, FrustumCuller<3>(frustumXform), frustumXform, &viewXform);
@@ -656,7 +977,7 @@ auto Impl::World::MainRenderStage::Build(const float4x4 &frustumXform, const flo
 		{
 			using namespace placeholders;
 
-			parent->bvhView.Issue(bind(&MainRenderStage::IssueOcclusion, this, _1, ref(AABBCount)), bind(&MainRenderStage::IssueNodeObjects, this, _1, _2, _3, _4), occlusionProvider);
+			parent->bvhView.Issue(bind(&MainRenderStage::IssueOcclusion, this, _1, ref(AABBCount)), bind(&MainRenderStage::IssueNodeObjects, this, _1, _2, _3, _4, _5), occlusionProvider);
 		}
 	}
 
@@ -666,6 +987,11 @@ auto Impl::World::MainRenderStage::Build(const float4x4 &frustumXform, const flo
 	queryPassesPromise.set_value(queryPasses);
 	UpdateCaches();
 
+	// after caches update so that stream reservations account for unmerged instances
+	for (auto &renderStream : renderStreams)
+		MergeInstances(renderStream);
+	stateChangesPromise.set_value(SortRenderStreams());
+
 	return shared_from_this();
 }
 
@@ -689,9 +1015,11 @@ Impl::World::MainRenderStage::MainRenderStage(shared_ptr<const Renderer::World>
 	stageZPrecullBinding(MakeZPrecullBinding(viewCtx, ROPTargets)),
 	stageZBinding(ROPTargets, D3D12_CLEAR_FLAG_DEPTH | D3D12_CLEAR_FLAG_STENCIL, { 1.f, UINT8_MAX }, true/*preserve for copy to Z history*/, false),
 	stageOutput(ROPTargets),
-	queryPasses(allocate_shared<OcclusionQueryPasses>(polymorphic_allocator<OcclusionQueryPasses>(&globalTransientRAM)))	// or do this in 'Build()' ?
+	queryPasses(allocate_shared<OcclusionQueryPasses>(polymorphic_allocator<OcclusionQueryPasses>(&globalTransientRAM))),	// or do this in 'Build()' ?
+	GPUCullingScene(this->parent->GPUCullingScene)
 {
 	stageExchangeResult = queryPassesPromise.get_future();
+	viewCtx.renderStreamsStateChanges = stateChangesPromise.get_future().share();
 }
 
 auto Impl::World::MainRenderStage::MainRenderStage::Schedule(shared_ptr<const Renderer::World> parent, WorldViewContext &viewCtx, const float4x4 &frustumXform, const float4x3 &viewXform,
@@ -706,6 +1034,7 @@ auto Impl::World::MainRenderStage::MainRenderStage::Schedule(shared_ptr<const Re
 inline void Impl::World::MainRenderStage::OnFrameFinish()
 {
 	GPU_AABB_allocator->OnFrameFinish();
+	instancesCB_allocator->OnFrameFinish();
 }
 
 #pragma region visualize occlusion pass
@@ -794,14 +1123,12 @@ auto Impl::World::DebugRenderStage::CreateAABB_PSOs() -> decltype(AABB_PSOs)
 
 	decltype(AABB_PSOs) result;
 	
-	CheckHR(device->CreateGraphicsPipelineState(&PSO_desc, IID_PPV_ARGS(result[0].GetAddressOf())));
-	NameObject(result[0].Get(), L"world 3D objects hidden AABB visualization PSO");
+	result[0] = globalPSOLibrary->Compile(PSO_desc, L"world 3D objects hidden AABB visualization PSO");
 
 	// patch hidden -> visible
 	PSO_desc.DepthStencilState.DepthFunc = D3D12_COMPARISON_FUNC_LESS;
 
-	CheckHR(device->CreateGraphicsPipelineState(&PSO_desc, IID_PPV_ARGS(result[1].GetAddressOf())));
-	NameObject(result[1].Get(), L"world 3D objects visible AABB visualization PSO");
+	result[1] = globalPSOLibrary->Compile(PSO_desc, L"world 3D objects visible AABB visualization PSO");
 
 	return result;
 }
@@ -884,7 +1211,7 @@ auto Impl::World::DebugRenderStage::GetHiddenPassRange(unsigned int &length) con
 	using namespace placeholders;
 	RenderPasses::PassROPBinding<RenderPasses::StageRTBinding> RTBinding{ stageRTBinding, true, false };
 	return IterateRenderPass(length, queryPasses->queryStream.size(), &RTBinding, { stageZBinding, true, false }, stageOutput,
-		[] { phaseSelector = static_cast<decltype(phaseSelector)>(&DebugRenderStage::GetVisiblePassRange); },
+		[this] { phaseSelector = static_cast<decltype(phaseSelector)>(&DebugRenderStage::GetVisiblePassRange); },
 		[this](unsigned long rangeBegin, unsigned long rangeEnd, const RenderPasses::RenderPass &renderPass) { return bind(&DebugRenderStage::AABBPassRange, shared_from_this(), _1, rangeBegin, rangeEnd, move(renderPass), false); });
 }
 
@@ -893,14 +1220,14 @@ auto Impl::World::DebugRenderStage::GetVisiblePassRange(unsigned int &length) co
 	using namespace placeholders;
 	RenderPasses::PassROPBinding<RenderPasses::StageRTBinding> RTBinding{ stageRTBinding, false, true };
 	return IterateRenderPass(length, queryPasses->queryStream.size(), &RTBinding, { stageZBinding, false, true }, stageOutput,
-		[] { phaseSelector = static_cast<decltype(phaseSelector)>(&DebugRenderStage::GetAABBPassPost); },
+		[this] { phaseSelector = static_cast<decltype(phaseSelector)>(&DebugRenderStage::GetAABBPassPost); },
 		[this](unsigned long rangeBegin, unsigned long rangeEnd, const RenderPasses::RenderPass &renderPass) { return bind(&DebugRenderStage::AABBPassRange, shared_from_this(), _1, rangeBegin, rangeEnd, move(renderPass), true); });
 }
 
 auto Impl::World::DebugRenderStage::GetAABBPassPost(unsigned int &) const -> RenderPipeline::PipelineItem
 {
 	using namespace placeholders;
-	RenderPipeline::TerminateStageTraverse();
+	FinishTraverse();
 	return RenderPipeline::PipelineItem{ bind(&DebugRenderStage::AABBPassPost, shared_from_this(), _1) };
 }
 
@@ -936,6 +1263,7 @@ ComPtr<ID3D12Resource> Impl::World::CreateGlobalGPUBuffer()
 		NULL,	// clear value
 		IID_PPV_ARGS(buffer.GetAddressOf())));
 	NameObject(buffer.Get(), L"global GPU buffer");
+	MemoryAccounting::Track(buffer.Get(), MemoryAccounting::Category::ConstantBuffers);
 	
 	// fill AABB vis colors and box IB
 	{
@@ -953,7 +1281,7 @@ ComPtr<ID3D12Resource> Impl::World::CreateGlobalGPUBuffer()
 
 		memcpy(const_cast<remove_volatile_t<decltype(CPU_ptr->boxIB)> &>(CPU_ptr->boxIB), CPU_ptr->boxIBInitData, sizeof CPU_ptr->boxIB);
 		
-		range.End += sizeof CPU_ptr->aabbVisColorsCB + sizeof CPU_ptr->boxIB;
+		range.End = GlobalGPUBufferData::BoxIB_offset() + sizeof CPU_ptr->boxIB;
 		buffer->Unmap(0, &range);
 	}
 
@@ -989,13 +1317,13 @@ inline unsigned long int Impl::World::BVHObject::GetTriCount() const noexcept
 
 void Impl::World::InstanceDeleter::operator()(const Renderer::Instance *instanceToRemove) const
 {
-	instanceToRemove->GetWorld()->InvalidateStaticObjects();
-	instanceToRemove->GetWorld()->staticObjects.erase(instanceLocation);
+	instanceToRemove->GetWorld()->RemoveStaticObject(instanceLocation);
 }
 
+// instance data buffer kept, only BVH-derived state rebuilt
 void Impl::World::InvalidateStaticObjects()
 {
-	staticObjectsCB.Reset();
+	GPUCullingScene.reset();
 	bvh.Reset();
 	bvhView.Reset();
 }
@@ -1020,6 +1348,13 @@ void Impl::World::Render(WorldViewContext &viewCtx, const float (&viewXform)[4][
 
 	FlushUpdates();
 
+	// choose culling path for this frame, scene built on demand and dropped when disabled
+	extern atomic<bool> enableGPUCulling;
+	if (!enableGPUCulling.load(memory_order_relaxed))
+		GPUCullingScene.reset();
+	else if (!GPUCullingScene && !staticObjects.empty())
+		BuildGPUCullingScene();
+
 	const float4x3 terrainTransform(terrainXform), viewTransform(viewXform),
 		worldViewTransform = mul(float4x4(terrainTransform[0], 0.f, terrainTransform[1], 0.f, terrainTransform[2], 0.f, terrainTransform[3], 1.f), viewTransform);
 	const float4x4 frustumTransform = mul(float4x4(worldViewTransform[0], 0.f, worldViewTransform[1], 0.f, worldViewTransform[2], 0.f, worldViewTransform[3], 1.f), float4x4(projXform));
@@ -1037,7 +1372,7 @@ void Impl::World::Render(WorldViewContext &viewCtx, const float (&viewXform)[4][
 		CopyMatrix2CB(terrainXform, curFrameCB_region.terrainXform);
 		const float3 sunDir = Sun::Dir(this->sunDir.zenith, this->sunDir.azimuth);
 		curFrameCB_region.sun.dir = reinterpret_cast<const float (&)[3]>(mul(sunDir, viewTransform));
-		curFrameCB_region.sun.irradiance = reinterpret_cast<const float (&)[3]>(Sun::Irradiance(this->sunDir.zenith, sunDir.z));
+		curFrameCB_region.sun.irradiance = reinterpret_cast<const float (&)[3]>(Sun::Irradiance(this->sunDir.zenith));
 #if !PERSISTENT_MAPS
 		range.End += sizeof(GlobalGPUBufferData::PerFrameData);
 		globalGPUBuffer->Unmap(0, &range);
@@ -1098,13 +1433,39 @@ shared_ptr<Renderer::TerrainVectorLayer> Impl::World::AddTerrainVectorLayer(shar
 	return { &*inserted, [inserted](::TerrainVectorLayer *layerToRemove) { layerToRemove->world->terrainVectorLayers.erase(inserted); } };
 }
 
+unsigned int Impl::World::AllocateStaticObjectSlot()
+{
+	// recycle slots no longer referenced by GPU
+	for (const UINT64 completedFrameID = globalFrameVersioning->GetCompletedFrameID(); !retiredStaticObjectSlots.empty() && retiredStaticObjectSlots.front().first <= completedFrameID; retiredStaticObjectSlots.pop_front())
+		freeStaticObjectSlots.push_back(retiredStaticObjectSlots.front().second);
+
+	if (freeStaticObjectSlots.empty())
+		return staticObjectSlotCount++;
+	const unsigned int slot = freeStaticObjectSlots.back();
+	freeStaticObjectSlots.pop_back();
+	return slot;
+}
+
+void Impl::World::RemoveStaticObject(decltype(staticObjects)::const_iterator location)
+{
+	InvalidateStaticObjects();
+	// frames in flight can still read the slot
+	retiredStaticObjectSlots.emplace_back(globalFrameVersioning->GetCurFrameID(), location->CB_slot);
+	erase(pendingStaticObjectUploads, &*location);
+	staticObjects.erase(location);
+}
+
 auto Impl::World::AddStaticObject(Renderer::Object3D object, const float (&xform)[4][3], const AABB<3> &worldAABB) -> InstancePtr
 {
 	if (!object)
 		throw logic_error("Attempt to add empty static object");
 	InvalidateStaticObjects();
-	const auto &inserted = staticObjects.emplace_back(shared_from_this(), move(object), xform, worldAABB);
-	return { &inserted, InstanceDeleter{ prev(staticObjects.cend()) } };
+	const unsigned int slot = AllocateStaticObjectSlot();
+	auto &inserted = staticObjects.emplace_back(shared_from_this(), move(object), xform, worldAABB);
+	inserted.CB_slot = slot;
+	InstancePtr instance{ &inserted, InstanceDeleter{ prev(staticObjects.cend()) } };
+	pendingStaticObjectUploads.push_back(&inserted);
+	return instance;
 }
 
 void Impl::World::FlushUpdates() const
@@ -1115,37 +1476,157 @@ void Impl::World::FlushUpdates() const
 		if (!bvh)
 		{
 			bvh = { staticObjects.cbegin(), staticObjects.cend(), Hierarchy::SplitTechnique::MEAN };
-			bvhView = { bvh };
+			bvhView = decltype(bvhView)(bvh, true);
 		}
 
-		// recreate static objects CB
-		if (!staticObjectsCB)
+		/*
+			static objects CB placed in VRAM and updated via DMA engine, sys RAM fallback if DMA queue unavailable
+			new instances get their slots uploaded, existing slots untouched
+			buffers are simultaneous access capable so copy queue can write new slots while GFX queue reads others
+		*/
+		extern ComPtr<ID3D12CommandQueue> dmaQueue;
+
+		// grow geometrically, old CB retired by TrackedResource, all live instances reuploaded
+		const UINT64 capacity = staticObjectsCB ? staticObjectsCB->GetDesc().Width / sizeof(StaticObjectData) : 0;
+		if (capacity < staticObjectSlotCount)
 		{
-			// create
+			const UINT64 newCapacity = max<UINT64>(staticObjectSlotCount, capacity * 2);
 			CheckHR(device->CreateCommittedResource(
-				&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
+				&CD3DX12_HEAP_PROPERTIES(dmaQueue ? D3D12_HEAP_TYPE_DEFAULT : D3D12_HEAP_TYPE_UPLOAD),
 				D3D12_HEAP_FLAG_NONE,
-				&CD3DX12_RESOURCE_DESC::Buffer(sizeof(StaticObjectData) * staticObjects.size()/*, D3D12_RESOURCE_FLAG_DENY_SHADER_RESOURCE*/),
-				D3D12_RESOURCE_STATE_GENERIC_READ,
+				&CD3DX12_RESOURCE_DESC::Buffer(sizeof(StaticObjectData) * newCapacity/*, D3D12_RESOURCE_FLAG_DENY_SHADER_RESOURCE*/),
+				dmaQueue ? D3D12_RESOURCE_STATE_COMMON : D3D12_RESOURCE_STATE_GENERIC_READ,
 				NULL,	// clear value
-				IID_PPV_ARGS(staticObjectsCB.GetAddressOf())));
-			NameObjectF(staticObjectsCB.Get(), L"static objects CB for world %p (%zu instances)", static_cast<const ::World *>(this), staticObjects.size());
+				IID_PPV_ARGS(staticObjectsCB.ReleaseAndGetAddressOf())));
+			NameObjectF(staticObjectsCB.Get(), L"static objects CB for world %p (%llu slots)", static_cast<const ::World *>(this), newCapacity);
+			MemoryAccounting::Track(staticObjectsCB.Get(), MemoryAccounting::Category::ConstantBuffers);
 
-			// fill
+			pendingStaticObjectUploads.clear();
+			transform(staticObjects.begin(), staticObjects.end(), back_inserter(pendingStaticObjectUploads), [](Renderer::Instance &instance) { return &instance; });
+			GPUCullingScene.reset();	// holds CB GPU VAs
+		}
+
+		// fill new slots
+		if (!pendingStaticObjectUploads.empty())
+		{
 			static_assert(is_standard_layout_v<StaticObjectData>);
-			volatile StaticObjectData *mapped;
-			CheckHR(staticObjectsCB->Map(0, &CD3DX12_RANGE(0, 0), const_cast<void **>(reinterpret_cast<volatile void **>(&mapped))));
-			// TODO: use C++20 initializer in range-based for
-			auto CB_GPU_ptr = staticObjectsCB->GetGPUVirtualAddress();
-			for (auto &instance : staticObjects)
+			const auto CB_GPU_base = staticObjectsCB->GetGPUVirtualAddress();
+			sort(pendingStaticObjectUploads.begin(), pendingStaticObjectUploads.end(), [](const Renderer::Instance *left, const Renderer::Instance *right) noexcept { return left->CB_slot < right->CB_slot; });
+
+			volatile StaticObjectData *mapped = nullptr;
+			if (!dmaQueue)
+				CheckHR(staticObjectsCB->Map(0, &CD3DX12_RANGE(0, 0), const_cast<void **>(reinterpret_cast<volatile void **>(&mapped))));
+
+			// coalesce adjacent slots into single copy
+			vector<StaticObjectData> staging;
+			for (auto runBegin = pendingStaticObjectUploads.cbegin(); runBegin != pendingStaticObjectUploads.cend();)
 			{
-				CopyMatrix2CB(instance.GetWorldXform(), mapped++->worldXform);
-				instance.CB_GPU_ptr = CB_GPU_ptr;
-				CB_GPU_ptr += sizeof(StaticObjectData);
+				auto runEnd = next(runBegin);
+				while (runEnd != pendingStaticObjectUploads.cend() && (*runEnd)->CB_slot == (*prev(runEnd))->CB_slot + 1)
+					++runEnd;
+
+				const unsigned int firstSlot = (*runBegin)->CB_slot;
+				volatile StaticObjectData *dst;
+				if (mapped)
+					dst = mapped + firstSlot;
+				else
+				{
+					staging.resize(runEnd - runBegin);
+					dst = staging.data();
+				}
+				for (; runBegin != runEnd; ++runBegin)
+				{
+					auto &instance = **runBegin;
+					CopyMatrix2CB(instance.GetWorldXform(), dst++->worldXform);
+					instance.CB_GPU_ptr = CB_GPU_base + instance.CB_slot * sizeof(StaticObjectData);
+				}
+
+				if (!mapped)
+					DMA::Upload2VRAM(staticObjectsCB, firstSlot * sizeof(StaticObjectData), as_bytes(span(staging)), L"static objects CB");
 			}
-			staticObjectsCB->Unmap(0, NULL);
+
+			if (mapped)
+				staticObjectsCB->Unmap(0, NULL);
+			else
+				DMA::TrackUsage(staticObjectsCB.Get());	// GFX queue waits for the uploads in 'DMA::Sync()'
+			pendingStaticObjectUploads.clear();
+		}
+	}
+}
+
+void Impl::World::EnableGPUCulling(bool enable) noexcept
+{
+	extern atomic<bool> enableGPUCulling;
+	enableGPUCulling.store(enable, memory_order_relaxed);
+}
+
+void Impl::World::EnableGPUCullingValidation(bool enable) noexcept
+{
+	extern atomic<bool> validateGPUCulling;
+	validateGPUCulling.store(enable, memory_order_relaxed);
+}
+
+// objects follow BVH traversal order, draws and indirect args are grouped per 3D object
+void Impl::World::BuildGPUCullingScene() const
+{
+	const auto ExtractBox = [](const AABB<3> &aabb, float (&center)[3], float (&extents)[3])
+	{
+		const auto aabbCenter = aabb.Center(), aabbExtents = aabb.Size() * .5f;
+		for (unsigned i = 0; i < 3; i++)
+		{
+			center[i] = aabbCenter[i];
+			extents[i] = aabbExtents[i];
+		}
+	};
+
+	vector<GPUCulling::Node> nodes;
+	vector<GPUCulling::Object> objects;
+	objects.reserve(staticObjects.size());
+	vector<pair<const Renderer::Instance *, vector<GPUCulling::uint>>> groups;	// representative instance, object idxs
+	unordered_map<const void *, size_t> geometryGroups;
+	const auto flattenNode = [&](const decltype(bvh)::Node &node)
+	{
+		const GPUCulling::uint nodeIdx = nodes.size();
+		auto &flatNode = nodes.emplace_back();
+		ExtractBox(node.GetAABB(), flatNode.center, flatNode.extents);
+		const auto [objBegin, objEnd] = node.GetExclusiveObjectsRange();
+		for_each(objBegin, objEnd, [&](const Renderer::Instance *instance)
+		{
+			auto &object = objects.emplace_back();
+			ExtractBox(instance->GetWorldAABB(), object.center, object.extents);
+			object.node = nodeIdx;
+			object.instanceCB[0] = instance->CB_GPU_ptr;
+			object.instanceCB[1] = instance->CB_GPU_ptr >> 32;
+			const auto [group, inserted] = geometryGroups.try_emplace(instance->GetGeometryID(), groups.size());
+			if (inserted)
+				groups.emplace_back(instance, vector<GPUCulling::uint>{});
+			groups[group->second].second.push_back(objects.size() - 1);
+		});
+		return true;
+	};
+	bvh.Traverse(flattenNode);
+
+	vector<GPUCulling::Draw> draws;
+	vector<GPUCulling::Scene::Bucket> buckets;
+	buckets.reserve(groups.size());
+	GPUCulling::uint cmdSlotCount = 0;
+	for (const auto &[instance, objectIdxs] : groups)
+	{
+		const GPUCulling::uint maxInstanceCount = objectIdxs.size(), drawsBegin = draws.size();
+		buckets.push_back({ instance, maxInstanceCount, UINT64(cmdSlotCount) * GPUCulling::indirectCmdSize, drawsBegin * sizeof(GPUCulling::uint) });
+		for (unsigned short int subobjIdx = 0; subobjIdx < instance->GetObject3D().GetSubobjectCount(); subobjIdx++, cmdSlotCount += maxInstanceCount)
+		{
+			const auto drawArgs = instance->GetDrawArgs(subobjIdx);
+			draws.push_back({ drawArgs.IndexCountPerInstance, drawArgs.StartIndexLocation, drawArgs.BaseVertexLocation, cmdSlotCount });
+		}
+		for (const auto objectIdx : objectIdxs)
+		{
+			objects[objectIdx].drawsBegin = drawsBegin;
+			objects[objectIdx].drawsEnd = draws.size();
 		}
 	}
+
+	GPUCullingScene = make_shared<const GPUCulling::Scene>(nodes, objects, draws, move(buckets), cmdSlotCount);
 }
 
 auto Impl::World::ScheduleRenderStage(WorldViewContext &viewCtx, const float4x4 &frustumTransform, const float4x3 &worldViewTransform, UINT64 tonemapParamsGPUAddress, const RenderPasses::PipelineROPTargets &ROPTargets) const -> StageExchange